@@ -0,0 +1,359 @@
+#include "BenchmarkRuns.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include "../GLM/glm/gtc/matrix_transform.hpp"
+#include "../GLM/glm/gtc/constants.hpp"
+#include "../Loaders/ShaderVariants.h"
+
+BenchmarkRun::BenchmarkRun()
+{
+    mesh_path = "../ObjectFiles/heracles.obj";
+    gouraud = GL_FALSE;
+    uber_shader = GL_FALSE;
+    toggles = DEFAULT_TOGGLES;
+    frames = 500;
+    instances = 0;
+    spread = 1;
+    culling = true;
+    occlusion = false;
+    occlusion_budget_ms = 1.0;
+    gpu_culling = false;
+    parts = 1;
+    multi_draw = true;
+    streaming = true;
+    threads = 0;
+}
+
+BenchmarkResult::BenchmarkResult(const BenchmarkRun& run, long long triangles) : run(run), triangles(triangles),
+                                                                           threads(1),
+                                                                           frame_ms(run.frames), gl_calls(0),
+                                                                           gl_calls_skipped(0), draw_calls(0),
+                                                                           submit_ms(0), fence_waits(0),
+                                                                           drawn_instances(0), drawn_triangles(0),
+                                                                           cull_ms(0), packets_ms(0),
+                                                                           occluded_instances(0),
+                                                                           occluders(0), occlusion_ms(0),
+                                                                           occlusion_over_budget_frames(0),
+                                                                           gpu_cull_ms(0), gpu_cull_frames(0)
+{
+}
+
+/*
+ * This reads a list of toggles joined with '+' (i.e. "rgb+light").
+ * @return A boolean specifying if every toggle was known or not.
+ */
+static bool ParseToggles(const std::string& value, unsigned int& out_toggles)
+{
+    out_toggles = 0;
+
+    std::stringstream stream(value);
+    std::string token;
+    while(std::getline(stream, token, '+'))
+    {
+        if(token == "light")
+            out_toggles |= TOGGLE_LIGHT_ON;
+
+        else if(token == "normal")
+            out_toggles |= TOGGLE_NORMAL_AS_COLOR;
+
+        else if(token == "gray")
+            out_toggles |= TOGGLE_GRAY_SCALE;
+
+        else if(token == "none")
+            continue;
+
+        else
+        {
+            //anything else is a set of color channels
+            for(int i = 0; i < token.size(); i++)
+            {
+                if(token[i] == 'r')
+                    out_toggles |= TOGGLE_RED_CHANNEL;
+
+                else if(token[i] == 'g')
+                    out_toggles |= TOGGLE_GREEN_CHANNEL;
+
+                else if(token[i] == 'b')
+                    out_toggles |= TOGGLE_BLUE_CHANNEL;
+
+                else
+                    return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool ParseBenchmarkRuns(const char* spec, std::vector<BenchmarkRun>& out_runs)
+{
+    BenchmarkRun run;
+
+    //the ranges of instance and thread counts to sweep over (the same count twice when there is no range)
+    int first_instances = 0;
+    int last_instances = 0;
+    int first_threads = 0;
+    int last_threads = 0;
+
+    std::stringstream stream(spec);
+    std::string pair;
+    while(std::getline(stream, pair, ','))
+    {
+        size_t separator = pair.find('=');
+        if(separator == std::string::npos)
+        {
+            std::cout << "Expected key=value in the benchmark run \"" << spec << "\", got \"" << pair << "\"" << std::endl;
+            return false;
+        }
+
+        std::string key = pair.substr(0, separator);
+        std::string value = pair.substr(separator + 1);
+        bool valid = true;
+
+        if(key == "mesh")
+            run.mesh_path = value;
+
+        else if(key == "shading")
+        {
+            run.uber_shader = value.compare(0, 5, "uber-") == 0;
+            std::string model = run.uber_shader ? value.substr(5) : value;
+            run.gouraud = model == "gouraud";
+            valid = model == "gouraud" || model == "phong";
+        }
+
+        else if(key == "toggles")
+            valid = ParseToggles(value, run.toggles);
+
+        else if(key == "frames")
+        {
+            run.frames = atoi(value.c_str());
+            valid = run.frames > 0;
+        }
+
+        else if(key == "instances")
+        {
+            size_t dash = value.find('-');
+            first_instances = atoi(value.substr(0, dash).c_str());
+            last_instances = dash == std::string::npos ? first_instances : atoi(value.substr(dash + 1).c_str());
+            valid = first_instances >= 0 && last_instances >= first_instances;
+        }
+
+        else if(key == "spread")
+        {
+            run.spread = atof(value.c_str());
+            valid = run.spread > 0;
+        }
+
+        else if(key == "cull")
+        {
+            run.culling = value == "on";
+            valid = value == "on" || value == "off";
+        }
+
+        else if(key == "occlusion")
+        {
+            run.occlusion = value == "on";
+            valid = value == "on" || value == "off";
+        }
+
+        else if(key == "budget")
+        {
+            run.occlusion_budget_ms = atof(value.c_str());
+            valid = run.occlusion_budget_ms > 0;
+        }
+
+        else if(key == "gpu")
+        {
+            run.gpu_culling = value == "on";
+            valid = value == "on" || value == "off";
+        }
+
+        else if(key == "parts")
+        {
+            run.parts = atoi(value.c_str());
+            valid = run.parts > 0;
+        }
+
+        else if(key == "mdi")
+        {
+            run.multi_draw = value == "on";
+            valid = value == "on" || value == "off";
+        }
+
+        else if(key == "stream")
+        {
+            run.streaming = value == "on";
+            valid = value == "on" || value == "off";
+        }
+
+        else if(key == "threads")
+        {
+            size_t dash = value.find('-');
+            first_threads = atoi(value.substr(0, dash).c_str());
+            last_threads = dash == std::string::npos ? first_threads : atoi(value.substr(dash + 1).c_str());
+            valid = first_threads > 0 && last_threads >= first_threads;
+        }
+
+        else
+            valid = false;
+
+        if(!valid)
+        {
+            std::cout << "Invalid " << key << " in the benchmark run \"" << spec << "\": " << value << std::endl;
+            return false;
+        }
+    }
+
+    //a sweep of instances goes up by powers of 10 from the start of the range, and a sweep of threads by powers of 2,
+    //and both always end with the end of their range
+    std::vector<int> instance_counts(1, first_instances);
+    for(long long instances = std::max(first_instances, 1) * 10LL; instance_counts.back() != last_instances;
+        instances *= 10)
+        instance_counts.push_back((int)std::min(instances, (long long)last_instances));
+
+    std::vector<int> thread_counts(1, first_threads);
+    for(int threads = first_threads * 2; thread_counts.back() != last_threads; threads *= 2)
+        thread_counts.push_back(std::min(threads, last_threads));
+
+    for(int i = 0; i < instance_counts.size(); i++)
+    {
+        for(int j = 0; j < thread_counts.size(); j++)
+        {
+            run.instances = instance_counts[i];
+            run.threads = thread_counts[j];
+            out_runs.push_back(run);
+        }
+    }
+
+    return true;
+}
+
+std::string DescribeShading(const BenchmarkRun& run)
+{
+    std::string model = run.gouraud ? "gouraud" : "phong";
+    return run.uber_shader ? "uber-" + model : model;
+}
+
+void ApplyCameraPath(RenderState& state, int frame, int frame_count)
+{
+    float t = (float)frame / frame_count;
+    float angle = t * glm::two_pi<float>();
+
+    //the camera starts where the viewer normally starts it (40 units in front of the object), comes in to 25 units
+    //half way through the orbit, and bobs up and down twice
+    float distance = 40.0f - 15.0f * glm::sin(angle * 0.5f);
+    float height = 10.0f * glm::sin(angle * 2.0f);
+    glm::vec3 eye(distance * glm::sin(angle), height, -distance * glm::cos(angle));
+    SetTransformMatrix(state.view, glm::lookAt(eye, glm::vec3(0, 0, 0), glm::vec3(0, 1, 0)));
+
+    //the object spins twice about its vertical axis, in the other direction
+    state.model = Transform();
+    RotateTransform(state.model, -2.0f * angle, glm::vec3(0, 1, 0));
+
+    state.dirty |= DIRTY_MODEL | DIRTY_VIEW;
+}
+
+/*
+ * This returns the total time of the frames of a run, in seconds.
+ */
+static double TotalSeconds(const BenchmarkResult& result)
+{
+    return GetAverage(result.frame_ms) * result.frame_ms.count / 1000.0;
+}
+
+void PrintBenchmarkResult(const BenchmarkResult& result)
+{
+    const BenchmarkRun& run = result.run;
+    int frames = result.frame_ms.count;
+
+    std::cout << run.mesh_path << " (" << result.triangles << " triangles";
+    if(run.instances > 0)
+        std::cout << " in " << run.instances << " instances";
+
+    std::cout << "), " << DescribeShading(run) << " [" << DescribeToggles(run.toggles) << "], " << frames << " frames:"
+              << std::endl;
+    std::cout << "  frame time average " << GetAverage(result.frame_ms) << " ms, p50 "
+              << GetPercentile(result.frame_ms, 50) << " ms, p95 " << GetPercentile(result.frame_ms, 95) << " ms, p99 "
+              << GetPercentile(result.frame_ms, 99) << " ms, max " << GetPercentile(result.frame_ms, 100) << " ms"
+              << std::endl;
+    std::cout << "  " << (double)result.drawn_triangles / TotalSeconds(result) << " triangles/s ("
+              << (double)result.drawn_triangles / frames << " drawn per frame), "
+              << (double)result.gl_calls / frames << " OpenGL calls per frame ("
+              << (double)result.gl_calls_skipped / frames << " redundant calls skipped)" << std::endl;
+    std::cout << "  " << run.parts << (run.parts == 1 ? " mesh" : " meshes") << " drawn with "
+              << (double)result.draw_calls / frames << " draw calls per frame ("
+              << (run.multi_draw ? "multi-draw" : "one per mesh") << "), submitted in " << result.submit_ms / frames
+              << " ms" << std::endl;
+
+    if(run.streaming)
+        std::cout << "  streamed through a persistently mapped buffer, with " << result.fence_waits
+                  << " fence waits" << std::endl;
+
+    if(run.instances > 0)
+    {
+        std::cout << "  " << (double)result.drawn_instances / frames << " of " << run.instances
+                  << " instances drawn per frame";
+        if(run.gpu_culling)
+            std::cout << ", culled on the GPU in "
+                      << (result.gpu_cull_frames > 0 ? result.gpu_cull_ms / result.gpu_cull_frames : 0) << " ms";
+
+        else if(run.culling)
+            std::cout << ", culled in " << result.cull_ms / frames << " ms";
+
+        if(!run.gpu_culling && (run.culling || run.occlusion))
+            std::cout << ", draws built on " << result.threads << " threads in " << result.packets_ms / frames << " ms";
+
+        std::cout << std::endl;
+    }
+
+    if(run.instances > 0 && run.occlusion && !run.gpu_culling)
+        std::cout << "  " << (double)result.occluded_instances / frames << " instances rejected as hidden behind "
+                  << (double)result.occluders / frames << " occluders per frame, in " << result.occlusion_ms / frames
+                  << " ms (" << result.occlusion_over_budget_frames << " frames over the " << run.occlusion_budget_ms
+                  << " ms budget)" << std::endl;
+}
+
+bool WriteBenchmarkResults(const char* file_path, const std::vector<BenchmarkResult>& results)
+{
+    std::ofstream out(file_path);
+    if(!out.is_open())
+    {
+        std::cout << "Could not open " << file_path << " to save the benchmark results" << std::endl;
+        return false;
+    }
+
+    out << "mesh,shading,toggles,instances,frames,triangles,average_ms,p50_ms,p95_ms,p99_ms,max_ms,triangles_per_second,"
+        << "gl_calls_per_frame,gl_calls_skipped_per_frame,spread,culling,drawn_instances_per_frame,cull_ms,"
+        << "occlusion,occluded_instances_per_frame,occluders_per_frame,occlusion_ms,occlusion_over_budget_frames,"
+        << "gpu_culling,gpu_cull_ms,parts,multi_draw,draw_calls_per_frame,submit_ms,stream,"
+        << "fence_waits,threads,packets_ms,drawn_triangles_per_frame" << std::endl;
+
+    for(int i = 0; i < results.size(); i++)
+    {
+        const BenchmarkResult& result = results[i];
+        int frames = result.frame_ms.count;
+
+        out << result.run.mesh_path << "," << DescribeShading(result.run) << "," << DescribeToggles(result.run.toggles)
+            << "," << result.run.instances << "," << frames << "," << result.triangles << "," << GetAverage(result.frame_ms) << ","
+            << GetPercentile(result.frame_ms, 50) << "," << GetPercentile(result.frame_ms, 95) << ","
+            << GetPercentile(result.frame_ms, 99) << "," << GetPercentile(result.frame_ms, 100) << ","
+            << (double)result.drawn_triangles / TotalSeconds(result) << ","
+            << (double)result.gl_calls / frames << "," << (double)result.gl_calls_skipped / frames << ","
+            << result.run.spread << "," << (result.run.culling ? "on" : "off") << ","
+            << (double)result.drawn_instances / frames << "," << result.cull_ms / frames << ","
+            << (result.run.occlusion ? "on" : "off") << "," << (double)result.occluded_instances / frames << ","
+            << (double)result.occluders / frames << "," << result.occlusion_ms / frames << ","
+            << result.occlusion_over_budget_frames << "," << (result.run.gpu_culling ? "on" : "off") << ","
+            << (result.gpu_cull_frames > 0 ? result.gpu_cull_ms / result.gpu_cull_frames : 0) << ","
+            << result.run.parts << "," << (result.run.multi_draw ? "on" : "off") << ","
+            << (double)result.draw_calls / frames << "," << result.submit_ms / frames << ","
+            << (result.run.streaming ? "on" : "off") << "," << result.fence_waits << "," << result.threads << ","
+            << result.packets_ms / frames << "," << (double)result.drawn_triangles / frames << std::endl;
+    }
+
+    return out.good();
+}
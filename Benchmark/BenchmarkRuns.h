@@ -0,0 +1,123 @@
+#ifndef COMP_371_A2_BENCHMARKRUNS_H
+#define COMP_371_A2_BENCHMARKRUNS_H
+
+#include <glew.h>
+#include <string>
+#include <vector>
+#include "../Rendering/RenderState.h"
+#include "../Stats/RollingStats.h"
+
+//this contains the definitions for the scripted benchmark mode of the viewer. Each run loads a mesh, picks an
+//illumination model and toggles, and then moves the camera and the object along a fixed path for a fixed number of
+//frames, so that the same run always renders the same frames. A run is described on the command line as a list of
+//key=value pairs, any of which can be left out:
+//
+//    mesh=../ObjectFiles/cube.obj,shading=gouraud,toggles=rgb+light,frames=500,instances=1000,spread=10,cull=off,occlusion=on,gpu=on,parts=100,mdi=off,stream=off,threads=1-8
+//
+//where shading is one of phong, gouraud, uber-phong or uber-gouraud, and toggles is made of r, g and b for the color
+//channels, and light, normal and gray, joined with '+' (or none). The object is drawn once, or as the passed number of
+//instances. A range of instance counts (i.e. instances=1-1000000) makes one run per power of 10 in the range, so that
+//the cost of instancing can be swept in a single command. The instances are laid out over spread copies of the object
+//across (1 by default), and culled against the view frustum unless cull is off. With occlusion on, the ones hidden
+//behind the nearest instances are left out as well, within a budget of budget milliseconds per frame (1 by default).
+//With gpu on, the instances are culled on the GPU instead (see GpuCulling.h), and cull and occlusion are ignored. The
+//mesh is split into parts meshes (1 by default), which are all drawn in a single call unless mdi is off, in which case
+//each of them gets its own draw call (see MeshPool.h). With stream off, the instances and the draw commands are
+//uploaded every frame rather than written into a persistently mapped buffer (see StreamBuffer.h). The instances are
+//culled and their draws built on threads threads (the number given on the command line by default, see ParallelFor.h,
+//and DrawPackets.h). A range of thread counts (i.e. threads=1-8) makes one run per power of 2 in the range, for each
+//instance count, so that the scaling with the cores can be measured in a single command.
+
+/*
+ * This describes one run of the benchmark.
+ */
+struct BenchmarkRun
+{
+    std::string mesh_path;
+    GLboolean gouraud;
+    GLboolean uber_shader;
+    unsigned int toggles; //ShaderToggle flags
+    int frames; //the number of frames that are measured (after the warm up frames)
+    int instances; //the number of instances drawn, or 0 to draw the object once without instancing
+    float spread; //how many copies of the object the instances are laid out over, across
+    bool culling; //whether the instances are culled against the view frustum
+    bool occlusion; //whether the instances hidden behind others are rejected (see OcclusionCulling.h)
+    double occlusion_budget_ms; //the time the occlusion culling may take per frame
+    bool gpu_culling; //whether the instances are culled on the GPU instead (see GpuCulling.h)
+    int parts; //the number of meshes the mesh is split into
+    bool multi_draw; //whether the meshes are all drawn in a single call (see MeshPool.h)
+    bool streaming; //whether the data of each frame is written into a persistently mapped buffer (see StreamBuffer.h)
+    int threads; //the number of threads the work of each frame is split across, or 0 to keep the current number
+
+    BenchmarkRun();
+};
+
+//the number of frames rendered before each run is measured, so that the shader programs are compiled and the driver
+//has settled
+const int BENCHMARK_WARMUP_FRAMES = 30;
+
+/*
+ * This holds the measurements of a run.
+ */
+struct BenchmarkResult
+{
+    BenchmarkRun run;
+    long long triangles; //the number of triangles of the scene per frame, before culling
+    int threads; //the number of threads the work of each frame was split across
+    RollingStats frame_ms;
+    long long gl_calls; //the number of OpenGL calls made over the whole run
+    long long gl_calls_skipped; //the number of redundant OpenGL calls that were skipped (see GLStateCache.h)
+    long long draw_calls; //the number of draw calls made over the whole run
+    double submit_ms; //the time the CPU spent submitting the draws over the whole run
+    int fence_waits; //the number of frames the CPU had to wait for the GPU to be done with the stream buffer
+    long long drawn_instances; //the number of instances drawn over the whole run (after culling)
+    long long drawn_triangles; //the number of triangles drawn over the whole run (after culling)
+    double cull_ms; //the time spent culling the instances over the whole run
+    double packets_ms; //the time spent building the draws of the visible instances over the whole run
+    long long occluded_instances; //the number of instances rejected as hidden over the whole run
+    long long occluders; //the number of occluders drawn over the whole run
+    double occlusion_ms; //the time spent on the occlusion culling over the whole run
+    int occlusion_over_budget_frames; //the number of frames the occlusion culling ran out of budget
+    double gpu_cull_ms; //the time the GPU spent culling the instances, over the frames it was read back for
+    int gpu_cull_frames; //the number of frames the time of the culling on the GPU was read back for
+
+    BenchmarkResult(const BenchmarkRun& run, long long triangles);
+};
+
+/*
+ * This method reads the description of a run (or of a sweep of runs over a range of instance counts).
+ * @param spec: The description of the run (see above)
+ * @param out_runs: The runs are added to this list. Passed by reference.
+ * @return A boolean specifying if the description was valid or not.
+ */
+bool ParseBenchmarkRuns(const char* spec, std::vector<BenchmarkRun>& out_runs);
+
+/*
+ * This method returns the name of the illumination model of the passed run (i.e. "uber-phong").
+ */
+std::string DescribeShading(const BenchmarkRun& run);
+
+/*
+ * This method places the camera and the object at the passed frame of the path. Over the frames of a run, the camera
+ * orbits the object once while moving in and out, and the object spins about its vertical axis.
+ * @param state: The render state to update. Passed by reference.
+ * @param frame: The frame of the run (from 0 to frame_count)
+ * @param frame_count: The number of frames in the run
+ */
+void ApplyCameraPath(RenderState& state, int frame, int frame_count);
+
+/*
+ * This method prints the frame time percentiles, the triangles per second and the OpenGL calls per frame of a run:
+ * the calls issued and skipped by the state cache, and the draw calls and the time taken to submit them. With
+ * instances, it also prints the instances drawn per frame and the time spent culling them on the CPU or on the GPU,
+ * along with the instances rejected as hidden when occlusion is on.
+ */
+void PrintBenchmarkResult(const BenchmarkResult& result);
+
+/*
+ * This method saves the results of every run to a CSV file, one line per run.
+ * @return A boolean specifying if the file could be written or not.
+ */
+bool WriteBenchmarkResults(const char* file_path, const std::vector<BenchmarkResult>& results);
+
+#endif //COMP_371_A2_BENCHMARKRUNS_H
@@ -0,0 +1,142 @@
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+#include "../GLM/glm/glm.hpp"
+#include "../GLM/glm/gtc/matrix_transform.hpp"
+#include "../Scene/SceneGraph.h"
+#include "../Stats/RollingStats.h"
+
+//this is a benchmark for updating the world matrices of a large scene graph (see SceneGraph.h). It does not need a
+//window or OpenGL, so it can be run anywhere:
+//
+//    SceneGraphBenchmark [node count]
+//
+//For each of the cases, the local matrices of some of the nodes are changed every frame and the time taken by the
+//update is reported.
+
+//the number of frames each case is run for
+const int FRAME_COUNT = 200;
+
+/*
+ * Method to make a random local matrix (a small rotation and translation).
+ */
+static glm::mat4 randomLocal()
+{
+    glm::vec3 offset(rand() % 100 / 50.0f - 1.0f, rand() % 100 / 50.0f - 1.0f, rand() % 100 / 50.0f - 1.0f);
+    float angle = glm::radians((float)(rand() % 360));
+
+    return glm::rotate(glm::translate(glm::mat4(1.0f), offset), angle, glm::vec3(0, 1, 0));
+}
+
+/*
+ * Method to run one case of the benchmark, where the passed fraction of the nodes is changed every frame.
+ */
+static void runCase(SceneGraph& graph, int node_count, double dirty_fraction)
+{
+    int dirty_count = std::max(1, (int)(node_count * dirty_fraction));
+    RollingStats update_ms(FRAME_COUNT);
+    long long recomputed = 0;
+
+    for(int frame = 0; frame < FRAME_COUNT; frame++)
+    {
+        //when every node is changed we go through them in order, otherwise we pick them at random
+        for(int i = 0; i < dirty_count; i++)
+        {
+            int node = dirty_count == node_count ? i : rand() % node_count;
+            SetNodeLocal(graph, node, graph.locals[graph.slots[node]]);
+        }
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        recomputed += UpdateSceneGraph(graph);
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+        AddSample(update_ms, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+
+    std::cout << dirty_fraction * 100 << "% of the nodes changed per frame (" << dirty_count << "): "
+              << recomputed / FRAME_COUNT << " nodes recomputed per frame, update p50 "
+              << GetPercentile(update_ms, 50) << " ms, p99 " << GetPercentile(update_ms, 99) << " ms" << std::endl;
+}
+
+/*
+ * Method to time the straightforward way of updating every node (a recursive walk that multiplies with glm), to compare
+ * against.
+ */
+static void walkNode(const std::vector<std::vector<int> >& children, const std::vector<glm::mat4>& locals,
+                     std::vector<glm::mat4>& worlds, int node, const glm::mat4& parent_world)
+{
+    worlds[node] = parent_world * locals[node];
+    for(int i = 0; i < children[node].size(); i++)
+        walkNode(children, locals, worlds, children[node][i], worlds[node]);
+}
+
+int main(int argc, char** argv)
+{
+    int node_count = argc > 1 ? atoi(argv[1]) : 100000;
+    if(node_count <= 0)
+    {
+        std::cout << "Usage: " << argv[0] << " [node count]" << std::endl;
+        return -1;
+    }
+
+    srand(371);
+
+    //the nodes make up a tree where every node has up to 4 children. They are added depth first (so always after their
+    //parent), which means the graph has to sort them by depth.
+    SceneGraph graph;
+    std::vector<std::vector<int> > children(node_count);
+    std::vector<glm::mat4> locals(node_count);
+    std::vector<int> handles(node_count);
+
+    for(int i = 1; i < node_count; i++)
+        children[(i - 1) / 4].push_back(i);
+
+    std::vector<int> stack(1, 0);
+    while(!stack.empty())
+    {
+        int node = stack.back();
+        stack.pop_back();
+
+        int parent = node == 0 ? -1 : (node - 1) / 4;
+        locals[node] = randomLocal();
+        handles[node] = AddSceneNode(graph, parent >= 0 ? handles[parent] : -1, locals[node]);
+
+        for(int i = 0; i < children[node].size(); i++)
+            stack.push_back(children[node][i]);
+    }
+
+    UpdateSceneGraph(graph);
+
+    std::cout << node_count << " nodes, " << graph.depths.back() + 1 << " levels, matrices multiplied with "
+              << GetSceneGraphSimd() << std::endl;
+
+    runCase(graph, node_count, 0.01);
+    runCase(graph, node_count, 1.0);
+
+    //and the recursive walk, for reference
+    std::vector<glm::mat4> worlds(node_count);
+    RollingStats walk_ms(FRAME_COUNT);
+    for(int frame = 0; frame < FRAME_COUNT; frame++)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        walkNode(children, locals, worlds, 0, glm::mat4(1.0f));
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+        AddSample(walk_ms, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+
+    std::cout << "Recursive walk of every node: p50 " << GetPercentile(walk_ms, 50) << " ms, p99 "
+              << GetPercentile(walk_ms, 99) << " ms" << std::endl;
+
+    //the two should agree on the world matrix of the deepest node
+    glm::mat4 difference = GetNodeWorld(graph, handles[node_count - 1]) - worlds[node_count - 1];
+    float error = 0;
+    for(int i = 0; i < 4; i++)
+        error = std::max(error, glm::length(difference[i]));
+
+    std::cout << "Largest difference from the recursive walk: " << error << std::endl;
+
+    return 0;
+}
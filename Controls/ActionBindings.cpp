@@ -0,0 +1,171 @@
+#include "ActionBindings.h"
+#include "KeyboardControls.h"
+
+//the signatures of the controls for the held and the pressed actions
+typedef void (*HeldControl)(GLFWwindow* window, RenderState& state, float dt);
+typedef void (*PressedControl)(RenderState& state);
+
+//the shaders are reloaded whatever the state, so the state is left unnamed
+static void reload_shaders(RenderState&)
+{
+    key_press_r();
+}
+
+//these are indexed by the action, so that dispatching an action is a single lookup. They must be kept in the same order
+//as the InputAction enum.
+static_assert(ACTION_ZOOM_OUT < 32, "every held action needs a bit in InputFrame::held");
+
+static const HeldControl held_controls[ACTION_ZOOM_OUT + 1] =
+{
+    NULL,
+    key_press_w,
+    key_press_s,
+    key_press_a,
+    key_press_d,
+    key_press_left_arrow,
+    key_press_right_arrow,
+    key_press_up_arrow,
+    key_press_down_arrow,
+    key_press_o,
+    key_press_p,
+    key_press_b,
+    key_press_n,
+    key_press_e,
+    key_press_j,
+    key_press_l,
+    key_press_i,
+    key_press_k,
+    key_press_pg_up,
+    key_press_pg_down,
+    key_press_lm_button_down,
+    key_press_lm_button_up
+};
+
+static const PressedControl pressed_controls[ACTION_COUNT - ACTION_TOGGLE_RED] =
+{
+    key_press_1,
+    key_press_2,
+    key_press_3,
+    key_press_4,
+    key_press_5,
+    key_press_6,
+    key_press_m,
+    key_press_g,
+    key_press_u,
+    reload_shaders
+};
+
+//the action each key is bound to, indexed by the GLFW key code
+static InputAction key_bindings[GLFW_KEY_LAST + 1];
+
+//the number of keys held down for each action (more than one key can be bound to the same action)
+static int held_keys[ACTION_COUNT];
+
+//the pressed actions since the last frame
+static std::vector<unsigned char> pending_pressed;
+
+void BindKey(int key, InputAction action)
+{
+    if(key >= 0 && key <= GLFW_KEY_LAST)
+        key_bindings[key] = action;
+}
+
+void BindDefaultKeys()
+{
+    BindKey(GLFW_KEY_W, ACTION_CAMERA_FORWARD);
+    BindKey(GLFW_KEY_S, ACTION_CAMERA_BACK);
+    BindKey(GLFW_KEY_A, ACTION_CAMERA_LEFT);
+    BindKey(GLFW_KEY_D, ACTION_CAMERA_RIGHT);
+    BindKey(GLFW_KEY_LEFT, ACTION_CAMERA_TURN_LEFT);
+    BindKey(GLFW_KEY_RIGHT, ACTION_CAMERA_TURN_RIGHT);
+    BindKey(GLFW_KEY_UP, ACTION_CAMERA_TURN_UP);
+    BindKey(GLFW_KEY_DOWN, ACTION_CAMERA_TURN_DOWN);
+    BindKey(GLFW_KEY_O, ACTION_SCALE_UP);
+    BindKey(GLFW_KEY_P, ACTION_SCALE_DOWN);
+    BindKey(GLFW_KEY_B, ACTION_ROTATE_X);
+    BindKey(GLFW_KEY_N, ACTION_ROTATE_Y);
+    BindKey(GLFW_KEY_E, ACTION_ROTATE_Z);
+    BindKey(GLFW_KEY_J, ACTION_MOVE_X_POSITIVE);
+    BindKey(GLFW_KEY_L, ACTION_MOVE_X_NEGATIVE);
+    BindKey(GLFW_KEY_I, ACTION_MOVE_Y_POSITIVE);
+    BindKey(GLFW_KEY_K, ACTION_MOVE_Y_NEGATIVE);
+    BindKey(GLFW_KEY_PAGE_UP, ACTION_MOVE_Z_POSITIVE);
+    BindKey(GLFW_KEY_PAGE_DOWN, ACTION_MOVE_Z_NEGATIVE);
+
+    BindKey(GLFW_KEY_1, ACTION_TOGGLE_RED);
+    BindKey(GLFW_KEY_2, ACTION_TOGGLE_GREEN);
+    BindKey(GLFW_KEY_3, ACTION_TOGGLE_BLUE);
+    BindKey(GLFW_KEY_4, ACTION_ALL_CHANNELS);
+    BindKey(GLFW_KEY_5, ACTION_TOGGLE_GOURAUD);
+    BindKey(GLFW_KEY_6, ACTION_TOGGLE_LIGHT);
+    BindKey(GLFW_KEY_M, ACTION_TOGGLE_NORMAL_AS_COLOR);
+    BindKey(GLFW_KEY_G, ACTION_TOGGLE_GRAY_SCALE);
+    BindKey(GLFW_KEY_U, ACTION_TOGGLE_UBER_SHADER);
+    BindKey(GLFW_KEY_R, ACTION_RELOAD_SHADERS);
+}
+
+void HandleKeyEvent(int key, int action)
+{
+    if(key < 0 || key > GLFW_KEY_LAST)
+        return;
+
+    InputAction input_action = key_bindings[key];
+    if(input_action == ACTION_NONE)
+        return;
+
+    //the held actions only care about the key going down and up, while the pressed actions happen once per press
+    //(the repeats sent while a key is held down are ignored)
+    if(input_action <= ACTION_ZOOM_OUT)
+    {
+        if(action == GLFW_PRESS)
+            held_keys[input_action]++;
+
+        else if(action == GLFW_RELEASE && held_keys[input_action] > 0)
+            held_keys[input_action]--;
+    }
+
+    else if(action == GLFW_PRESS)
+        pending_pressed.push_back((unsigned char)input_action);
+}
+
+bool HasPendingInput()
+{
+    for(int i = ACTION_CAMERA_FORWARD; i <= ACTION_ZOOM_OUT; i++)
+    {
+        if(held_keys[i] > 0)
+            return true;
+    }
+
+    return !pending_pressed.empty();
+}
+
+void TakeInputFrame(InputFrame& frame, float dt, unsigned int extra_held)
+{
+    frame.dt = dt;
+    frame.held = extra_held;
+
+    for(int i = ACTION_CAMERA_FORWARD; i <= ACTION_ZOOM_OUT; i++)
+    {
+        if(held_keys[i] > 0)
+            frame.held |= 1u << i;
+    }
+
+    frame.pressed.swap(pending_pressed);
+    pending_pressed.clear();
+}
+
+void ApplyInputFrame(GLFWwindow* window, RenderState& state, const InputFrame& frame)
+{
+    for(int i = ACTION_CAMERA_FORWARD; i <= ACTION_ZOOM_OUT; i++)
+    {
+        if(frame.held & (1u << i))
+            held_controls[i](window, state, frame.dt);
+    }
+
+    for(int i = 0; i < frame.pressed.size(); i++)
+    {
+        int action = frame.pressed[i];
+        if(action >= ACTION_TOGGLE_RED && action < ACTION_COUNT)
+            pressed_controls[action - ACTION_TOGGLE_RED](state);
+    }
+}
@@ -0,0 +1,110 @@
+#ifndef COMP_371_A2_ACTIONBINDINGS_H
+#define COMP_371_A2_ACTIONBINDINGS_H
+
+#include <glew.h>
+#include <GLFW/glfw3.h>
+#include <vector>
+#include "../Rendering/RenderState.h"
+
+//this contains the definitions for turning the keys (and the mouse) into actions. Each key is bound to an action in a
+//table indexed by the key, so finding what a key does is a single lookup. The actions of a frame are gathered into an
+//InputFrame, which is what gets applied to the render state (and what gets recorded and replayed, see
+//InputRecording.h).
+
+/*
+ * These are the actions the user can take. The ones up to (and including) ACTION_ZOOM_OUT are held down, and are
+ * applied every frame they are held for. The others are applied once each time their key is pressed.
+ */
+enum InputAction
+{
+    ACTION_NONE,
+
+    //the held actions
+    ACTION_CAMERA_FORWARD,
+    ACTION_CAMERA_BACK,
+    ACTION_CAMERA_LEFT,
+    ACTION_CAMERA_RIGHT,
+    ACTION_CAMERA_TURN_LEFT,
+    ACTION_CAMERA_TURN_RIGHT,
+    ACTION_CAMERA_TURN_UP,
+    ACTION_CAMERA_TURN_DOWN,
+    ACTION_SCALE_UP,
+    ACTION_SCALE_DOWN,
+    ACTION_ROTATE_X,
+    ACTION_ROTATE_Y,
+    ACTION_ROTATE_Z,
+    ACTION_MOVE_X_POSITIVE,
+    ACTION_MOVE_X_NEGATIVE,
+    ACTION_MOVE_Y_POSITIVE,
+    ACTION_MOVE_Y_NEGATIVE,
+    ACTION_MOVE_Z_POSITIVE,
+    ACTION_MOVE_Z_NEGATIVE,
+    ACTION_ZOOM_IN,
+    ACTION_ZOOM_OUT,
+
+    //the pressed actions
+    ACTION_TOGGLE_RED,
+    ACTION_TOGGLE_GREEN,
+    ACTION_TOGGLE_BLUE,
+    ACTION_ALL_CHANNELS,
+    ACTION_TOGGLE_GOURAUD,
+    ACTION_TOGGLE_LIGHT,
+    ACTION_TOGGLE_NORMAL_AS_COLOR,
+    ACTION_TOGGLE_GRAY_SCALE,
+    ACTION_TOGGLE_UBER_SHADER,
+    ACTION_RELOAD_SHADERS,
+
+    ACTION_COUNT
+};
+
+/*
+ * This is everything the user did during one frame.
+ */
+struct InputFrame
+{
+    float dt; //the time step the held actions are applied over, in seconds
+    unsigned int held; //a bit (1 << action) for each of the held actions that are held down
+    std::vector<unsigned char> pressed; //the pressed actions, in the order their keys were pressed
+};
+
+/*
+ * This method binds a key to an action, replacing whatever the key was bound to before.
+ * @param key: The GLFW key code
+ * @param action: The action to bind it to (ACTION_NONE to unbind it)
+ */
+void BindKey(int key, InputAction action);
+
+/*
+ * This method binds all the keys of the viewer to their default actions (see the README).
+ */
+void BindDefaultKeys();
+
+/*
+ * This method is called with the key events (from the keyboard callback) and keeps track of which held actions are
+ * held down, and of the pressed actions that have not been taken yet.
+ * @param key: The GLFW key code
+ * @param action: GLFW_PRESS, GLFW_REPEAT or GLFW_RELEASE
+ */
+void HandleKeyEvent(int key, int action);
+
+/*
+ * This method checks if there are actions to take: a held action whose key is down, or a pressed action that has not
+ * been taken yet.
+ */
+bool HasPendingInput();
+
+/*
+ * This method gathers the actions for this frame and clears the pressed actions.
+ * @param frame: This will hold the actions of the frame. Passed by reference.
+ * @param dt: The time step of the frame
+ * @param extra_held: The held actions that were not sampled from keys (i.e. the mouse zoom), as a bit for each
+ */
+void TakeInputFrame(InputFrame& frame, float dt, unsigned int extra_held);
+
+/*
+ * This method applies the actions of a frame to the render state by calling the matching controls (see
+ * KeyboardControls.h).
+ */
+void ApplyInputFrame(GLFWwindow* window, RenderState& state, const InputFrame& frame);
+
+#endif //COMP_371_A2_ACTIONBINDINGS_H
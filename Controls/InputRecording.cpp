@@ -0,0 +1,92 @@
+#include "InputRecording.h"
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+
+static const char RECORDING_MAGIC[4] = {'C', '3', 'I', 'R'};
+
+static std::ofstream recording;
+static int recorded_frames = 0;
+
+bool StartInputRecording(const char* file_path)
+{
+    recording.open(file_path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if(!recording.is_open())
+    {
+        std::cout << "Could not open " << file_path << " to record the input." << std::endl;
+        return false;
+    }
+
+    recording.write(RECORDING_MAGIC, sizeof(RECORDING_MAGIC));
+    recorded_frames = 0;
+    return true;
+}
+
+void RecordInputFrame(const InputFrame& frame)
+{
+    if(!recording.is_open())
+        return;
+
+    //a frame can only hold as many pressed actions as fit in its count, which is far more than anyone can type in a
+    //frame
+    unsigned char pressed_count = (unsigned char)std::min(frame.pressed.size(), (size_t)255);
+
+    recording.write((const char*)&frame.dt, sizeof(frame.dt));
+    recording.write((const char*)&frame.held, sizeof(frame.held));
+    recording.write((const char*)&pressed_count, 1);
+    if(pressed_count > 0)
+        recording.write((const char*)&frame.pressed[0], pressed_count);
+
+    recorded_frames++;
+}
+
+int StopInputRecording()
+{
+    if(recording.is_open())
+        recording.close();
+
+    return recorded_frames;
+}
+
+bool LoadInputRecording(const char* file_path, std::vector<InputFrame>& out_frames)
+{
+    std::ifstream in(file_path, std::ios::in | std::ios::binary);
+    if(!in.is_open())
+    {
+        std::cout << "Could not open the input recording " << file_path << std::endl;
+        return false;
+    }
+
+    char magic[sizeof(RECORDING_MAGIC)];
+    if(!in.read(magic, sizeof(magic)) || memcmp(magic, RECORDING_MAGIC, sizeof(magic)) != 0)
+    {
+        std::cout << file_path << " is not an input recording." << std::endl;
+        return false;
+    }
+
+    out_frames.clear();
+
+    InputFrame frame;
+    unsigned char pressed_count;
+    while(in.read((char*)&frame.dt, sizeof(frame.dt)))
+    {
+        //a recording that was cut short (i.e. the program was killed) is still good up to its last whole frame
+        bool whole_frame = in.read((char*)&frame.held, sizeof(frame.held)) && in.read((char*)&pressed_count, 1);
+        if(whole_frame)
+        {
+            frame.pressed.resize(pressed_count);
+            whole_frame = pressed_count == 0 || in.read((char*)&frame.pressed[0], pressed_count);
+        }
+
+        if(!whole_frame)
+        {
+            std::cout << file_path << " ends with a partial frame, which was ignored." << std::endl;
+            break;
+        }
+
+        out_frames.push_back(frame);
+    }
+
+    return true;
+}
@@ -0,0 +1,39 @@
+#ifndef COMP_371_A2_INPUTRECORDING_H
+#define COMP_371_A2_INPUTRECORDING_H
+
+#include <vector>
+#include "ActionBindings.h"
+
+//this contains the definitions for recording the actions of each frame to a file and reading them back, so that a
+//session can be replayed exactly (the replayed frames use the recorded time steps rather than the real ones).
+//
+//The file starts with the 4 bytes "C3IR", followed by one record per frame: the time step (a 4 byte float), the held
+//actions (4 bytes), the number of pressed actions (1 byte) and then one byte per pressed action. The values are
+//written in the byte order of the machine.
+
+/*
+ * This method starts recording the frames to the file at the passed path, replacing it if it exists.
+ * @return A boolean specifying if the file could be opened or not.
+ */
+bool StartInputRecording(const char* file_path);
+
+/*
+ * This method adds a frame to the recording (it does nothing if there is no recording going on).
+ */
+void RecordInputFrame(const InputFrame& frame);
+
+/*
+ * This method stops the recording and closes the file.
+ * @return The number of frames that were recorded
+ */
+int StopInputRecording();
+
+/*
+ * This method reads all the frames of a recording.
+ * @param file_path: The path of the recording
+ * @param out_frames: This will hold the frames of the recording, in order. Passed by reference.
+ * @return A boolean specifying if the recording could be read or not.
+ */
+bool LoadInputRecording(const char* file_path, std::vector<InputFrame>& out_frames);
+
+#endif //COMP_371_A2_INPUTRECORDING_H
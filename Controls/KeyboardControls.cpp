@@ -1,333 +1,293 @@
 #include "KeyboardControls.h"
-#include "../Loaders/ShaderLoader.h"
+#include "../Loaders/ShaderVariants.h"
+#include "../Loaders/ShaderPreprocessor.h"
 #include <iostream>
+#include <cmath>
 
-void key_press_w(GLFWwindow* window, glm::mat4& View, glm::mat4& Projection, glm::mat4& Model, GLuint& ShaderID)
+//the camera and the object move at a fixed speed while their keys are held down, whatever the frame rate is (each
+//control is passed the time since the last frame). These match the old steps (which were applied once per key event)
+//at a key repeat rate of 30 per second.
+const float MOVE_SPEED = 6.0f; //in units per second
+const float ROTATE_SPEED = 6.0f; //in degrees per second
+const float SCALE_SPEED = 1.35f; //the object is scaled by this factor per second
+const float ZOOM_SPEED = 6.0f; //in units per second, while the mouse is dragged
+
+void key_press_w(GLFWwindow* window, RenderState& state, float dt)
 {
     //when the w key is pressed on the keyboard, we should move the camera toward the object
-    //this is done by translating the View matrix in the x direction and then resetting the value of the uniform in
-    //out shader
-    View = glm::translate(View, glm::vec3(0, 0 , -0.2));
-    GLuint MatrixID = glGetUniformLocation(ShaderID, "view_matrix");
-    glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &View[0][0]);
+    //this is done by translating the View matrix in the x direction and marking it as dirty, so
+    //that the new value is sent to our shader by the next frame (nothing is sent to OpenGL from here)
+    TranslateTransform(state.view, glm::vec3(0, 0, -MOVE_SPEED * dt));
+    state.dirty |= DIRTY_VIEW;
 }
 
-void key_press_s(GLFWwindow* window, glm::mat4& View, glm::mat4& Projection, glm::mat4& Model, GLuint& ShaderID)
+void key_press_s(GLFWwindow* window, RenderState& state, float dt)
 {
     //when the s key is pressed on the keyboard, we should move the camera away from the object
-    //this is done by translating the View matrix in the x direction and then resetting the value of the uniform in
-    //our shader
-    View = glm::translate(View, glm::vec3(0, 0 , 0.2));
-    GLuint MatrixID = glGetUniformLocation(ShaderID, "view_matrix");
-    glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &View[0][0]);
+    //this is done by translating the View matrix in the x direction and marking it as dirty, so
+    //that the new value is sent to our shader by the next frame (nothing is sent to OpenGL from here)
+    TranslateTransform(state.view, glm::vec3(0, 0, MOVE_SPEED * dt));
+    state.dirty |= DIRTY_VIEW;
 }
 
-void key_press_a(GLFWwindow* window, glm::mat4& View, glm::mat4& Projection, glm::mat4& Model, GLuint& ShaderID)
+void key_press_a(GLFWwindow* window, RenderState& state, float dt)
 {
     //when the a key is pressed on the keyboard, we should move the camera to the left the object
-    //this is done by translating the View matrix in the x direction and then resetting the value of the uniform in
-    //our shader
-    View = glm::translate(View, glm::vec3(-0.2, 0 , 0));
-    GLuint MatrixID = glGetUniformLocation(ShaderID, "view_matrix");
-    glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &View[0][0]);
+    //this is done by translating the View matrix in the x direction and marking it as dirty, so
+    //that the new value is sent to our shader by the next frame (nothing is sent to OpenGL from here)
+    TranslateTransform(state.view, glm::vec3(-MOVE_SPEED * dt, 0, 0));
+    state.dirty |= DIRTY_VIEW;
 }
 
-void key_press_d(GLFWwindow* window, glm::mat4& View, glm::mat4& Projection, glm::mat4& Model, GLuint& ShaderID)
+void key_press_d(GLFWwindow* window, RenderState& state, float dt)
 {
     //when the d key is pressed on the keyboard, we should move the camera to the right of the object
-    //this is done by translating the View matrix in the x direction and then resetting the value of the uniform in
-    //our shader
-    View = glm::translate(View, glm::vec3(0.2, 0 , 0));
-    GLuint MatrixID = glGetUniformLocation(ShaderID, "view_matrix");
-    glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &View[0][0]);
+    //this is done by translating the View matrix in the x direction and marking it as dirty, so
+    //that the new value is sent to our shader by the next frame (nothing is sent to OpenGL from here)
+    TranslateTransform(state.view, glm::vec3(MOVE_SPEED * dt, 0, 0));
+    state.dirty |= DIRTY_VIEW;
 }
 
-void key_press_o(GLFWwindow* window, glm::mat4& View, glm::mat4& Projection, glm::mat4& Model, GLuint& ShaderID)
+void key_press_o(GLFWwindow* window, RenderState& state, float dt)
 {
-    //when the o key is pressed on the keyboard, we should scale the object up by 10%.
-    //this is done by scaling the model matrix in all directions and then resetting the value of the uniform in
-    //our shader
-    Model = glm::scale(Model, glm::vec3(1.01f, 1.01f, 1.01f));
-    GLuint MatrixID = glGetUniformLocation(ShaderID, "model_matrix");
-    glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &Model[0][0]);
+    //when the o key is pressed on the keyboard, we should scale the object up.
+    //this is done by scaling the model matrix in all directions and marking it as dirty, so
+    //that the new value is sent to our shader by the next frame (nothing is sent to OpenGL from here)
+    ScaleTransform(state.model, std::pow(SCALE_SPEED, dt));
+    state.dirty |= DIRTY_MODEL;
 }
 
-void key_press_p(GLFWwindow* window, glm::mat4& View, glm::mat4& Projection, glm::mat4& Model, GLuint& ShaderID)
+void key_press_p(GLFWwindow* window, RenderState& state, float dt)
 {
-    //when the p key is pressed on the keyboard, we should scale the object down by 10%.
-    //this is done by scaling the model matrix in all directions and then resetting the value of the uniform in
-    //our shader
-    Model = glm::scale(Model, glm::vec3(0.99f, 0.99f, 0.99f));
-    GLuint MatrixID = glGetUniformLocation(ShaderID, "model_matrix");
-    glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &Model[0][0]);
+    //when the p key is pressed on the keyboard, we should scale the object down.
+    //this is done by scaling the model matrix in all directions and marking it as dirty, so
+    //that the new value is sent to our shader by the next frame (nothing is sent to OpenGL from here)
+    ScaleTransform(state.model, std::pow(SCALE_SPEED, -dt));
+    state.dirty |= DIRTY_MODEL;
 }
 
-void key_press_left_arrow(GLFWwindow* window, glm::mat4& View, glm::mat4& Projection, glm::mat4& Model, GLuint& ShaderID)
+void key_press_left_arrow(GLFWwindow* window, RenderState& state, float dt)
 {
     //when the left arrow is pressed, we need to rotate the camera (i.e the view matrix about the up vector in
     //counterclockwise fashion).
-    View = glm::rotate(View, glm::radians(0.2f), glm::vec3(0,1,0));
-    GLuint MatrixID = glGetUniformLocation(ShaderID, "view_matrix");
-    glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &View[0][0]);
+    RotateTransform(state.view, glm::radians(ROTATE_SPEED * dt), glm::vec3(0,1,0));
+    state.dirty |= DIRTY_VIEW;
 }
 
-void key_press_right_arrow(GLFWwindow* window, glm::mat4& View, glm::mat4& Projection, glm::mat4& Model, GLuint& ShaderID)
+void key_press_right_arrow(GLFWwindow* window, RenderState& state, float dt)
 {
     //when the right arrow is pressed, we need to rotate the camera (i.e the view matrix about the up vector in
     //clockwise fashion).
-    View = glm::rotate(View, glm::radians(-0.2f), glm::vec3(0,1,0));
-    GLuint MatrixID = glGetUniformLocation(ShaderID, "view_matrix");
-    glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &View[0][0]);
+    RotateTransform(state.view, glm::radians(-ROTATE_SPEED * dt), glm::vec3(0,1,0));
+    state.dirty |= DIRTY_VIEW;
 }
 
-void key_press_up_arrow(GLFWwindow* window, glm::mat4& View, glm::mat4& Projection, glm::mat4& Model, GLuint& ShaderID)
+void key_press_up_arrow(GLFWwindow* window, RenderState& state, float dt)
 {
     //when the right arrow is pressed, we need to rotate the camera (i.e the view matrix about the up vector in
     //clockwise fashion).
-    View = glm::rotate(View, glm::radians(-0.2f), glm::vec3(1,0,0));
-    GLuint MatrixID = glGetUniformLocation(ShaderID, "view_matrix");
-    glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &View[0][0]);
+    RotateTransform(state.view, glm::radians(-ROTATE_SPEED * dt), glm::vec3(1,0,0));
+    state.dirty |= DIRTY_VIEW;
 }
 
-void key_press_down_arrow(GLFWwindow* window, glm::mat4& View, glm::mat4& Projection, glm::mat4& Model, GLuint& ShaderID)
+void key_press_down_arrow(GLFWwindow* window, RenderState& state, float dt)
 {
     //when the right arrow is pressed, we need to rotate the camera (i.e the view matrix about the up vector in
     //clockwise fashion).
-    View = glm::rotate(View, glm::radians(0.2f), glm::vec3(1,0,0));
-    GLuint MatrixID = glGetUniformLocation(ShaderID, "view_matrix");
-    glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &View[0][0]);
+    RotateTransform(state.view, glm::radians(ROTATE_SPEED * dt), glm::vec3(1,0,0));
+    state.dirty |= DIRTY_VIEW;
 }
 
-void key_press_b(GLFWwindow* window, glm::mat4& View, glm::mat4& Projection, glm::mat4& Model, GLuint& ShaderID)
+void key_press_b(GLFWwindow* window, RenderState& state, float dt)
 {
     //when the b key is pressed, the OBJECT itself (not the camera) should be rotated about the x-axis.
     //in order to do this, we want to modify the Model matrix
-    Model = glm::rotate(Model, glm::radians(-0.2f), glm::vec3(1,0,0));
-    GLuint MatrixID = glGetUniformLocation(ShaderID, "model_matrix");
-    glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &Model[0][0]);
+    RotateTransform(state.model, glm::radians(-ROTATE_SPEED * dt), glm::vec3(1,0,0));
+    state.dirty |= DIRTY_MODEL;
 }
 
-void key_press_n(GLFWwindow* window, glm::mat4& View, glm::mat4& Projection, glm::mat4& Model, GLuint& ShaderID)
+void key_press_n(GLFWwindow* window, RenderState& state, float dt)
 {
     //when the n key is pressed, the OBJECT itself (not the camera) should be rotated about the y-axis.
     //in order to do this, we want to modify the Model matrix
-    Model = glm::rotate(Model, glm::radians(0.2f), glm::vec3(0,1,0));
-    GLuint MatrixID = glGetUniformLocation(ShaderID, "model_matrix");
-    glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &Model[0][0]);
+    RotateTransform(state.model, glm::radians(ROTATE_SPEED * dt), glm::vec3(0,1,0));
+    state.dirty |= DIRTY_MODEL;
 }
 
-void key_press_e(GLFWwindow* window, glm::mat4& View, glm::mat4& Projection, glm::mat4& Model, GLuint& ShaderID)
+void key_press_e(GLFWwindow* window, RenderState& state, float dt)
 {
     //when the n key is pressed, the OBJECT itself (not the camera) should be rotated about the z-axis.
     //in order to do this, we want to modify the Model matrix
-    Model = glm::rotate(Model, glm::radians(0.2f), glm::vec3(0,0,1));
-    GLuint MatrixID = glGetUniformLocation(ShaderID, "model_matrix");
-    glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &Model[0][0]);
+    RotateTransform(state.model, glm::radians(ROTATE_SPEED * dt), glm::vec3(0,0,1));
+    state.dirty |= DIRTY_MODEL;
 }
 
-void key_press_j(GLFWwindow* window, glm::mat4& View, glm::mat4& Projection, glm::mat4& Model, GLuint& ShaderID)
+void key_press_j(GLFWwindow* window, RenderState& state, float dt)
 {
     //when the j key is pressed, the OBJECT itself (not the camera) should be translated along the x axis
     //in the positive direction
     //in order to do this, we want to modify the Model matrix
-    Model = glm::translate(Model, glm::vec3(0.2f, 0 , 0));
-    GLuint MatrixID = glGetUniformLocation(ShaderID, "model_matrix");
-    glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &Model[0][0]);
+    TranslateTransform(state.model, glm::vec3(MOVE_SPEED * dt, 0, 0));
+    state.dirty |= DIRTY_MODEL;
 }
 
-void key_press_l(GLFWwindow* window, glm::mat4& View, glm::mat4& Projection, glm::mat4& Model, GLuint& ShaderID)
+void key_press_l(GLFWwindow* window, RenderState& state, float dt)
 {
     //when the l key is pressed, the OBJECT itself (not the camera) should be translated along the x axis
     //in the positive direction
     //in order to do this, we want to modify the Model matrix
-    Model = glm::translate(Model, glm::vec3(-0.2f, 0 , 0));
-    GLuint MatrixID = glGetUniformLocation(ShaderID, "model_matrix");
-    glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &Model[0][0]);
+    TranslateTransform(state.model, glm::vec3(-MOVE_SPEED * dt, 0, 0));
+    state.dirty |= DIRTY_MODEL;
 }
 
-void key_press_i(GLFWwindow* window, glm::mat4& View, glm::mat4& Projection, glm::mat4& Model, GLuint& ShaderID)
+void key_press_i(GLFWwindow* window, RenderState& state, float dt)
 {
     //when the i key is pressed, the OBJECT itself (not the camera) should be translated along the y axis
     //in the positive direction
     //in order to do this, we want to modify the Model matrix
-    Model = glm::translate(Model, glm::vec3(0, 0.2f , 0));
-    GLuint MatrixID = glGetUniformLocation(ShaderID, "model_matrix");
-    glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &Model[0][0]);
+    TranslateTransform(state.model, glm::vec3(0, MOVE_SPEED * dt, 0));
+    state.dirty |= DIRTY_MODEL;
 }
 
-void key_press_k(GLFWwindow* window, glm::mat4& View, glm::mat4& Projection, glm::mat4& Model, GLuint& ShaderID)
+void key_press_k(GLFWwindow* window, RenderState& state, float dt)
 {
     //when the k key is pressed, the OBJECT itself (not the camera) should be translated along the y axis
     //in the negative direction
     //in order to do this, we want to modify the Model matrix
-    Model = glm::translate(Model, glm::vec3(0, -0.2f , 0));
-    GLuint MatrixID = glGetUniformLocation(ShaderID, "model_matrix");
-    glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &Model[0][0]);
+    TranslateTransform(state.model, glm::vec3(0, -MOVE_SPEED * dt, 0));
+    state.dirty |= DIRTY_MODEL;
 }
 
-void key_press_pg_up(GLFWwindow* window, glm::mat4& View, glm::mat4& Projection, glm::mat4& Model, GLuint& ShaderID)
+void key_press_pg_up(GLFWwindow* window, RenderState& state, float dt)
 {
     //when the page up key is pressed, the OBJECT itself (not the camera) should be translated along the z axis
     //in the positive direction
     //in order to do this, we want to modify the Model matrix
-    Model = glm::translate(Model, glm::vec3(0, 0 , 0.2f));
-    GLuint MatrixID = glGetUniformLocation(ShaderID, "model_matrix");
-    glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &Model[0][0]);
+    TranslateTransform(state.model, glm::vec3(0, 0, MOVE_SPEED * dt));
+    state.dirty |= DIRTY_MODEL;
 }
 
-void key_press_pg_down(GLFWwindow* window, glm::mat4& View, glm::mat4& Projection, glm::mat4& Model, GLuint& ShaderID)
+void key_press_pg_down(GLFWwindow* window, RenderState& state, float dt)
 {
     //when the page down key is pressed, the OBJECT itself (not the camera) should be translated along the z axis
     //in the negative direction
     //in order to do this, we want to modify the Model matrix
-    Model = glm::translate(Model, glm::vec3(0, 0 , -0.2f));
-    GLuint MatrixID = glGetUniformLocation(ShaderID, "model_matrix");
-    glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &Model[0][0]);
+    TranslateTransform(state.model, glm::vec3(0, 0, -MOVE_SPEED * dt));
+    state.dirty |= DIRTY_MODEL;
 }
 
-void key_press_lm_button_up(GLFWwindow* window, glm::mat4& View, glm::mat4& Projection, glm::mat4& Model, GLuint& ShaderID)
+void key_press_lm_button_up(GLFWwindow* window, RenderState& state, float dt)
 {
-    View = glm::translate(View, glm::vec3(0,0,0.1));
-    GLuint MatrixID = glGetUniformLocation(ShaderID, "view_matrix");
-    glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &View[0][0]);
+    TranslateTransform(state.view, glm::vec3(0, 0, ZOOM_SPEED * dt));
+    state.dirty |= DIRTY_VIEW;
 }
 
-void key_press_lm_button_down(GLFWwindow* window, glm::mat4& View, glm::mat4& Projection, glm::mat4& Model, GLuint& ShaderID)
+void key_press_lm_button_down(GLFWwindow* window, RenderState& state, float dt)
 {
-    View = glm::translate(View, glm::vec3(0,0,-0.1));
-    GLuint MatrixID = glGetUniformLocation(ShaderID, "view_matrix");
-    glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &View[0][0]);
+    TranslateTransform(state.view, glm::vec3(0, 0, -ZOOM_SPEED * dt));
+    state.dirty |= DIRTY_VIEW;
 }
 
-void key_press_1(GLuint program_ID)
+void key_press_1(RenderState& state)
 {
-    //when this key is pressed, we first need to find the id of the red channel uniform in the shader program
-    GLuint red_channel_id = glGetUniformLocation(program_ID, "red_channel");
-    GLfloat red_val; //this will hold the current value of the red channel uniform in the shader program
-    glGetUniformfv(program_ID, red_channel_id, &red_val); //this will change the value of red_val so we have the
-                                                          //the current one
-    if(red_val == 1.0f)
-        glUniform1f(red_channel_id, 0.0f);
-    else
-        glUniform1f(red_channel_id, 1.0f);
-
-    //this changes the value of the red_channel from 1 to 0 or zero to 1 depending on what the current value is
+    //when this key is pressed, we flip the red channel toggle. The current value is kept in the render state so we never
+    //have to read it back from the shader program, and the new value is picked up by the next frame (either by
+    //selecting the matching shader permutation or by flushing the uniform to the uber-shader).
+    state.toggles ^= TOGGLE_RED_CHANNEL;
+    state.dirty |= DIRTY_TOGGLES;
 }
 
-void key_press_2(GLuint program_ID)
+void key_press_2(RenderState& state)
 {
     //this method works exactly in the same way as the one for the red channel, the only difference is that here
     //we are modifying the green channel's value
-
-    GLuint green_channel_id = glGetUniformLocation(program_ID, "green_channel");
-    GLfloat green_val;
-    glGetUniformfv(program_ID, green_channel_id, &green_val);
-
-    if(green_val == 1.0f)
-        glUniform1f(green_channel_id, 0.0f);
-    else
-        glUniform1f(green_channel_id, 1.0f);
+    state.toggles ^= TOGGLE_GREEN_CHANNEL;
+    state.dirty |= DIRTY_TOGGLES;
 }
 
-void key_press_3(GLuint program_ID)
+void key_press_3(RenderState& state)
 {
     //this method works exactly in the same way as the one for the red channel, the only difference is that here
     //we are modifying the blue channel's value
-
-    GLuint blue_channel_id = glGetUniformLocation(program_ID, "blue_channel");
-    GLfloat blue_val;
-    glGetUniformfv(program_ID, blue_channel_id, &blue_val);
-
-    if(blue_val == 1.0f)
-        glUniform1f(blue_channel_id, 0.0f);
-    else
-        glUniform1f(blue_channel_id, 1.0f);
+    state.toggles ^= TOGGLE_BLUE_CHANNEL;
+    state.dirty |= DIRTY_TOGGLES;
 }
 
-void key_press_4(GLuint program_ID)
+void key_press_4(RenderState& state)
 {
     //when the '4' key is pressed on the keyboard, all of the channels should be toggled on.
-    //to do this, we need to first find all of our channels
-    GLuint red_channel_id = glGetUniformLocation(program_ID, "red_channel");
-    GLuint green_channel_id = glGetUniformLocation(program_ID, "green_channel");
-    GLuint blue_channel_id = glGetUniformLocation(program_ID, "blue_channel");
-
-    //now that we have the color id's we need to change their values
-    glUniform1f(red_channel_id, 1.0f);
-    glUniform1f(green_channel_id, 1.0f);
-    glUniform1f(blue_channel_id, 1.0f);
+    state.toggles |= TOGGLE_RED_CHANNEL | TOGGLE_GREEN_CHANNEL | TOGGLE_BLUE_CHANNEL;
+    state.dirty |= DIRTY_TOGGLES;
 }
 
-void key_press_6(GLuint program_ID)
+void key_press_6(RenderState& state)
 {
     //if the light is on, then we should turn it off and vice versa
-    GLuint light_on_id = glGetUniformLocation(program_ID, "light_on");
-    GLint light_on_value;
-    glGetUniformiv(program_ID, light_on_id, &light_on_value);
-
-    if(light_on_value == 1)
-        glUniform1i(light_on_id, 0);
-    else
-        glUniform1i(light_on_id, 1);
+    state.toggles ^= TOGGLE_LIGHT_ON;
+    state.dirty |= DIRTY_TOGGLES;
 }
 
-void key_press_5(GLuint& program_ID, GLboolean& gouraud)
+void key_press_5(RenderState& state)
 {
-    //there are two cases, either gouraud is true, in which case, we should load the phong shaders and flip it, or
-    //it is false, and we should load the gouraud shaders and flip it.
-    if(gouraud)
+    //there are two cases, either gouraud is true, in which case we should switch to phong and flip it, or
+    //it is false, and we should switch to gouraud and flip it. The matching shader program is selected (and compiled
+    //if this is the first time it is used) by the next frame.
+    if(state.gouraud)
     {
         std::cout << "Switching to Phong Illumination Model..." << std::endl;
-        program_ID = LoadShaders("../Shaders/PhongVertexShader.glsl", "../Shaders/PhongFragmentShader.glsl");
-        glUseProgram(program_ID);
-        gouraud = GL_FALSE;
+        state.gouraud = GL_FALSE;
     }
 
     else
     {
         std::cout << "Switching to Gouraud Illumination Model..." << std::endl;
-        program_ID = LoadShaders("../Shaders/GouraudVertexShader.glsl", "../Shaders/GouraudFragmentShader.glsl");
-        glUseProgram(program_ID);
-        gouraud = GL_TRUE;
+        state.gouraud = GL_TRUE;
     }
 }
 
-void key_press_m(GLuint program_ID)
+void key_press_m(RenderState& state)
 {
-    //first we must check the value of the uniform
-    GLint flag_value;
-    glGetUniformiv(program_ID, glGetUniformLocation(program_ID, "normal_as_color"), &flag_value);
+    //flip the flag that determines if the normal should be used as the color
+    state.toggles ^= TOGGLE_NORMAL_AS_COLOR;
+    state.dirty |= DIRTY_TOGGLES;
+}
+
+void key_press_g(RenderState& state)
+{
+    //flip the flag that determines if the scene should be rendered in grayscale
+    state.toggles ^= TOGGLE_GRAY_SCALE;
+    state.dirty |= DIRTY_TOGGLES;
+}
 
-    //now that we have the current value, we should flip it
-    if(flag_value == 1)
+void key_press_u(RenderState& state)
+{
+    //flip between the specialized shader permutations and the uber-shader
+    if(state.uber_shader)
     {
-        GLuint flag_location = glGetUniformLocation(program_ID, "normal_as_color");
-        glUniform1i(flag_location, 0);
+        std::cout << "Switching to specialized shader permutations..." << std::endl;
+        state.uber_shader = GL_FALSE;
     }
 
     else
     {
-        GLuint flag_location = glGetUniformLocation(program_ID, "normal_as_color");
-        glUniform1i(flag_location, 1);
+        std::cout << "Switching to the uber-shader..." << std::endl;
+        state.uber_shader = GL_TRUE;
     }
 }
 
-void key_press_g(GLuint program_ID)
+void key_press_r()
 {
-    //first we must check the value of the uniform
-    GLint flag_value;
-    glGetUniformiv(program_ID, glGetUniformLocation(program_ID, "gray_scale"), &flag_value);
+    //find the shader files that changed on disk since they were read, and recompile only the programs built from them
+    std::vector<std::string> changed_files = RefreshShaderSources();
 
-    //now that we have the current value, we should flip it
-    if(flag_value == 1)
+    if(changed_files.empty())
     {
-        GLuint flag_location = glGetUniformLocation(program_ID, "gray_scale");
-        glUniform1i(flag_location, 0);
+        std::cout << "No shader files have changed." << std::endl;
+        return;
     }
 
-    else
-    {
-        GLuint flag_location = glGetUniformLocation(program_ID, "gray_scale");
-        glUniform1i(flag_location, 1);
-    }
+    for(int i = 0; i < changed_files.size(); i++)
+        std::cout << changed_files[i] << " has changed." << std::endl;
+
+    std::cout << "Recompiling " << ReloadShaderFiles(changed_files) << " shader program(s)..." << std::endl;
 }
\ No newline at end of file
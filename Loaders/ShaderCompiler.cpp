@@ -0,0 +1,236 @@
+#include "ShaderCompiler.h"
+#include "ShaderLoader.h"
+#include "ShaderPreprocessor.h"
+#include "../Stats/Clock.h"
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+//the ways in which programs can be compiled, from the best to the worst
+enum CompileMode
+{
+    COMPILE_PARALLEL_EXTENSION, //the driver compiles in the background (GL_KHR_parallel_shader_compile)
+    COMPILE_WORKER_THREAD, //our own thread compiles in a shared context
+    COMPILE_BLOCKING //we could not do either, so submitting a job compiles it right away
+};
+
+static CompileMode compile_mode = COMPILE_BLOCKING;
+static int pending_jobs = 0;
+
+//everything needed by the worker thread
+static GLFWwindow* worker_context = nullptr;
+static std::thread worker_thread;
+static std::mutex queue_mutex;
+static std::condition_variable queue_condition;
+static std::deque<ShaderJobPtr> job_queue;
+static bool stop_worker = false;
+
+/*
+ * This reads, compiles and links the shaders for the passed job, then checks the result. It blocks until the program
+ * is linked, so it is only called on the worker thread (or when there is no other choice).
+ */
+static void CompileJob(const ShaderJobPtr& job)
+{
+    std::string vertex_code;
+    std::string fragment_code;
+
+    if(!LoadShaderSource(job->vertex_file_path.c_str(), job->defines, vertex_code, job->files) ||
+       !LoadShaderSource(job->fragment_file_path.c_str(), job->defines, fragment_code, job->files))
+    {
+        job->log = "Unable to read the shader source";
+        return;
+    }
+
+    job->program = SubmitProgram(vertex_code, fragment_code);
+
+    if(!FinishProgram(job->program, job->log))
+    {
+        glDeleteProgram(job->program);
+        job->program = 0;
+    }
+}
+
+/*
+ * This is the loop run by the worker thread. It takes jobs off of the queue and compiles them in its own context.
+ */
+static void WorkerLoop()
+{
+    glfwMakeContextCurrent(worker_context);
+
+    while(true)
+    {
+        ShaderJobPtr job;
+
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            queue_condition.wait(lock, []{ return stop_worker || !job_queue.empty(); });
+
+            if(stop_worker)
+                break;
+
+            job = job_queue.front();
+            job_queue.pop_front();
+        }
+
+        CompileJob(job);
+
+        //the program must be completely done on our side before the render thread is allowed to use it
+        glFinish();
+        job->done.store(true);
+    }
+
+    glfwMakeContextCurrent(NULL);
+}
+
+void InitShaderCompiler(GLFWwindow* window)
+{
+    //the best case is when the driver can compile in parallel by itself
+    if(GLEW_KHR_parallel_shader_compile)
+    {
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+        compile_mode = COMPILE_PARALLEL_EXTENSION;
+        std::cout << "Compiling shaders with GL_KHR_parallel_shader_compile" << std::endl;
+        return;
+    }
+
+    if(GLEW_ARB_parallel_shader_compile)
+    {
+        glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+        compile_mode = COMPILE_PARALLEL_EXTENSION;
+        std::cout << "Compiling shaders with GL_ARB_parallel_shader_compile" << std::endl;
+        return;
+    }
+
+    //otherwise we need a hidden window whose context shares its objects (including programs) with the real one, which
+    //we can not have when rendering without a window
+    if(window == nullptr)
+    {
+        compile_mode = COMPILE_BLOCKING;
+        std::cout << "No window to share a context with, shaders will be compiled on the render thread" << std::endl;
+        return;
+    }
+
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    worker_context = glfwCreateWindow(1, 1, "Shader Compiler", NULL, window);
+    glfwDefaultWindowHints();
+
+    if(worker_context == nullptr)
+    {
+        compile_mode = COMPILE_BLOCKING;
+        std::cout << "Unable to create a shared context, shaders will be compiled on the render thread" << std::endl;
+        return;
+    }
+
+    stop_worker = false;
+    worker_thread = std::thread(WorkerLoop);
+    compile_mode = COMPILE_WORKER_THREAD;
+    std::cout << "Compiling shaders on a worker thread" << std::endl;
+}
+
+void ShutdownShaderCompiler()
+{
+    if(compile_mode != COMPILE_WORKER_THREAD)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        stop_worker = true;
+    }
+
+    queue_condition.notify_one();
+    worker_thread.join();
+    glfwDestroyWindow(worker_context);
+    worker_context = nullptr;
+    compile_mode = COMPILE_BLOCKING;
+}
+
+ShaderJobPtr SubmitShaders(const char* vertex_file_path, const char* fragment_file_path,
+                           const std::vector<std::string>& defines)
+{
+    ShaderJobPtr job = std::make_shared<ShaderJob>();
+    job->vertex_file_path = vertex_file_path;
+    job->fragment_file_path = fragment_file_path;
+    job->defines = defines;
+    job->submit_time = GetTime();
+    pending_jobs++;
+
+    if(compile_mode == COMPILE_PARALLEL_EXTENSION)
+    {
+        //reading the files is quick, it is the compiling and linking that the driver does in the background
+        std::string vertex_code;
+        std::string fragment_code;
+
+        if(LoadShaderSource(vertex_file_path, defines, vertex_code, job->files) &&
+           LoadShaderSource(fragment_file_path, defines, fragment_code, job->files))
+        {
+            job->program = SubmitProgram(vertex_code, fragment_code);
+        }
+
+        else
+        {
+            job->log = "Unable to read the shader source";
+            job->done.store(true);
+        }
+    }
+
+    else if(compile_mode == COMPILE_WORKER_THREAD)
+    {
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            job_queue.push_back(job);
+        }
+
+        queue_condition.notify_one();
+    }
+
+    else
+    {
+        CompileJob(job);
+        job->done.store(true);
+    }
+
+    return job;
+}
+
+bool PollShaders(const ShaderJobPtr& job)
+{
+    if(job->collected)
+        return true;
+
+    if(!job->done.load())
+    {
+        //with the extension, the job is only done once the driver says that the program has finished linking
+        if(compile_mode != COMPILE_PARALLEL_EXTENSION || job->program == 0)
+            return false;
+
+        GLint completed = GL_FALSE;
+        glGetProgramiv(job->program, GL_COMPLETION_STATUS_KHR, &completed);
+
+        if(completed != GL_TRUE)
+            return false;
+
+        if(!FinishProgram(job->program, job->log))
+        {
+            glDeleteProgram(job->program);
+            job->program = 0;
+        }
+
+        job->done.store(true);
+    }
+
+    //this is the first time we see the job as done, so it is no longer pending
+    if(job->program == 0)
+        std::cout << "Failed to compile " << job->vertex_file_path << " and " << job->fragment_file_path
+                  << ":\n" << MapShaderLog(job->log, job->files) << std::endl;
+
+    job->collected = true;
+    pending_jobs--;
+    return true;
+}
+
+int PendingShaderJobs()
+{
+    return pending_jobs;
+}
@@ -0,0 +1,69 @@
+#ifndef COMP_371_A2_SHADERCOMPILER_H
+#define COMP_371_A2_SHADERCOMPILER_H
+
+#include <glew.h>
+#include <GLFW/glfw3.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+//this contains the definitions for compiling shader programs without blocking the render thread. Compiling is split
+//into a submit phase and a poll phase. When the driver exposes GL_KHR_parallel_shader_compile (or the ARB version),
+//the driver compiles in the background and we only poll the completion status. Otherwise the programs are compiled
+//by a worker thread in a hidden context that shares its objects with the window's context.
+
+/*
+ * This holds everything about a single program being compiled. Once done is set, program holds the id of the linked
+ * program (or 0 if it failed, in which case log holds the compile and link logs).
+ */
+struct ShaderJob
+{
+    std::string vertex_file_path;
+    std::string fragment_file_path;
+    std::vector<std::string> defines;
+
+    GLuint program;
+    std::string log;
+    std::vector<std::string> files; //every file the program is made of (its dependencies), see ShaderPreprocessor.h
+    double submit_time; //the value of GetTime() when the job was submitted
+
+    std::atomic<bool> done; //set (possibly by the worker thread) once the program is linked or has failed
+    bool collected; //set by PollShaders once the render thread has seen the job as done
+
+    ShaderJob() : program(0), submit_time(0), done(false), collected(false) {}
+};
+
+typedef std::shared_ptr<ShaderJob> ShaderJobPtr;
+
+/*
+ * This method sets up the compiler for the passed window (or for the current context, if there is no window). It must
+ * be called from the thread that owns the context, after GLEW has been initialized.
+ */
+void InitShaderCompiler(GLFWwindow* window);
+
+/*
+ * This method stops the worker thread (if there is one) and destroys its context.
+ */
+void ShutdownShaderCompiler();
+
+/*
+ * This method submits the shaders at the passed file paths (with the passed defines injected) for compilation and
+ * returns right away.
+ * @return The job to pass to PollShaders
+ */
+ShaderJobPtr SubmitShaders(const char* vertex_file_path, const char* fragment_file_path,
+                           const std::vector<std::string>& defines);
+
+/*
+ * This method checks if the passed job is done without waiting for it. It must be called from the render thread.
+ * @return true once the job is done (successful or not)
+ */
+bool PollShaders(const ShaderJobPtr& job);
+
+/*
+ * This method returns the number of jobs that have been submitted but not polled to completion yet.
+ */
+int PendingShaderJobs();
+
+#endif //COMP_371_A2_SHADERCOMPILER_H
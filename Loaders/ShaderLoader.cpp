@@ -1,89 +1,184 @@
 #include "ShaderLoader.h"
+#include "ShaderPreprocessor.h"
 #include <string>
-#include <fstream>
-#include <sstream>
 #include <vector>
+#include <iostream>
 
 //this file contains the function definition for the shader loader function
 
 /*
- * This is the function implementation for loading shaders into a usable program
- * @param vertex_file_path: This is the file path for the vertex shader
- * @param fragment_file_path: This is the file path for the fragment shader
- * @return Returns an unsigned int that is the unique identifier for the new shader program
+ * This builds the source code of the shader at the passed file path, with its includes expanded and the passed
+ * defines injected into it (see ShaderPreprocessor.h).
+ * @param file_path: This is the file path for the shader
+ * @param defines: The defines to inject
+ * @param out_code: This will hold the source code once it has been built. Passed by reference.
+ * @param files: Every file the shader is made of is added to this list. Passed by reference.
+ * @return A boolean specifying if the files could be read or not.
  */
-GLuint LoadShaders(const char* vertex_file_path, const char* fragment_file_path)
+bool LoadShaderSource(const char* file_path, const std::vector<std::string>& defines, std::string& out_code,
+                      std::vector<std::string>& files)
+{
+    return PreprocessShader(file_path, defines, out_code, files);
+}
+
+/*
+ * This creates the shaders and the program for the passed source code and asks the driver to compile and link them.
+ * None of the results are queried here, which means that a driver that compiles in parallel is free to keep working
+ * in the background. The shaders are left attached to the program until FinishProgram is called.
+ * @return The id of the new (possibly still compiling) shader program
+ */
+GLuint SubmitProgram(const std::string& vertex_code, const std::string& fragment_code)
 {
     //these are the id's of the new shaders
     GLuint VertexShaderID = glCreateShader(GL_VERTEX_SHADER);
     GLuint FragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER);
 
-    //we will deal with the vertex shader first
-    //begin by reading the code from the appropriate file
-    std::string VertexShaderCode;
-    std::ifstream VertexShaderStream(vertex_file_path, std::ios::in);
+    //first we will compile the vertex shader source code
+    char const* VertexSourcePointer = vertex_code.c_str();
+    glShaderSource(VertexShaderID, 1, &VertexSourcePointer, NULL);
+    glCompileShader(VertexShaderID);
 
-    //if we have succeeded in opening our vertex shader file, read the data and place it in the vertex shader code
-    //string object
-    if(VertexShaderStream.is_open())
+    //now that this is done, we can compile our fragment shader
+    char const* FragmentSourcePointer = fragment_code.c_str();
+    glShaderSource(FragmentShaderID, 1, &FragmentSourcePointer, NULL);
+    glCompileShader(FragmentShaderID);
+
+    //now that both have been compiled we need to link them together
+    GLuint ProgramID = glCreateProgram();
+    glAttachShader(ProgramID, VertexShaderID);
+    glAttachShader(ProgramID, FragmentShaderID);
+    glLinkProgram(ProgramID);
+
+    return ProgramID;
+}
+
+/*
+ * This waits for the passed program to be done linking, collects the compile and link logs if anything failed, and
+ * then detaches and deletes its shaders.
+ * @param program: The program returned by SubmitProgram
+ * @param out_log: This will hold the compile and link logs if something failed. Passed by reference.
+ * @return A boolean specifying if the program was linked successfully or not.
+ */
+bool FinishProgram(GLuint program, std::string& out_log)
+{
+    GLint link_status;
+    glGetProgramiv(program, GL_LINK_STATUS, &link_status);
+
+    //we need the shaders both to read their logs and to delete them
+    GLuint shaders[2];
+    GLsizei shader_count = 0;
+    glGetAttachedShaders(program, 2, &shader_count, shaders);
+
+    if(link_status != GL_TRUE)
     {
-        std::stringstream sstr;
-        sstr << VertexShaderStream.rdbuf();
-        VertexShaderCode = sstr.str();
-        VertexShaderStream.close();
+        //the compile logs tell us which line of which shader failed, so we collect those before the link log
+        for(int i = 0; i < shader_count; i++)
+        {
+            GLint log_length;
+            glGetShaderiv(shaders[i], GL_INFO_LOG_LENGTH, &log_length);
+
+            if(log_length > 1)
+            {
+                std::vector<char> log(log_length);
+                glGetShaderInfoLog(shaders[i], log_length, NULL, &log[0]);
+                out_log += &log[0];
+            }
+        }
+
+        GLint log_length;
+        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &log_length);
+
+        if(log_length > 1)
+        {
+            std::vector<char> log(log_length);
+            glGetProgramInfoLog(program, log_length, NULL, &log[0]);
+            out_log += &log[0];
+        }
     }
 
-    else
+    //now that the program has been linked we can detach and delete the shaders
+    for(int i = 0; i < shader_count; i++)
     {
-        printf("Impossible to open the file at %s", vertex_file_path);
-        return 0;
+        glDetachShader(program, shaders[i]);
+        glDeleteShader(shaders[i]);
     }
 
-    //Now that we have read the source code for the Vertex shader, we need to do the same but with the fragment shader
-    //source code
+    return link_status == GL_TRUE;
+}
+
+/*
+ * This is the function implementation for loading shaders into a usable program
+ * @param vertex_file_path: This is the file path for the vertex shader
+ * @param fragment_file_path: This is the file path for the fragment shader
+ * @return Returns an unsigned int that is the unique identifier for the new shader program
+ */
+GLuint LoadShaders(const char* vertex_file_path, const char* fragment_file_path)
+{
+    return LoadShaders(vertex_file_path, fragment_file_path, std::vector<std::string>());
+}
 
+/*
+ * This is the same as the function above, except that each of the passed defines is injected into both the vertex and
+ * fragment shader source before they are compiled. This is what lets us build specialized permutations of a shader.
+ * @param defines: The defines to inject, each one being the text that follows #define (i.e. "LIGHT_ON true")
+ */
+GLuint LoadShaders(const char* vertex_file_path, const char* fragment_file_path, const std::vector<std::string>& defines)
+{
+    //we will deal with the vertex shader first, then we need to do the same with the fragment shader source code
+    std::string VertexShaderCode;
     std::string FragmentShaderCode;
-    std::ifstream FragmentShaderStream(fragment_file_path, std::ios::in);
+    std::vector<std::string> files;
 
-    if(FragmentShaderStream.is_open())
-    {
-        std::stringstream sstr;
-        sstr << FragmentShaderStream.rdbuf();
-        FragmentShaderCode = sstr.str();
-        FragmentShaderStream.close();
-    }
+    if(!LoadShaderSource(vertex_file_path, defines, VertexShaderCode, files))
+        return 0;
 
-    else
-    {
-        printf("Impossible to open the file at %s", fragment_file_path);
+    if(!LoadShaderSource(fragment_file_path, defines, FragmentShaderCode, files))
         return 0;
-    }
 
     //now that we have the source code from both shaders in memory, we need to compile that source code into
     //a program that can be used by our gpu in order to modify our objects
+    GLuint ProgramID = SubmitProgram(VertexShaderCode, FragmentShaderCode);
 
-    //first we will compile the vertex shader source code
-    char const* VertexSourcePointer = VertexShaderCode.c_str();
-    glShaderSource(VertexShaderID, 1, &VertexSourcePointer, NULL);
-    glCompileShader(VertexShaderID);
+    //since we need the program right away, we wait for the result here and report anything that went wrong
+    std::string log;
+    if(!FinishProgram(ProgramID, log))
+        std::cout << "Failed to link " << vertex_file_path << " and " << fragment_file_path << ":\n"
+                  << MapShaderLog(log, files) << std::endl;
 
-    //now that this is done, we can compile our fragment shader
-    char const* FragmentSourcePointer = FragmentShaderCode.c_str();
-    glShaderSource(FragmentShaderID, 1, &FragmentSourcePointer, NULL);
-    glCompileShader(FragmentShaderID);
+    return ProgramID;
+}
+
+/*
+ * This loads a compute shader into a program of its own. Unlike the programs above, it is only ever built once (it does
+ * not have permutations), so it is compiled and linked right away.
+ * @param file_path: This is the file path for the compute shader
+ * @param defines: The defines to inject
+ * @return The id of the new shader program, or 0 if something went wrong
+ */
+GLuint LoadComputeShader(const char* file_path, const std::vector<std::string>& defines)
+{
+    std::string ComputeShaderCode;
+    std::vector<std::string> files;
+    if(!LoadShaderSource(file_path, defines, ComputeShaderCode, files))
+        return 0;
+
+    GLuint ComputeShaderID = glCreateShader(GL_COMPUTE_SHADER);
+    char const* ComputeSourcePointer = ComputeShaderCode.c_str();
+    glShaderSource(ComputeShaderID, 1, &ComputeSourcePointer, NULL);
+    glCompileShader(ComputeShaderID);
 
-    //now that both have been compiled we need to link them together
     GLuint ProgramID = glCreateProgram();
-    glAttachShader(ProgramID, VertexShaderID);
-    glAttachShader(ProgramID, FragmentShaderID);
+    glAttachShader(ProgramID, ComputeShaderID);
     glLinkProgram(ProgramID);
 
-    //now that the program has been linked we can detach and delete the shaders and return the program id
-    glDetachShader(ProgramID, VertexShaderID);
-    glDetachShader(ProgramID, FragmentShaderID);
-    glDeleteShader(VertexShaderID);
-    glDeleteShader(FragmentShaderID);
+    //FinishProgram collects the logs of whatever shaders are attached, so it works the same for a single one
+    std::string log;
+    if(!FinishProgram(ProgramID, log))
+    {
+        std::cout << "Failed to link " << file_path << ":\n" << MapShaderLog(log, files) << std::endl;
+        glDeleteProgram(ProgramID);
+        return 0;
+    }
 
     return ProgramID;
 }
-
@@ -3,9 +3,44 @@
 #endif
 #include <glew.h>
 #include <GLFW/glfw3.h>
+#include <string>
+#include <vector>
 //this contains static function definitions for the shader loader class
 
 /*
  * This method is used to load a vertex shader and a fragment shader into a usable program and return its reference.
  */
-GLuint LoadShaders(const char* vertex_file_path, const char* fragment_file_path);
\ No newline at end of file
+GLuint LoadShaders(const char* vertex_file_path, const char* fragment_file_path);
+
+/*
+ * This method does the same as the one above, but it also injects a #define for each of the passed defines into the
+ * source of both shaders. This is used to compile specialized permutations of the same shader files.
+ */
+GLuint LoadShaders(const char* vertex_file_path, const char* fragment_file_path, const std::vector<std::string>& defines);
+
+/*
+ * This method loads a compute shader (OpenGL 4.3) into a usable program, with a #define for each of the passed defines
+ * injected into its source. Returns 0 if it could not be read or linked.
+ */
+GLuint LoadComputeShader(const char* file_path, const std::vector<std::string>& defines);
+
+/*
+ * This method builds the shader source at the passed file path into out_code, with its includes expanded and the
+ * passed defines injected into it. Every file it is made of is added to files. Returns false if a file could not be
+ * opened.
+ */
+bool LoadShaderSource(const char* file_path, const std::vector<std::string>& defines, std::string& out_code,
+                      std::vector<std::string>& files);
+
+/*
+ * This method creates, compiles and links a program from the passed sources without waiting for any of the results,
+ * so that drivers that compile in parallel can keep working in the background. FinishProgram must be called on the
+ * returned program once it is done.
+ */
+GLuint SubmitProgram(const std::string& vertex_code, const std::string& fragment_code);
+
+/*
+ * This method checks the link status of a program returned by SubmitProgram, collects the compile and link logs into
+ * out_log if it failed, and deletes its shaders. Returns true if the program was linked successfully.
+ */
+bool FinishProgram(GLuint program, std::string& out_log);
\ No newline at end of file
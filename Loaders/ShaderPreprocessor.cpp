@@ -0,0 +1,254 @@
+#include "ShaderPreprocessor.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <sys/stat.h>
+
+/*
+ * This is what the source cache keeps for each file: its text and its modification time when it was read.
+ */
+struct CachedSource
+{
+    std::string text;
+    time_t modified;
+};
+
+//the source cache. Shaders can be preprocessed by the compiler's worker thread, so it is guarded by a mutex.
+static std::map<std::string, CachedSource> source_cache;
+static std::mutex source_cache_mutex;
+
+/*
+ * This returns the modification time of the file at the passed path, or 0 if it does not exist.
+ */
+static time_t GetModificationTime(const std::string& file_path)
+{
+    struct stat file_info;
+    if(stat(file_path.c_str(), &file_info) != 0)
+        return 0;
+
+    return file_info.st_mtime;
+}
+
+/*
+ * This returns the text of the file at the passed path, reading it from disk only if it is not in the source cache.
+ */
+static bool GetSource(const std::string& file_path, std::string& out_text)
+{
+    std::lock_guard<std::mutex> lock(source_cache_mutex);
+
+    std::map<std::string, CachedSource>::iterator cached = source_cache.find(file_path);
+    if(cached != source_cache.end())
+    {
+        out_text = cached->second.text;
+        return true;
+    }
+
+    std::ifstream ShaderStream(file_path.c_str(), std::ios::in);
+    if(!ShaderStream.is_open())
+        return false;
+
+    std::stringstream sstr;
+    sstr << ShaderStream.rdbuf();
+
+    CachedSource source;
+    source.text = sstr.str();
+    source.modified = GetModificationTime(file_path);
+    source_cache[file_path] = source;
+
+    out_text = source.text;
+    return true;
+}
+
+/*
+ * This returns the index of the passed file in the list, adding it at the end if it is not in it yet.
+ */
+static int GetSourceNumber(const std::string& file_path, std::vector<std::string>& files)
+{
+    std::vector<std::string>::iterator found = std::find(files.begin(), files.end(), file_path);
+    if(found != files.end())
+        return found - files.begin();
+
+    files.push_back(file_path);
+    return files.size() - 1;
+}
+
+/*
+ * This appends the expanded source of the passed file to out_code. The included list holds every file that has been
+ * included so far in this shader, and the include stack holds the files that are currently being expanded.
+ */
+static bool ExpandFile(const std::string& file_path, const std::vector<std::string>& defines, std::string& out_code,
+                       std::vector<std::string>& files, std::vector<std::string>& included,
+                       std::vector<std::string>& include_stack)
+{
+    std::string text;
+    if(!GetSource(file_path, text))
+    {
+        printf("Impossible to open the file at %s\n", file_path.c_str());
+        return false;
+    }
+
+    int source_number = GetSourceNumber(file_path, files);
+    included.push_back(file_path);
+    include_stack.push_back(file_path);
+
+    //includes are relative to the directory of the file that includes them
+    std::string::size_type last_slash = file_path.find_last_of("/\\");
+    std::string directory = last_slash == std::string::npos ? "" : file_path.substr(0, last_slash + 1);
+
+    std::stringstream output;
+    std::istringstream input(text);
+    std::string line;
+    int line_number = 0;
+
+    while(std::getline(input, line))
+    {
+        line_number++;
+
+        std::string::size_type first = line.find_first_not_of(" \t");
+        std::string directive = first == std::string::npos ? "" : line.substr(first);
+
+        if(directive.compare(0, 8, "#version") == 0)
+        {
+            //GLSL needs the #version to come first, so the defines go right after it. Since we are adding lines, we
+            //need to tell the compiler which line of which file comes next.
+            output << line << "\n";
+            for(int i = 0; i < defines.size(); i++)
+                output << "#define " << defines[i] << "\n";
+            output << "#line " << line_number + 1 << " " << source_number << "\n";
+        }
+
+        else if(directive.compare(0, 8, "#include") == 0)
+        {
+            std::string::size_type open_quote = directive.find('"');
+            std::string::size_type close_quote = directive.find('"', open_quote + 1);
+
+            if(open_quote == std::string::npos || close_quote == std::string::npos)
+            {
+                printf("Invalid #include at line %d of %s\n", line_number, file_path.c_str());
+                return false;
+            }
+
+            std::string include_path = directory + directive.substr(open_quote + 1, close_quote - open_quote - 1);
+
+            if(std::find(include_stack.begin(), include_stack.end(), include_path) != include_stack.end())
+            {
+                printf("%s includes itself (through line %d of %s)\n", include_path.c_str(), line_number,
+                       file_path.c_str());
+                return false;
+            }
+
+            //every file acts as if it had include guards, so a file that was already included is skipped. We still
+            //write an empty line so that the line numbers of this file do not change.
+            if(std::find(included.begin(), included.end(), include_path) != included.end())
+            {
+                output << "\n";
+                continue;
+            }
+
+            std::string included_code;
+            if(!ExpandFile(include_path, std::vector<std::string>(), included_code, files, included, include_stack))
+                return false;
+
+            output << "#line 1 " << GetSourceNumber(include_path, files) << "\n";
+            output << included_code;
+            output << "#line " << line_number + 1 << " " << source_number << "\n";
+        }
+
+        else
+        {
+            output << line << "\n";
+        }
+    }
+
+    include_stack.pop_back();
+    out_code += output.str();
+    return true;
+}
+
+bool PreprocessShader(const std::string& file_path, const std::vector<std::string>& defines, std::string& out_code,
+                      std::vector<std::string>& files)
+{
+    std::vector<std::string> included;
+    std::vector<std::string> include_stack;
+
+    out_code.clear();
+    return ExpandFile(file_path, defines, out_code, files, included, include_stack);
+}
+
+std::string MapShaderLog(const std::string& log, const std::vector<std::string>& files)
+{
+    std::stringstream output;
+    std::istringstream input(log);
+    std::string line;
+
+    while(std::getline(input, line))
+    {
+        //some drivers start the lines with "ERROR: " or "WARNING: " before the source string number
+        std::string::size_type start = 0;
+        if(line.compare(0, 7, "ERROR: ") == 0)
+            start = 7;
+        else if(line.compare(0, 9, "WARNING: ") == 0)
+            start = 9;
+
+        //the source string number is followed by either ':' or '(' and then the line number
+        std::string::size_type end = line.find_first_not_of("0123456789", start);
+
+        if(end != std::string::npos && end > start && (line[end] == ':' || line[end] == '(') &&
+           end + 1 < line.length() && isdigit(line[end + 1]))
+        {
+            int source_number = atoi(line.substr(start, end - start).c_str());
+            std::string::size_type line_end = line.find_first_not_of("0123456789", end + 1);
+            if(line_end == std::string::npos)
+                line_end = line.length();
+
+            if(source_number < files.size())
+            {
+                //with the "0(12)" format the closing bracket goes away along with the source string number
+                std::string rest = line.substr(line_end);
+                if(line[end] == '(' && !rest.empty() && rest[0] == ')')
+                    rest = rest.substr(1);
+
+                output << line.substr(0, start) << files[source_number] << ":"
+                       << line.substr(end + 1, line_end - end - 1) << rest << "\n";
+                continue;
+            }
+        }
+
+        output << line << "\n";
+    }
+
+    return output.str();
+}
+
+std::vector<std::string> RefreshShaderSources()
+{
+    std::lock_guard<std::mutex> lock(source_cache_mutex);
+    std::vector<std::string> changed;
+
+    for(std::map<std::string, CachedSource>::iterator it = source_cache.begin(); it != source_cache.end();)
+    {
+        if(GetModificationTime(it->first) != it->second.modified)
+        {
+            changed.push_back(it->first);
+            source_cache.erase(it++);
+        }
+
+        else
+        {
+            ++it;
+        }
+    }
+
+    return changed;
+}
+
+void InvalidateShaderSource(const std::string& file_path)
+{
+    std::lock_guard<std::mutex> lock(source_cache_mutex);
+    source_cache.erase(file_path);
+}
@@ -0,0 +1,43 @@
+#ifndef COMP_371_A2_SHADERPREPROCESSOR_H
+#define COMP_371_A2_SHADERPREPROCESSOR_H
+
+#include <string>
+#include <vector>
+
+//this contains the definitions for the shader preprocessor, which runs before the source code is handed to OpenGL.
+//It expands #include "file" directives (relative to the including file), injects defines after the #version line
+//and emits #line directives so that the compile log can be mapped back to the right line of the right file. Every
+//file is read from disk once and kept in a source cache until it is found to have changed.
+
+/*
+ * This method builds the complete source code for the shader at the passed file path.
+ * Each file is included at most once per shader (as if every file had include guards), and an include that would
+ * include itself is reported as an error.
+ * @param file_path: The file path of the shader
+ * @param defines: The defines to inject after the #version line, each one being the text that follows #define
+ * @param out_code: This will hold the complete source code. Passed by reference.
+ * @param files: Every file the shader is made of is added to this list (if it is not in it already), and its index
+ * in the list is used as its source string number in the #line directives. Passed by reference.
+ * @return A boolean specifying if all of the files could be read or not.
+ */
+bool PreprocessShader(const std::string& file_path, const std::vector<std::string>& defines, std::string& out_code,
+                      std::vector<std::string>& files);
+
+/*
+ * This method rewrites the source string numbers at the start of each line of a compile log (i.e. "0:12(5): error"
+ * or "0(12) : error") into the name of the file from the list filled by PreprocessShader (i.e. "Lighting.glsl:12").
+ */
+std::string MapShaderLog(const std::string& log, const std::vector<std::string>& files);
+
+/*
+ * This method checks the modification time of every file in the source cache. The ones that changed since they were
+ * read are dropped from the cache (so they are read again the next time they are needed) and returned.
+ */
+std::vector<std::string> RefreshShaderSources();
+
+/*
+ * This method drops the passed file from the source cache, so it is read again the next time it is needed.
+ */
+void InvalidateShaderSource(const std::string& file_path);
+
+#endif //COMP_371_A2_SHADERPREPROCESSOR_H
@@ -0,0 +1,129 @@
+#include "ShaderReflection.h"
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <vector>
+
+/*
+ * This is one of the active uniforms of a program, as reported by glGetActiveUniform.
+ */
+struct UniformInfo
+{
+    GLint location;
+    GLenum type;
+};
+
+//the handles for every program we have reflected on so far
+static std::map<GLuint, ProgramUniforms> reflected_programs;
+
+/*
+ * This returns a readable name for the GLSL types we use, for the error messages.
+ */
+static const char* TypeName(GLenum type)
+{
+    switch(type)
+    {
+        case GL_FLOAT: return "float";
+        case GL_INT: return "int";
+        case GL_BOOL: return "bool";
+        case GL_FLOAT_VEC3: return "vec3";
+        case GL_FLOAT_VEC4: return "vec4";
+        case GL_FLOAT_MAT3: return "mat3";
+        case GL_FLOAT_MAT4: return "mat4";
+        default: return "another type";
+    }
+}
+
+/*
+ * This resolves the passed handle from the table of active uniforms. Uniforms that are not in the table are simply
+ * left at -1, but a uniform that is declared with a different type than the handle is reported.
+ */
+template<typename T>
+static bool Resolve(const std::map<std::string, UniformInfo>& active_uniforms, const char* name, Uniform<T>& handle,
+                    std::stringstream& errors)
+{
+    std::map<std::string, UniformInfo>::const_iterator found = active_uniforms.find(name);
+    if(found == active_uniforms.end())
+        return true;
+
+    if(found->second.type != UniformType<T>::gl_type)
+    {
+        errors << "uniform " << name << " is declared as " << TypeName(found->second.type) << " but is set as "
+               << TypeName(UniformType<T>::gl_type) << "\n";
+        return false;
+    }
+
+    handle.location = found->second.location;
+    return true;
+}
+
+bool ReflectProgram(GLuint program, std::string& out_errors)
+{
+    //first we build the table of every active uniform in the program
+    std::map<std::string, UniformInfo> active_uniforms;
+
+    GLint uniform_count = 0;
+    GLint max_name_length = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &uniform_count);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_name_length);
+    std::vector<char> name(max_name_length + 1);
+
+    for(GLint i = 0; i < uniform_count; i++)
+    {
+        GLint size;
+        GLenum type;
+        glGetActiveUniform(program, i, name.size(), NULL, &size, &type, &name[0]);
+
+        //arrays are reported as "name[0]", but we refer to them by their name
+        std::string uniform_name(&name[0]);
+        std::string::size_type bracket = uniform_name.find('[');
+        if(bracket != std::string::npos)
+            uniform_name = uniform_name.substr(0, bracket);
+
+        UniformInfo info;
+        info.location = glGetUniformLocation(program, &name[0]);
+        info.type = type;
+        active_uniforms[uniform_name] = info;
+    }
+
+    //then we resolve each of our handles from it
+    ProgramUniforms uniforms;
+    uniforms.program = program;
+    std::stringstream errors;
+    bool valid = true;
+
+    valid &= Resolve(active_uniforms, "model_matrix", uniforms.model_matrix, errors);
+    valid &= Resolve(active_uniforms, "view_matrix", uniforms.view_matrix, errors);
+    valid &= Resolve(active_uniforms, "projection_matrix", uniforms.projection_matrix, errors);
+    valid &= Resolve(active_uniforms, "red_channel", uniforms.red_channel, errors);
+    valid &= Resolve(active_uniforms, "green_channel", uniforms.green_channel, errors);
+    valid &= Resolve(active_uniforms, "blue_channel", uniforms.blue_channel, errors);
+    valid &= Resolve(active_uniforms, "light_on", uniforms.light_on, errors);
+    valid &= Resolve(active_uniforms, "normal_as_color", uniforms.normal_as_color, errors);
+    valid &= Resolve(active_uniforms, "gray_scale", uniforms.gray_scale, errors);
+    valid &= Resolve(active_uniforms, "light_position", uniforms.light_position, errors);
+    valid &= Resolve(active_uniforms, "light_color", uniforms.light_color, errors);
+    valid &= Resolve(active_uniforms, "view_position", uniforms.view_position, errors);
+
+    reflected_programs[program] = uniforms;
+    out_errors = errors.str();
+    return valid;
+}
+
+const ProgramUniforms& GetProgramUniforms(GLuint program)
+{
+    std::map<GLuint, ProgramUniforms>::iterator found = reflected_programs.find(program);
+    if(found != reflected_programs.end())
+        return found->second;
+
+    std::string errors;
+    if(!ReflectProgram(program, errors))
+        std::cout << "Shader program " << program << " has mismatched uniforms:\n" << errors << std::endl;
+
+    return reflected_programs[program];
+}
+
+void ForgetProgram(GLuint program)
+{
+    reflected_programs.erase(program);
+}
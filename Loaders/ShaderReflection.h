@@ -0,0 +1,105 @@
+#ifndef COMP_371_A2_SHADERREFLECTION_H
+#define COMP_371_A2_SHADERREFLECTION_H
+
+#include <glew.h>
+#include <GLFW/glfw3.h>
+#include <string>
+#include "../GLM/glm/matrix.hpp"
+#include "../GLM/glm/gtc/type_ptr.hpp"
+
+//this contains the definitions for reflecting on linked shader programs. When a program is done linking, its active
+//uniforms are listed with glGetActiveUniform and matched to the typed handles in ProgramUniforms, so that the rest of
+//the program can set uniforms without looking them up by name or asking OpenGL anything.
+
+/*
+ * This maps each C++ type a uniform can have to the GLSL type it must be declared with.
+ */
+template<typename T> struct UniformType;
+template<> struct UniformType<float> { static const GLenum gl_type = GL_FLOAT; };
+template<> struct UniformType<int> { static const GLenum gl_type = GL_INT; };
+template<> struct UniformType<glm::vec3> { static const GLenum gl_type = GL_FLOAT_VEC3; };
+template<> struct UniformType<glm::mat4> { static const GLenum gl_type = GL_FLOAT_MAT4; };
+
+/*
+ * This is a handle to a uniform of type T. The location is -1 if the program does not use the uniform (i.e. it was
+ * optimized out, or baked into a permutation), in which case setting it does nothing.
+ */
+template<typename T> struct Uniform
+{
+    GLint location;
+
+    Uniform() : location(-1) {}
+};
+
+/*
+ * These set the value of a uniform in the current program through its handle.
+ */
+inline void SetUniform(const Uniform<float>& uniform, float value)
+{
+    glUniform1f(uniform.location, value);
+}
+
+inline void SetUniform(const Uniform<int>& uniform, int value)
+{
+    glUniform1i(uniform.location, value);
+}
+
+inline void SetUniform(const Uniform<glm::vec3>& uniform, const glm::vec3& value)
+{
+    glUniform3fv(uniform.location, 1, glm::value_ptr(value));
+}
+
+inline void SetUniform(const Uniform<glm::mat4>& uniform, const glm::mat4& value)
+{
+    glUniformMatrix4fv(uniform.location, 1, GL_FALSE, &value[0][0]);
+}
+
+/*
+ * This holds a handle for every uniform used by our shaders. It is filled in once, when the program is done linking.
+ */
+struct ProgramUniforms
+{
+    GLuint program;
+
+    //the Model View Projection matrices
+    Uniform<glm::mat4> model_matrix;
+    Uniform<glm::mat4> view_matrix;
+    Uniform<glm::mat4> projection_matrix;
+
+    //the toggles (these only exist in the uber-shaders)
+    Uniform<float> red_channel;
+    Uniform<float> green_channel;
+    Uniform<float> blue_channel;
+    Uniform<int> light_on;
+    Uniform<int> normal_as_color;
+    Uniform<int> gray_scale;
+
+    //the light (see Lighting.glsl)
+    Uniform<glm::vec3> light_position;
+    Uniform<glm::vec3> light_color;
+    Uniform<glm::vec3> view_position;
+
+    ProgramUniforms() : program(0) {}
+};
+
+/*
+ * This method lists the active uniforms of the passed (linked) program and resolves the handles for it. The result is
+ * kept, so this only talks to OpenGL once per program.
+ * @param program: The id of the linked program
+ * @param out_errors: This will describe every uniform declared with a different type than its handle expects.
+ * Passed by reference.
+ * @return false if any of the uniforms had the wrong type, in which case the program should not be used
+ */
+bool ReflectProgram(GLuint program, std::string& out_errors);
+
+/*
+ * This method returns the handles for the passed program, reflecting on it first if that has not been done yet.
+ */
+const ProgramUniforms& GetProgramUniforms(GLuint program);
+
+/*
+ * This method drops what was kept for the passed program. It should be called when the program is deleted.
+ */
+void ForgetProgram(GLuint program);
+
+#endif //COMP_371_A2_SHADERREFLECTION_H
@@ -0,0 +1,251 @@
+#include "ShaderVariants.h"
+#include "ShaderLoader.h"
+#include "ShaderCompiler.h"
+#include "ShaderReflection.h"
+#include <algorithm>
+#include <map>
+#include <iostream>
+
+//the shader files for both of the illumination models
+static const char* PHONG_VERTEX_SHADER = "../Shaders/PhongVertexShader.glsl";
+static const char* PHONG_FRAGMENT_SHADER = "../Shaders/PhongFragmentShader.glsl";
+static const char* GOURAUD_VERTEX_SHADER = "../Shaders/GouraudVertexShader.glsl";
+static const char* GOURAUD_FRAGMENT_SHADER = "../Shaders/GouraudFragmentShader.glsl";
+
+//the cheap shaders used while the program we actually want is still compiling
+static const char* FALLBACK_VERTEX_SHADER = "../Shaders/FallbackVertexShader.glsl";
+static const char* FALLBACK_FRAGMENT_SHADER = "../Shaders/FallbackFragmentShader.glsl";
+
+//the bits used in the cache key to tell the illumination models and the uber-shaders apart (they sit above all of
+//the toggle bits)
+static const unsigned int GOURAUD_KEY_BIT = 1 << 7;
+static const unsigned int UBER_KEY_BIT = 1 << 8;
+
+/*
+ * This is what we keep for each program in the cache. While the program is compiling, the job is set and the program
+ * is 0 (or still the previous version of the program, if it is being recompiled). Once the job is done, the program
+ * is replaced (unless it failed) and the job is dropped.
+ */
+struct VariantEntry
+{
+    std::string vertex_file_path;
+    std::string fragment_file_path;
+    std::vector<std::string> defines;
+    std::vector<std::string> files; //every file the program was built from, so we know when it needs recompiling
+
+    ShaderJobPtr job;
+    GLuint program;
+    bool stale; //set if one of the files changed while the job was running, since it may have read the old version
+};
+
+//these hold every program we have compiled (or started compiling) so far, keyed by the toggles and the bits above
+static std::map<unsigned int, VariantEntry> variant_cache;
+static GLuint fallback_shaders[2] = {0, 0}; //the regular and the instanced version
+
+/*
+ * This returns the program for the passed cache key, submitting it for compilation if this is the first time it is
+ * requested. Returns 0 while the program is still compiling.
+ */
+static GLuint GetProgram(unsigned int key, GLboolean gouraud, const std::vector<std::string>& defines)
+{
+    //if we have already compiled (or started to compile) this program, then we can just hand back what we have
+    std::map<unsigned int, VariantEntry>::iterator cached = variant_cache.find(key);
+    if(cached != variant_cache.end())
+        return cached->second.program;
+
+    //otherwise this is the first time it is used and we need to submit it
+    VariantEntry entry;
+    entry.vertex_file_path = gouraud ? GOURAUD_VERTEX_SHADER : PHONG_VERTEX_SHADER;
+    entry.fragment_file_path = gouraud ? GOURAUD_FRAGMENT_SHADER : PHONG_FRAGMENT_SHADER;
+    entry.defines = defines;
+    entry.program = 0;
+    entry.stale = false;
+    entry.job = SubmitShaders(entry.vertex_file_path.c_str(), entry.fragment_file_path.c_str(), defines);
+
+    variant_cache[key] = entry;
+
+    //with a blocking compiler the job may already be done, in which case there is no need to wait for a frame
+    UpdateShaderVariants();
+    return variant_cache[key].program;
+}
+
+std::vector<std::string> GetToggleDefines(unsigned int toggles)
+{
+    std::vector<std::string> defines;
+
+    //this tells the shaders to use the defines below instead of declaring the uniforms
+    defines.push_back("PERMUTATION");
+
+    defines.push_back(toggles & TOGGLE_RED_CHANNEL ? "RED_CHANNEL 1.0" : "RED_CHANNEL 0.0");
+    defines.push_back(toggles & TOGGLE_GREEN_CHANNEL ? "GREEN_CHANNEL 1.0" : "GREEN_CHANNEL 0.0");
+    defines.push_back(toggles & TOGGLE_BLUE_CHANNEL ? "BLUE_CHANNEL 1.0" : "BLUE_CHANNEL 0.0");
+    defines.push_back(toggles & TOGGLE_LIGHT_ON ? "LIGHT_ON true" : "LIGHT_ON false");
+    defines.push_back(toggles & TOGGLE_NORMAL_AS_COLOR ? "NORMAL_AS_COLOR true" : "NORMAL_AS_COLOR false");
+    defines.push_back(toggles & TOGGLE_GRAY_SCALE ? "GRAY_SCALE true" : "GRAY_SCALE false");
+
+    //the shaders check for this one with #ifdef, since it changes their inputs
+    if(toggles & TOGGLE_INSTANCED)
+        defines.push_back("INSTANCED");
+
+    return defines;
+}
+
+GLuint GetShaderVariant(GLboolean gouraud, unsigned int toggles)
+{
+    unsigned int key = gouraud ? (toggles | GOURAUD_KEY_BIT) : toggles;
+
+    //the first time a permutation is requested we let the user know that it needs to be compiled
+    if(variant_cache.find(key) == variant_cache.end())
+        std::cout << "Compiling " << (gouraud ? "Gouraud" : "Phong") << " permutation ["
+                  << DescribeToggles(toggles) << "]..." << std::endl;
+
+    return GetProgram(key, gouraud, GetToggleDefines(toggles));
+}
+
+bool HasShaderVariant(GLboolean gouraud, unsigned int toggles)
+{
+    unsigned int key = gouraud ? (toggles | GOURAUD_KEY_BIT) : toggles;
+    std::map<unsigned int, VariantEntry>::iterator cached = variant_cache.find(key);
+    return cached != variant_cache.end() && cached->second.program != 0;
+}
+
+GLuint GetUberShader(GLboolean gouraud, GLboolean instanced)
+{
+    unsigned int key = gouraud ? (UBER_KEY_BIT | GOURAUD_KEY_BIT) : UBER_KEY_BIT;
+    std::vector<std::string> defines;
+
+    if(instanced)
+    {
+        key |= TOGGLE_INSTANCED;
+        defines.push_back("INSTANCED");
+    }
+
+    return GetProgram(key, gouraud, defines);
+}
+
+GLuint GetFallbackShader(GLboolean instanced)
+{
+    //this one is small enough that we can afford to compile it on the spot, and we need it before anything else
+    GLuint& fallback_shader = fallback_shaders[instanced ? 1 : 0];
+    if(fallback_shader == 0)
+    {
+        std::vector<std::string> defines;
+        if(instanced)
+            defines.push_back("INSTANCED");
+
+        fallback_shader = LoadShaders(FALLBACK_VERTEX_SHADER, FALLBACK_FRAGMENT_SHADER, defines);
+    }
+
+    return fallback_shader;
+}
+
+int UpdateShaderVariants()
+{
+    int replaced = 0;
+
+    for(std::map<unsigned int, VariantEntry>::iterator it = variant_cache.begin(); it != variant_cache.end(); ++it)
+    {
+        VariantEntry& entry = it->second;
+
+        if(entry.job && PollShaders(entry.job))
+        {
+            //the uniforms of the new program are resolved right away, which also catches any uniform declared with
+            //a different type than the one we set it as
+            std::string errors;
+            if(entry.job->program != 0 && !ReflectProgram(entry.job->program, errors))
+            {
+                std::cout << "Rejected " << entry.job->vertex_file_path << " and " << entry.job->fragment_file_path
+                          << ":\n" << errors << std::endl;
+                ForgetProgram(entry.job->program);
+                glDeleteProgram(entry.job->program);
+                entry.job->program = 0;
+            }
+
+            //if the new program failed, we keep on using the previous one (the log has already been printed)
+            if(entry.job->program != 0)
+            {
+                if(entry.program != 0)
+                {
+                    ForgetProgram(entry.program);
+                    glDeleteProgram(entry.program);
+                    replaced++;
+                }
+
+                entry.program = entry.job->program;
+            }
+
+            //the files are kept even when the program failed, so that fixing any of them compiles it again. A file that
+            //could not be read stops the preprocessor before the ones after it, so the two shaders are always added
+            entry.files = entry.job->files;
+            if(std::find(entry.files.begin(), entry.files.end(), entry.vertex_file_path) == entry.files.end())
+                entry.files.push_back(entry.vertex_file_path);
+            if(std::find(entry.files.begin(), entry.files.end(), entry.fragment_file_path) == entry.files.end())
+                entry.files.push_back(entry.fragment_file_path);
+
+            entry.job.reset();
+
+            if(entry.stale)
+            {
+                entry.stale = false;
+                entry.job = SubmitShaders(entry.vertex_file_path.c_str(), entry.fragment_file_path.c_str(),
+                                          entry.defines);
+            }
+        }
+    }
+
+    return replaced;
+}
+
+int ReloadShaderFiles(const std::vector<std::string>& changed_files)
+{
+    int recompiled = 0;
+
+    for(std::map<unsigned int, VariantEntry>::iterator it = variant_cache.begin(); it != variant_cache.end(); ++it)
+    {
+        VariantEntry& entry = it->second;
+
+        //only the programs that were built from one of the changed files need to be recompiled
+        bool depends_on_changed_file = false;
+        for(int i = 0; i < changed_files.size() && !depends_on_changed_file; i++)
+            depends_on_changed_file =
+                    std::find(entry.files.begin(), entry.files.end(), changed_files[i]) != entry.files.end();
+
+        //a program that is still compiling may have read the old version of the file (and we do not know which files
+        //it is made of until it is done), so it is submitted again once it is done
+        if(entry.job)
+        {
+            entry.stale = true;
+            continue;
+        }
+
+        if(!depends_on_changed_file)
+            continue;
+
+        entry.job = SubmitShaders(entry.vertex_file_path.c_str(), entry.fragment_file_path.c_str(), entry.defines);
+        recompiled++;
+    }
+
+    return recompiled;
+}
+
+std::string DescribeToggles(unsigned int toggles)
+{
+    std::string description;
+
+    if(toggles & TOGGLE_RED_CHANNEL)
+        description += "r";
+    if(toggles & TOGGLE_GREEN_CHANNEL)
+        description += "g";
+    if(toggles & TOGGLE_BLUE_CHANNEL)
+        description += "b";
+    if(toggles & TOGGLE_LIGHT_ON)
+        description += " light";
+    if(toggles & TOGGLE_NORMAL_AS_COLOR)
+        description += " normal";
+    if(toggles & TOGGLE_GRAY_SCALE)
+        description += " gray";
+    if(toggles & TOGGLE_INSTANCED)
+        description += " instanced";
+
+    return description.empty() ? "none" : description;
+}
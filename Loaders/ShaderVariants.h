@@ -0,0 +1,87 @@
+#ifndef COMP_371_A2_SHADERVARIANTS_H
+#define COMP_371_A2_SHADERVARIANTS_H
+
+#include <glew.h>
+#include <GLFW/glfw3.h>
+#include <string>
+#include <vector>
+
+//this contains the definitions for the shader permutation system. Each combination of the toggles below is compiled
+//into its own specialized program (with the toggles baked in as defines) the first time it is needed. The programs
+//are compiled without blocking (see ShaderCompiler.h), so a program that is still compiling is returned as 0 and the
+//fallback shader should be used in the meantime.
+
+/*
+ * These are the bit flags for each of the toggles that can be baked into a shader permutation.
+ */
+enum ShaderToggle
+{
+    TOGGLE_RED_CHANNEL = 1 << 0,
+    TOGGLE_GREEN_CHANNEL = 1 << 1,
+    TOGGLE_BLUE_CHANNEL = 1 << 2,
+    TOGGLE_LIGHT_ON = 1 << 3,
+    TOGGLE_NORMAL_AS_COLOR = 1 << 4,
+    TOGGLE_GRAY_SCALE = 1 << 5,
+    TOGGLE_INSTANCED = 1 << 6 //each instance reads its own model matrix from the instance buffer (see InstanceBuffer.h)
+};
+
+//the toggles the program starts with (all channels on, light on, normal as color and grayscale off)
+const unsigned int DEFAULT_TOGGLES = TOGGLE_RED_CHANNEL | TOGGLE_GREEN_CHANNEL | TOGGLE_BLUE_CHANNEL | TOGGLE_LIGHT_ON;
+
+/*
+ * This method returns the list of defines that bakes the passed toggles into a shader permutation.
+ * @param toggles: A combination of the ShaderToggle flags
+ * @return The defines to pass to LoadShaders
+ */
+std::vector<std::string> GetToggleDefines(unsigned int toggles);
+
+/*
+ * This method returns the program for the permutation of the Phong or Gouraud shaders matching the passed toggles.
+ * The program is submitted for compilation the first time that combination is requested and cached after that.
+ * @param gouraud: Whether the Gouraud (GL_TRUE) or Phong (GL_FALSE) illumination model is wanted
+ * @param toggles: A combination of the ShaderToggle flags
+ * @return The id of the specialized shader program, or 0 if it is still compiling (or failed to compile)
+ */
+GLuint GetShaderVariant(GLboolean gouraud, unsigned int toggles);
+
+/*
+ * This method tells us if the permutation matching the passed toggles has been compiled and is ready to be used.
+ */
+bool HasShaderVariant(GLboolean gouraud, unsigned int toggles);
+
+/*
+ * This method returns the uber-shader for the illumination model, which reads all of the toggles from uniforms at
+ * runtime. It is also compiled on first use and cached, and is 0 while it is still compiling.
+ * @param instanced: Whether the instanced version is wanted. This changes the inputs of the vertex shader, so it is
+ * always baked in.
+ */
+GLuint GetUberShader(GLboolean gouraud, GLboolean instanced);
+
+/*
+ * This method returns the cheap flat shaded program that is drawn with while the wanted program is still compiling.
+ * It is compiled (on the spot) the first time it is requested.
+ * @param instanced: Whether the instanced version is wanted
+ */
+GLuint GetFallbackShader(GLboolean instanced);
+
+/*
+ * This method checks on every program that is still compiling and keeps the ones that are done. It should be called
+ * once per frame.
+ * @return The number of programs that replaced a previous version of themselves (see ReloadShaderFiles)
+ */
+int UpdateShaderVariants();
+
+/*
+ * This method recompiles every program that was built from one of the passed files (i.e. a shared include that was
+ * edited). The programs that do not depend on them are left alone. The previous version of each program is kept in
+ * use until the new one is done compiling, and for good if the new one fails.
+ * @return The number of programs that were submitted for recompiling
+ */
+int ReloadShaderFiles(const std::vector<std::string>& changed_files);
+
+/*
+ * This method returns a short readable description of the passed toggles (i.e. "rgb light"), used when reporting.
+ */
+std::string DescribeToggles(unsigned int toggles);
+
+#endif //COMP_371_A2_SHADERVARIANTS_H
@@ -0,0 +1,141 @@
+#include "ShaderWatcher.h"
+#include "ShaderPreprocessor.h"
+#include "../Stats/Clock.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+//how long the watcher thread waits for changes before checking if it should stop (in milliseconds)
+static const int WATCH_INTERVAL_MS = 100;
+
+static std::thread watcher_thread;
+static std::atomic<bool> stop_watcher(false);
+
+//the changes that have not been taken by the render thread yet
+static std::mutex changes_mutex;
+static ShaderChanges pending_changes;
+
+/*
+ * This drops the changed file from the source cache (so nothing reads the old version again) and adds it to the
+ * pending changes.
+ */
+static void RecordChange(const std::string& file_path)
+{
+    InvalidateShaderSource(file_path);
+
+    std::lock_guard<std::mutex> lock(changes_mutex);
+
+    if(pending_changes.files.empty())
+        pending_changes.first_change_time = GetTime();
+
+    //editors often write a file more than once when saving, but it only needs to be reloaded once
+    if(std::find(pending_changes.files.begin(), pending_changes.files.end(), file_path) == pending_changes.files.end())
+        pending_changes.files.push_back(file_path);
+}
+
+#ifdef __linux__
+/*
+ * This is the loop run by the watcher thread on Linux. It waits for inotify to tell us about files in the directory
+ * that were written to, or moved into it (which is how many editors save).
+ */
+static void WatchLoop(std::string directory)
+{
+    int inotify_fd = inotify_init1(IN_NONBLOCK);
+    if(inotify_fd < 0 || inotify_add_watch(inotify_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    {
+        std::cout << "Unable to watch " << directory << " for shader changes" << std::endl;
+        if(inotify_fd >= 0)
+            close(inotify_fd);
+        return;
+    }
+
+    //the buffer needs to be aligned for the events that are read into it
+    alignas(struct inotify_event) char buffer[4096];
+
+    while(!stop_watcher.load())
+    {
+        struct pollfd poll_fd;
+        poll_fd.fd = inotify_fd;
+        poll_fd.events = POLLIN;
+
+        if(poll(&poll_fd, 1, WATCH_INTERVAL_MS) <= 0)
+            continue;
+
+        ssize_t length = read(inotify_fd, buffer, sizeof(buffer));
+
+        for(ssize_t offset = 0; offset < length;)
+        {
+            const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(buffer + offset);
+            offset += sizeof(struct inotify_event) + event->len;
+
+            if(event->len == 0)
+                continue;
+
+            //only the shader files matter (editors also write backup and swap files into the directory)
+            std::string name(event->name);
+            if(name.length() > 5 && name.compare(name.length() - 5, 5, ".glsl") == 0)
+                RecordChange(directory + name);
+        }
+    }
+
+    close(inotify_fd);
+}
+#else
+/*
+ * This is the loop run by the watcher thread when inotify is not available. It checks the modification time of every
+ * file in the source cache instead.
+ */
+static void WatchLoop(std::string directory)
+{
+    while(!stop_watcher.load())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(WATCH_INTERVAL_MS));
+
+        std::vector<std::string> changed_files = RefreshShaderSources();
+        for(int i = 0; i < changed_files.size(); i++)
+            RecordChange(changed_files[i]);
+    }
+}
+#endif
+
+void StartShaderWatcher(const std::string& directory)
+{
+    stop_watcher.store(false);
+    watcher_thread = std::thread(WatchLoop, directory);
+}
+
+void StopShaderWatcher()
+{
+    if(!watcher_thread.joinable())
+        return;
+
+    stop_watcher.store(true);
+    watcher_thread.join();
+}
+
+bool HasShaderChanges()
+{
+    std::lock_guard<std::mutex> lock(changes_mutex);
+    return !pending_changes.files.empty();
+}
+
+bool TakeShaderChanges(ShaderChanges& out_changes)
+{
+    std::lock_guard<std::mutex> lock(changes_mutex);
+
+    if(pending_changes.files.empty())
+        return false;
+
+    out_changes = pending_changes;
+    pending_changes.files.clear();
+    return true;
+}
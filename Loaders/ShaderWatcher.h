@@ -0,0 +1,44 @@
+#ifndef COMP_371_A2_SHADERWATCHER_H
+#define COMP_371_A2_SHADERWATCHER_H
+
+#include <string>
+#include <vector>
+
+//this contains the definitions for watching the shader directory for changes, so that the shaders can be hot-reloaded
+//while the program is running. The directory is watched by a separate thread (with inotify on Linux, and by checking
+//the modification times of the cached shader files everywhere else). Every changed file is dropped from the source
+//cache on that thread and handed to the render thread through TakeShaderChanges.
+
+/*
+ * This holds the shader files that changed since the last call to TakeShaderChanges.
+ */
+struct ShaderChanges
+{
+    std::vector<std::string> files;
+    double first_change_time; //the value of GetTime() when the first of the files was seen to change
+};
+
+/*
+ * This method starts watching the passed directory (which should end with a slash, i.e. "../Shaders/") on a
+ * separate thread.
+ */
+void StartShaderWatcher(const std::string& directory);
+
+/*
+ * This method stops the watcher thread.
+ */
+void StopShaderWatcher();
+
+/*
+ * This method checks if any files changed since the last call to TakeShaderChanges, without taking them.
+ */
+bool HasShaderChanges();
+
+/*
+ * This method hands over the files that changed since the last time it was called. It never blocks for long, so it
+ * can be called by the render thread once per frame.
+ * @return true if any files changed, in which case out_changes holds them
+ */
+bool TakeShaderChanges(ShaderChanges& out_changes);
+
+#endif //COMP_371_A2_SHADERWATCHER_H
@@ -0,0 +1,135 @@
+#include "DrawPackets.h"
+#include <algorithm>
+#include "../Threading/ParallelFor.h"
+
+void BuildDrawPackets(const std::vector<glm::mat4>& instance_matrices, const std::vector<int>& visible,
+                      int visible_count, const glm::vec4& depth_row, float near_depth, float far_depth,
+                      int mesh_count, DrawPacketLists& lists)
+{
+    lists.task_count = (visible_count + DRAW_PACKET_CHUNK_SIZE - 1) / DRAW_PACKET_CHUNK_SIZE;
+    if(lists.tasks.size() < lists.task_count)
+        lists.tasks.resize(lists.task_count);
+
+    float bucket_scale = DRAW_PACKET_DEPTH_BUCKETS / std::max(far_depth - near_depth, 1e-6f);
+
+    //the lists keep their memory from one frame to the next, so the tasks do not allocate once they have settled
+    ParallelFor(lists.task_count, [&](int index)
+    {
+        DrawPacketTask& task = lists.tasks[index];
+        int first = index * DRAW_PACKET_CHUNK_SIZE;
+        int count = std::min(first + DRAW_PACKET_CHUNK_SIZE, visible_count) - first;
+
+        //the depth of an instance is the one of its origin, which is enough to tell the near ones from the far ones
+        int bucket_counts[DRAW_PACKET_DEPTH_BUCKETS] = {0};
+        task.buckets.resize(count);
+        for(int i = 0; i < count; i++)
+        {
+            float depth = glm::dot(depth_row, instance_matrices[visible[first + i]][3]);
+            int bucket = std::min(std::max((int)((depth - near_depth) * bucket_scale), 0),
+                                  DRAW_PACKET_DEPTH_BUCKETS - 1);
+            task.buckets[i] = (unsigned char)bucket;
+            bucket_counts[bucket]++;
+        }
+
+        //then the instances are put in order of bucket (a counting sort, which keeps their order within each bucket)
+        int next[DRAW_PACKET_DEPTH_BUCKETS];
+        task.bucket_starts[0] = 0;
+        for(int bucket = 0; bucket < DRAW_PACKET_DEPTH_BUCKETS; bucket++)
+        {
+            next[bucket] = task.bucket_starts[bucket];
+            task.bucket_starts[bucket + 1] = task.bucket_starts[bucket] + bucket_counts[bucket];
+        }
+
+        task.instances.resize(count);
+        for(int i = 0; i < count; i++)
+            task.instances[next[task.buckets[i]]++] = visible[first + i];
+
+        //each bucket that holds instances is drawn with every mesh
+        task.packets.clear();
+        for(int bucket = 0; bucket < DRAW_PACKET_DEPTH_BUCKETS; bucket++)
+        {
+            if(bucket_counts[bucket] == 0)
+                continue;
+
+            for(int mesh = 0; mesh < mesh_count; mesh++)
+            {
+                DrawPacket packet = {mesh, task.bucket_starts[bucket], bucket_counts[bucket], bucket};
+                task.packets.push_back(packet);
+            }
+        }
+    });
+
+    lists.built = 0;
+    for(int task = 0; task < lists.task_count; task++)
+        lists.built += lists.tasks[task].packets.size();
+}
+
+void MergeDrawPackets(DrawPacketLists& lists, bool by_mesh)
+{
+    //the instance data holds the nearest bucket of every task, then the next one, and so on
+    int offset = 0;
+    for(int bucket = 0; bucket < DRAW_PACKET_DEPTH_BUCKETS; bucket++)
+    {
+        for(int i = 0; i < lists.task_count; i++)
+        {
+            DrawPacketTask& task = lists.tasks[i];
+            task.bucket_offsets[bucket] = offset;
+            offset += task.bucket_starts[bucket + 1] - task.bucket_starts[bucket];
+        }
+    }
+
+    lists.merged.clear();
+    for(int i = 0; i < lists.task_count; i++)
+    {
+        const DrawPacketTask& task = lists.tasks[i];
+        for(int j = 0; j < task.packets.size(); j++)
+        {
+            DrawPacket packet = task.packets[j];
+            packet.first_instance = task.bucket_offsets[packet.bucket];
+            lists.merged.push_back(packet);
+        }
+    }
+
+    //the packets of the same bucket and mesh stay in the order of their tasks, so that their instances follow each
+    //other (and so do the ones of the same mesh in the buckets that follow each other)
+    std::stable_sort(lists.merged.begin(), lists.merged.end(), [by_mesh](const DrawPacket& a, const DrawPacket& b)
+    {
+        if(by_mesh && a.mesh != b.mesh)
+            return a.mesh < b.mesh;
+
+        if(a.bucket != b.bucket)
+            return a.bucket < b.bucket;
+
+        return a.mesh < b.mesh;
+    });
+
+    int merged = 0;
+    for(int i = 0; i < lists.merged.size(); i++)
+    {
+        const DrawPacket& packet = lists.merged[i];
+        DrawPacket* previous = merged > 0 ? &lists.merged[merged - 1] : NULL;
+        if(previous != NULL && previous->mesh == packet.mesh &&
+           previous->first_instance + previous->instance_count == packet.first_instance)
+            previous->instance_count += packet.instance_count;
+
+        else
+            lists.merged[merged++] = packet;
+    }
+
+    lists.merged.resize(merged);
+}
+
+void WriteDrawPacketInstances(const DrawPacketLists& lists, const std::vector<glm::mat4>& instance_matrices,
+                              glm::mat4* out_matrices)
+{
+    ParallelFor(lists.task_count, [&](int index)
+    {
+        const DrawPacketTask& task = lists.tasks[index];
+        for(int bucket = 0; bucket < DRAW_PACKET_DEPTH_BUCKETS; bucket++)
+        {
+            glm::mat4* out = out_matrices + task.bucket_offsets[bucket];
+            for(int i = task.bucket_starts[bucket]; i < task.bucket_starts[bucket + 1]; i++)
+                *out++ = instance_matrices[task.instances[i]];
+        }
+    });
+}
@@ -0,0 +1,99 @@
+#ifndef COMP_371_A2_DRAWPACKETS_H
+#define COMP_371_A2_DRAWPACKETS_H
+
+#include <vector>
+#include "../GLM/glm/glm.hpp"
+
+//this contains the definitions for building the draws of a view on the worker threads (see ParallelFor.h). The visible
+//instances of the view are split in chunks, and the task of each chunk sorts its instances into a few buckets of depth
+//(from the nearest to the farthest) and records the draws they need in a command list of its own, one packet per
+//bucket and mesh of the pool, so that no two tasks ever write to the same memory.
+//
+//The lists are then merged on the thread that owns the OpenGL context. The instance data is laid out one bucket after
+//the other, the packets are put in the order they are drawn in and pointed at their instances, and the packets of the
+//same mesh over instances that follow each other are joined. The tasks then copy the matrices of their instances into
+//place, and the packets are issued together (see DrawMeshPoolPackets in MeshPool.h).
+//
+//The packets are drawn from the nearest bucket to the farthest, so that the depth test rejects the fragments of the
+//instances behind the nearest ones before they are shaded. When the draws can not start at any instance (see
+//CanBaseInstanceMeshPool), they are ordered by mesh instead, which joins the packets of each mesh into a single draw
+//whose instances are still ordered from the nearest to the farthest.
+
+//the number of visible instances each task sorts, and the number of buckets of depth they are sorted into
+const int DRAW_PACKET_CHUNK_SIZE = 4096;
+const int DRAW_PACKET_DEPTH_BUCKETS = 16;
+
+/*
+ * This is a draw of one of the meshes of the pool, for a range of the instances of a view.
+ */
+struct DrawPacket
+{
+    int mesh;
+    int first_instance;
+    int instance_count;
+    int bucket; //the bucket of depth of the instances (0 for the nearest)
+};
+
+/*
+ * This is what the task of one chunk of the visible instances builds.
+ */
+struct DrawPacketTask
+{
+    std::vector<int> instances; //the visible instances of the chunk, in order of bucket
+    std::vector<unsigned char> buckets; //the bucket of each visible instance of the chunk, in their visible order
+    int bucket_starts[DRAW_PACKET_DEPTH_BUCKETS + 1]; //where each bucket starts in instances
+    int bucket_offsets[DRAW_PACKET_DEPTH_BUCKETS]; //where each bucket goes in the instance data (set by the merge)
+
+    //the command list of the task. The first instance of each packet is where it starts in instances, until the
+    //packets are merged.
+    std::vector<DrawPacket> packets;
+};
+
+/*
+ * This holds the command list of each task, and what they were merged into.
+ */
+struct DrawPacketLists
+{
+    std::vector<DrawPacketTask> tasks;
+    int task_count; //the number of tasks of the last view (the others are left over from bigger views)
+    std::vector<DrawPacket> merged;
+    int built; //the number of packets the tasks built, before they were merged
+};
+
+/*
+ * This method sorts the visible instances of a view into buckets of depth and builds their packets on the worker
+ * threads.
+ * @param instance_matrices: The model matrix of each instance
+ * @param visible: The indices of the visible instances
+ * @param visible_count: The number of visible instances
+ * @param depth_row: The row of the matrix from the space of the instances to the space of the camera that gives how far
+ * in front of the camera a point is (the opposite of z)
+ * @param near_depth: The depth of the nearest instance, or less
+ * @param far_depth: The depth of the farthest instance, or more
+ * @param mesh_count: The number of meshes each instance is drawn with
+ * @param lists: The command list of each task is built in this. Passed by reference.
+ */
+void BuildDrawPackets(const std::vector<glm::mat4>& instance_matrices, const std::vector<int>& visible,
+                      int visible_count, const glm::vec4& depth_row, float near_depth, float far_depth,
+                      int mesh_count, DrawPacketLists& lists);
+
+/*
+ * This method lays the buckets of the tasks out in the instance data, and merges the command lists of the tasks into a
+ * single list.
+ * @param lists: The command lists. Passed by reference.
+ * @param by_mesh: Whether the packets are ordered by mesh (so that each mesh is drawn from the first instance), rather
+ * than from the nearest bucket to the farthest
+ */
+void MergeDrawPackets(DrawPacketLists& lists, bool by_mesh);
+
+/*
+ * This method copies the matrices of the instances of each task to where the merge put them, on the worker threads.
+ * @param lists: The merged command lists
+ * @param instance_matrices: The model matrix of each instance
+ * @param out_matrices: This will hold the matrix of each visible instance, in the order they are drawn. It may be mapped
+ * memory (see StreamBuffer.h), so it is only ever written.
+ */
+void WriteDrawPacketInstances(const DrawPacketLists& lists, const std::vector<glm::mat4>& instance_matrices,
+                              glm::mat4* out_matrices);
+
+#endif //COMP_371_A2_DRAWPACKETS_H
@@ -0,0 +1,86 @@
+#include "DynamicResolution.h"
+#include <algorithm>
+#include <cmath>
+#include "GLStateCache.h"
+
+//the number of frames the scale waits after a change, which covers the frames whose GPU times are still in flight
+//(see GPU_TIMER_FRAMES in GpuTimer.h)
+const int DYNAMIC_RESOLUTION_SETTLE_FRAMES = 8;
+
+//the frames have to be this much under the target before the scale goes back up
+const double DYNAMIC_RESOLUTION_HEADROOM = 0.85;
+
+bool CreateDynamicResolution(DynamicResolution& resolution, int width, int height, double target_ms)
+{
+    resolution.steps = DYNAMIC_RESOLUTION_STEPS;
+    resolution.target_ms = target_ms;
+    resolution.settle_frames = 0;
+    return CreateFramebuffer(resolution.scene, width, height);
+}
+
+void DeleteDynamicResolution(DynamicResolution& resolution)
+{
+    DeleteFramebuffer(resolution.scene);
+}
+
+float GetResolutionScale(const DynamicResolution& resolution)
+{
+    return (float)resolution.steps / DYNAMIC_RESOLUTION_STEPS;
+}
+
+void BindDynamicResolution(const DynamicResolution& resolution, int& out_width, int& out_height)
+{
+    out_width = std::max(resolution.scene.width * resolution.steps / DYNAMIC_RESOLUTION_STEPS, 1);
+    out_height = std::max(resolution.scene.height * resolution.steps / DYNAMIC_RESOLUTION_STEPS, 1);
+    glBindFramebuffer(GL_FRAMEBUFFER, resolution.scene.framebuffer);
+    glViewport(0, 0, out_width, out_height);
+    AddIssuedGLCalls(2);
+}
+
+void UpscaleDynamicResolution(const DynamicResolution& resolution, GLuint output_framebuffer)
+{
+    int width = std::max(resolution.scene.width * resolution.steps / DYNAMIC_RESOLUTION_STEPS, 1);
+    int height = std::max(resolution.scene.height * resolution.steps / DYNAMIC_RESOLUTION_STEPS, 1);
+
+    //at the full resolution the pixels line up, so the blit is a straight copy
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, resolution.scene.framebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, output_framebuffer);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, resolution.scene.width, resolution.scene.height, GL_COLOR_BUFFER_BIT,
+                      resolution.steps == DYNAMIC_RESOLUTION_STEPS ? GL_NEAREST : GL_LINEAR);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, output_framebuffer);
+    glViewport(0, 0, resolution.scene.width, resolution.scene.height);
+    AddIssuedGLCalls(5);
+}
+
+bool UpdateDynamicResolution(DynamicResolution& resolution, double gpu_frame_ms)
+{
+    if(resolution.settle_frames > 0)
+    {
+        resolution.settle_frames--;
+        return false;
+    }
+
+    if(gpu_frame_ms <= 0)
+        return false;
+
+    bool over = gpu_frame_ms > resolution.target_ms;
+    bool under = gpu_frame_ms < resolution.target_ms * DYNAMIC_RESOLUTION_HEADROOM;
+    if(!over && !under)
+        return false;
+
+    //the time of the frame goes with the number of pixels, which goes with the square of the scale. The step below
+    //the scale that would hit the target is taken, so that going up does not overshoot it.
+    double scale = GetResolutionScale(resolution) * std::sqrt(resolution.target_ms / gpu_frame_ms);
+    int steps = (int)std::floor(scale * DYNAMIC_RESOLUTION_STEPS + 0.001);
+    if(over)
+        steps = std::min(steps, resolution.steps - 1);
+
+    steps = std::max(DYNAMIC_RESOLUTION_MIN_STEPS, std::min(steps, DYNAMIC_RESOLUTION_STEPS));
+    if(steps == resolution.steps)
+        return false;
+
+    resolution.steps = steps;
+    resolution.settle_frames = DYNAMIC_RESOLUTION_SETTLE_FRAMES;
+    return true;
+}
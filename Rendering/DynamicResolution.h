@@ -0,0 +1,80 @@
+#ifndef COMP_371_A2_DYNAMICRESOLUTION_H
+#define COMP_371_A2_DYNAMICRESOLUTION_H
+
+#include <glew.h>
+#include "Framebuffer.h"
+
+//this contains the definitions for drawing the scene at a lower resolution when the GPU can not keep up, since the
+//cost of the fragment shaders goes with the number of pixels. The scene is drawn into a framebuffer of its own, into
+//a rectangle that is a fraction (the scale) of the size of the output, and that rectangle is then stretched over the
+//output with a linear blit.
+//
+//The scale is adjusted from the GPU time of the frames (see GpuTimer.h), to hold them to a target time. Since those
+//times are a few frames old, the scale only moves in steps of DYNAMIC_RESOLUTION_STEPS, and waits for a few frames
+//after each change so that it sees the effect of the last one before making the next. The framebuffer always has the
+//full size of the output, so it never has to be created again when the scale changes.
+
+//the number of steps between no pixels and the full resolution, so the scale moves in steps of 5%
+const int DYNAMIC_RESOLUTION_STEPS = 20;
+
+//the lowest the scale goes (in steps), beyond which the image would be too blurry to be worth it
+const int DYNAMIC_RESOLUTION_MIN_STEPS = 10;
+
+/*
+ * This holds the framebuffer the scene is drawn into, and how much of it is used.
+ */
+struct DynamicResolution
+{
+    Framebuffer scene; //the size of the output
+    int steps; //the scale, in steps (DYNAMIC_RESOLUTION_STEPS for the full resolution)
+    double target_ms; //the GPU time each frame should take
+    int settle_frames; //the number of frames left before the scale can change again
+};
+
+/*
+ * This method creates the framebuffer the scene is drawn into, starting at the full resolution.
+ * @param resolution: This will hold the framebuffer. Passed by reference.
+ * @param width: The size of the output, in pixels
+ * @param height: The size of the output, in pixels
+ * @param target_ms: The GPU time each frame should take, in milliseconds
+ * @return A boolean specifying if the framebuffer is complete or not.
+ */
+bool CreateDynamicResolution(DynamicResolution& resolution, int width, int height, double target_ms);
+
+/*
+ * This method deletes the framebuffer.
+ */
+void DeleteDynamicResolution(DynamicResolution& resolution);
+
+/*
+ * This method returns the current scale, from 0 to 1.
+ */
+float GetResolutionScale(const DynamicResolution& resolution);
+
+/*
+ * This method binds the framebuffer and sets the viewport to the part of it that is drawn into at the current scale.
+ * @param resolution: The framebuffer. Passed by reference.
+ * @param out_width: This will hold the size of the part that is drawn into, in pixels. Passed by reference.
+ * @param out_height: This will hold the size of the part that is drawn into, in pixels. Passed by reference.
+ */
+void BindDynamicResolution(const DynamicResolution& resolution, int& out_width, int& out_height);
+
+/*
+ * This method stretches what was drawn over the whole output, and binds the output (with its full viewport) so that
+ * it can be presented.
+ * @param resolution: The framebuffer. Passed by reference.
+ * @param output_framebuffer: The framebuffer to upscale into (0 for the window), which has the size the framebuffer
+ * was created with
+ */
+void UpscaleDynamicResolution(const DynamicResolution& resolution, GLuint output_framebuffer);
+
+/*
+ * This method adjusts the scale from the GPU time of a frame. The scale goes down as soon as the frames are over the
+ * target, and only goes back up once they are well under it, so that it does not go back and forth between two steps.
+ * @param resolution: The framebuffer. Passed by reference.
+ * @param gpu_frame_ms: The GPU time of a recent frame, in milliseconds
+ * @return A boolean specifying if the scale changed or not.
+ */
+bool UpdateDynamicResolution(DynamicResolution& resolution, double gpu_frame_ms);
+
+#endif //COMP_371_A2_DYNAMICRESOLUTION_H
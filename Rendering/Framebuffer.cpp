@@ -0,0 +1,76 @@
+#include "Framebuffer.h"
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+bool CreateFramebuffer(Framebuffer& framebuffer, int width, int height)
+{
+    framebuffer.width = width;
+    framebuffer.height = height;
+
+    glGenTextures(1, &framebuffer.color);
+    glBindTexture(GL_TEXTURE_2D, framebuffer.color);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenRenderbuffers(1, &framebuffer.depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, framebuffer.depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &framebuffer.framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, framebuffer.color, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, framebuffer.depth);
+
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if(status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cout << "The framebuffer is incomplete (status 0x" << std::hex << status << std::dec << ")" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+void DeleteFramebuffer(Framebuffer& framebuffer)
+{
+    glDeleteFramebuffers(1, &framebuffer.framebuffer);
+    glDeleteRenderbuffers(1, &framebuffer.depth);
+    glDeleteTextures(1, &framebuffer.color);
+    framebuffer.framebuffer = 0;
+    framebuffer.depth = 0;
+    framebuffer.color = 0;
+}
+
+bool SaveFramebufferPPM(const Framebuffer& framebuffer, const char* file_path)
+{
+    int width = framebuffer.width;
+    int height = framebuffer.height;
+    std::vector<unsigned char> pixels(width * height * 3);
+
+    GLint previous_framebuffer;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous_framebuffer);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer.framebuffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, &pixels[0]);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, previous_framebuffer);
+
+    std::ofstream out(file_path, std::ios::out | std::ios::binary);
+    if(!out.is_open())
+    {
+        std::cout << "Could not open " << file_path << " to save the frame" << std::endl;
+        return false;
+    }
+
+    //OpenGL gives us the rows from the bottom up, while PPM stores them from the top down
+    out << "P6\n" << width << " " << height << "\n255\n";
+    for(int row = height - 1; row >= 0; row--)
+        out.write((const char*)&pixels[row * width * 3], width * 3);
+
+    return out.good();
+}
@@ -0,0 +1,40 @@
+#ifndef COMP_371_A2_FRAMEBUFFER_H
+#define COMP_371_A2_FRAMEBUFFER_H
+
+#include <glew.h>
+
+//this contains the definitions for rendering into a framebuffer object rather than into a window, and for saving what
+//was rendered to an image file.
+
+/*
+ * This is a framebuffer object with a color and a depth attachment.
+ */
+struct Framebuffer
+{
+    GLuint framebuffer;
+    GLuint color; //an RGBA8 texture
+    GLuint depth; //a 24 bit depth renderbuffer
+    int width;
+    int height;
+};
+
+/*
+ * This method creates a framebuffer of the passed size.
+ * @param framebuffer: This will hold the new framebuffer. Passed by reference.
+ * @return A boolean specifying if the framebuffer is complete (and can be rendered into) or not.
+ */
+bool CreateFramebuffer(Framebuffer& framebuffer, int width, int height);
+
+/*
+ * This method deletes the objects of a framebuffer.
+ */
+void DeleteFramebuffer(Framebuffer& framebuffer);
+
+/*
+ * This method reads back the color attachment of a framebuffer and saves it as a binary PPM image. This waits for the
+ * framebuffer to be done rendering, so it should not be used when timing frames.
+ * @return A boolean specifying if the image could be written or not.
+ */
+bool SaveFramebufferPPM(const Framebuffer& framebuffer, const char* file_path);
+
+#endif //COMP_371_A2_FRAMEBUFFER_H
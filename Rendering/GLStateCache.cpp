@@ -0,0 +1,141 @@
+#include "GLStateCache.h"
+
+//the value the cache holds for state it does not know, which never matches anything that is set
+const GLuint UNKNOWN_OBJECT = 0xFFFFFFFF;
+const GLenum UNKNOWN_ENUM = 0xFFFFFFFF;
+
+/*
+ * This is what the cache knows about the OpenGL state. A capability is -1 when unknown, and 0 or 1 otherwise.
+ */
+struct CachedGLState
+{
+    GLuint program;
+    GLuint vertex_array;
+    GLuint array_buffer;
+
+    int depth_test;
+    GLenum depth_function;
+
+    int blend;
+    GLuint64 blend_factors; //the source factor in the high 32 bits and the destination factor in the low 32 bits
+
+    int cull_face;
+    GLenum cull_mode;
+};
+
+static CachedGLState cached;
+static GLCallCounters counters = {0, 0, 0};
+
+void ResetGLStateCache()
+{
+    cached.program = UNKNOWN_OBJECT;
+    cached.vertex_array = UNKNOWN_OBJECT;
+    cached.array_buffer = UNKNOWN_OBJECT;
+    cached.depth_test = -1;
+    cached.depth_function = UNKNOWN_ENUM;
+    cached.blend = -1;
+    cached.blend_factors = ((GLuint64)UNKNOWN_ENUM << 32) | UNKNOWN_ENUM;
+    cached.cull_face = -1;
+    cached.cull_mode = UNKNOWN_ENUM;
+}
+
+/*
+ * This counts a call as issued or skipped, and tells the caller whether it should be made.
+ * @return A boolean specifying if the value changed (and the call should be issued) or not.
+ */
+template<typename T>
+static bool Changed(T& cached_value, T value)
+{
+    if(cached_value == value)
+    {
+        counters.skipped++;
+        return false;
+    }
+
+    cached_value = value;
+    counters.issued++;
+    return true;
+}
+
+/*
+ * This enables or disables a capability (glEnable / glDisable) if it is not already.
+ */
+static void SetCapability(int& cached_enabled, GLenum capability, bool enabled)
+{
+    if(!Changed(cached_enabled, enabled ? 1 : 0))
+        return;
+
+    if(enabled)
+        glEnable(capability);
+
+    else
+        glDisable(capability);
+}
+
+void UseProgramCached(GLuint program)
+{
+    if(Changed(cached.program, program))
+        glUseProgram(program);
+}
+
+void BindVertexArrayCached(GLuint vertex_array)
+{
+    if(Changed(cached.vertex_array, vertex_array))
+        glBindVertexArray(vertex_array);
+}
+
+void BindArrayBufferCached(GLuint buffer)
+{
+    if(Changed(cached.array_buffer, buffer))
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+}
+
+void SetDepthState(bool enabled, GLenum function)
+{
+    SetCapability(cached.depth_test, GL_DEPTH_TEST, enabled);
+
+    //the function only matters while the test is on, and is set when it gets turned on
+    if(enabled && Changed(cached.depth_function, function))
+        glDepthFunc(function);
+}
+
+void SetBlendState(bool enabled, GLenum source_factor, GLenum destination_factor)
+{
+    SetCapability(cached.blend, GL_BLEND, enabled);
+
+    if(!enabled)
+        return;
+
+    //both factors are set by the same call, so they are compared together
+    GLuint64 factors = ((GLuint64)source_factor << 32) | destination_factor;
+    if(Changed(cached.blend_factors, factors))
+        glBlendFunc(source_factor, destination_factor);
+}
+
+void SetCullState(bool enabled, GLenum face)
+{
+    SetCapability(cached.cull_face, GL_CULL_FACE, enabled);
+
+    if(enabled && Changed(cached.cull_mode, face))
+        glCullFace(face);
+}
+
+void AddIssuedGLCalls(int count)
+{
+    counters.issued += count;
+}
+
+void AddDrawCalls(int count)
+{
+    counters.issued += count;
+    counters.draws += count;
+}
+
+GLCallCounters TakeGLCallCounters()
+{
+    GLCallCounters taken = counters;
+    counters.issued = 0;
+    counters.skipped = 0;
+    counters.draws = 0;
+    return taken;
+}
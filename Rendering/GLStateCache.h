@@ -0,0 +1,78 @@
+#ifndef COMP_371_A2_GLSTATECACHE_H
+#define COMP_371_A2_GLSTATECACHE_H
+
+#include <glew.h>
+
+//this contains the definitions for a thin layer over the OpenGL state that the viewer changes (the program, the vertex
+//array, the buffer bindings, and the depth, blend and cull state). It remembers what was last set, and only calls into
+//OpenGL when something actually changes. Every call that goes through it is counted as either issued or skipped, along
+//with the other calls the frame makes (uniforms and draws), so that we can see how much driver work is being saved.
+//
+//Everything that changes this state has to go through here, otherwise the cache no longer matches OpenGL. If something
+//else does change it, ResetGLStateCache makes the next call of each kind go through.
+
+/*
+ * These are the number of OpenGL calls made and avoided since the counters were last taken.
+ */
+struct GLCallCounters
+{
+    int issued;
+    int skipped;
+    int draws; //the draw calls among the issued calls
+};
+
+/*
+ * This method forgets everything the cache knows about the OpenGL state, so that the next call of each kind is issued.
+ * It should be called after creating the context.
+ */
+void ResetGLStateCache();
+
+/*
+ * This method makes the passed program the current one (glUseProgram), if it is not already.
+ */
+void UseProgramCached(GLuint program);
+
+/*
+ * This method binds the passed vertex array (glBindVertexArray), if it is not already.
+ */
+void BindVertexArrayCached(GLuint vertex_array);
+
+/*
+ * This method binds the passed buffer to GL_ARRAY_BUFFER (glBindBuffer), if it is not already. Only GL_ARRAY_BUFFER is
+ * tracked, since the element array binding belongs to the vertex array.
+ */
+void BindArrayBufferCached(GLuint buffer);
+
+/*
+ * This method enables or disables the depth test and sets its function, skipping whatever is already set.
+ */
+void SetDepthState(bool enabled, GLenum function);
+
+/*
+ * This method enables or disables blending and sets its factors, skipping whatever is already set.
+ */
+void SetBlendState(bool enabled, GLenum source_factor, GLenum destination_factor);
+
+/*
+ * This method enables or disables face culling and sets the faces that are culled, skipping whatever is already set.
+ */
+void SetCullState(bool enabled, GLenum face);
+
+/*
+ * This method counts OpenGL calls that were made outside of the cache (i.e. uniforms and draws), so that the counters
+ * hold every call of the frame.
+ */
+void AddIssuedGLCalls(int count);
+
+/*
+ * This method counts draw calls, which are counted as issued calls as well.
+ */
+void AddDrawCalls(int count);
+
+/*
+ * This method returns the calls issued and skipped since it was last called, and starts counting again from 0. It is
+ * called once per frame.
+ */
+GLCallCounters TakeGLCallCounters();
+
+#endif //COMP_371_A2_GLSTATECACHE_H
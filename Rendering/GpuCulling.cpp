@@ -0,0 +1,440 @@
+#include "GpuCulling.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include "../Loaders/ShaderLoader.h"
+#include "GLStateCache.h"
+
+//the number of instances (and of texels across) each work group of the compute shaders handles
+const int CULLING_GROUP_SIZE = 64;
+const int PYRAMID_GROUP_SIZE = 8;
+
+//the counts of the two draws are copied out every frame and read back this many frames later, once the GPU is done
+const int GPU_CULLING_READBACK_FRAMES = 3;
+
+static GLuint first_pass_program = 0;
+static GLuint second_pass_program = 0;
+static GLuint command_program = 0;
+static GLuint pyramid_program = 0;
+
+//the boxes and the matrices of all of the instances, what the first pass decided for each of them, the number of
+//instances in each of the two draws, and the commands that draw every mesh for each of them
+static GLuint box_buffer = 0;
+static GLuint matrix_buffer = 0;
+static GLuint state_buffer = 0;
+static GLuint count_buffer = 0;
+static GLuint command_buffer = 0;
+static GLuint visible_buffer = 0; //the instance buffer, which is not ours
+static int instance_count = 0;
+
+//where each mesh is in the buffers of the pool, as (index count, first index, base vertex, unused)
+static GLuint mesh_buffer = 0;
+static int mesh_count = 0;
+
+//the depth buffer of the first pass is copied into this framebuffer (since the depth buffer of the window can not be
+//read by a shader), and then reduced into the depth pyramid. The first level of the pyramid is already half of the size
+//of the depth buffer, since a level the size of the depth buffer would only be a slower copy of it.
+static GLuint depth_framebuffer = 0;
+static GLuint depth_texture = 0;
+static GLuint pyramid_texture = 0;
+static int depth_width = 0;
+static int depth_height = 0;
+static int pyramid_levels = 0;
+
+//the depth pyramid of the last frame, and the matrix it was drawn with. There is none until a frame has been culled.
+static bool pyramid_valid = false;
+static glm::mat4 pyramid_matrix;
+
+//the copies of the draws that are read back, and the fence of each of them (0 if it holds nothing to read)
+static GLuint readback_buffers[GPU_CULLING_READBACK_FRAMES];
+static GLsync readback_fences[GPU_CULLING_READBACK_FRAMES];
+static int readback_frame = 0;
+static GpuCullingStats stats;
+
+bool InitGpuCulling()
+{
+    if(!GLEW_VERSION_4_3)
+    {
+        std::cout << "Culling on the GPU needs OpenGL 4.3 (compute shaders), which is not available" << std::endl;
+        return false;
+    }
+
+    first_pass_program = LoadComputeShader("../Shaders/CullingComputeShader.glsl",
+                                           std::vector<std::string>(1, "FIRST_PASS"));
+    second_pass_program = LoadComputeShader("../Shaders/CullingComputeShader.glsl",
+                                            std::vector<std::string>(1, "SECOND_PASS"));
+    command_program = LoadComputeShader("../Shaders/CullingComputeShader.glsl",
+                                        std::vector<std::string>(1, "BUILD_COMMANDS"));
+    pyramid_program = LoadComputeShader("../Shaders/HiZComputeShader.glsl", std::vector<std::string>());
+
+    if(first_pass_program == 0 || second_pass_program == 0 || command_program == 0 || pyramid_program == 0)
+    {
+        ShutdownGpuCulling();
+        return false;
+    }
+
+    glGenBuffers(1, &box_buffer);
+    glGenBuffers(1, &matrix_buffer);
+    glGenBuffers(1, &state_buffer);
+    glGenBuffers(1, &count_buffer);
+    glGenBuffers(1, &command_buffer);
+    glGenBuffers(1, &mesh_buffer);
+    glGenFramebuffers(1, &depth_framebuffer);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, count_buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint) * 2, NULL, GL_DYNAMIC_COPY);
+
+    glGenBuffers(GPU_CULLING_READBACK_FRAMES, readback_buffers);
+    for(int i = 0; i < GPU_CULLING_READBACK_FRAMES; i++)
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, readback_buffers[i]);
+        glBufferData(GL_COPY_WRITE_BUFFER, sizeof(GLuint) * 2, NULL, GL_STREAM_READ);
+        readback_fences[i] = 0;
+    }
+
+    readback_frame = 0;
+    stats = GpuCullingStats();
+    pyramid_valid = false;
+    return true;
+}
+
+void ShutdownGpuCulling()
+{
+    GLuint programs[4] = {first_pass_program, second_pass_program, command_program, pyramid_program};
+    for(int i = 0; i < 4; i++)
+    {
+        if(programs[i] != 0)
+            glDeleteProgram(programs[i]);
+    }
+
+    first_pass_program = second_pass_program = command_program = pyramid_program = 0;
+
+    if(box_buffer == 0)
+        return;
+
+    glDeleteBuffers(1, &box_buffer);
+    glDeleteBuffers(1, &matrix_buffer);
+    glDeleteBuffers(1, &state_buffer);
+    glDeleteBuffers(1, &count_buffer);
+    glDeleteBuffers(1, &command_buffer);
+    glDeleteBuffers(1, &mesh_buffer);
+    glDeleteBuffers(GPU_CULLING_READBACK_FRAMES, readback_buffers);
+    glDeleteFramebuffers(1, &depth_framebuffer);
+    glDeleteTextures(1, &depth_texture);
+    glDeleteTextures(1, &pyramid_texture);
+
+    for(int i = 0; i < GPU_CULLING_READBACK_FRAMES; i++)
+    {
+        if(readback_fences[i] != 0)
+            glDeleteSync(readback_fences[i]);
+
+        readback_fences[i] = 0;
+    }
+
+    box_buffer = matrix_buffer = state_buffer = count_buffer = command_buffer = mesh_buffer = depth_framebuffer = 0;
+    depth_texture = pyramid_texture = 0;
+    depth_width = depth_height = pyramid_levels = 0;
+}
+
+void SetGpuCullingInstances(const std::vector<glm::mat4>& matrices, const InstanceBounds& bounds,
+                            const MeshPool& pool, GLuint instance_buffer)
+{
+    instance_count = matrices.size();
+    visible_buffer = instance_buffer;
+
+    //each mesh gets a command in each of the draws, which the compute shaders fill in
+    mesh_count = pool.meshes.size();
+    std::vector<GLint> meshes(std::max(mesh_count, 1) * 4, 0);
+    for(int i = 0; i < mesh_count; i++)
+    {
+        meshes[4 * i] = pool.meshes[i].index_count;
+        meshes[4 * i + 1] = pool.meshes[i].first_index;
+        meshes[4 * i + 2] = pool.meshes[i].base_vertex;
+    }
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, mesh_buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLint) * meshes.size(), &meshes.front(), GL_STATIC_DRAW);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, command_buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(DrawElementsIndirectCommand) * std::max(mesh_count, 1) * 2, NULL,
+                 GL_DYNAMIC_COPY);
+
+    //the shaders read the boxes as (center, extent) pairs, rather than as the separate arrays the CPU culling uses
+    std::vector<glm::vec4> boxes(instance_count * 2);
+    for(int i = 0; i < instance_count; i++)
+    {
+        boxes[2 * i] = glm::vec4(bounds.box_x[i], bounds.box_y[i], bounds.box_z[i], 0);
+        boxes[2 * i + 1] = glm::vec4(bounds.extent_x[i], bounds.extent_y[i], bounds.extent_z[i], 0);
+    }
+
+    //the buffers are never empty, so that they can always be bound
+    std::vector<GLuint> states(std::max(instance_count, 1), 0);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, box_buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(glm::vec4) * std::max((int)boxes.size(), 2),
+                 boxes.empty() ? NULL : &boxes.front(), GL_STATIC_DRAW);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, matrix_buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(glm::mat4) * std::max(instance_count, 1),
+                 matrices.empty() ? NULL : &matrices.front(), GL_STATIC_DRAW);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, state_buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint) * states.size(), &states.front(), GL_DYNAMIC_COPY);
+
+    //the counts that have not been read back yet are for the previous instances
+    for(int i = 0; i < GPU_CULLING_READBACK_FRAMES; i++)
+    {
+        if(readback_fences[i] != 0)
+            glDeleteSync(readback_fences[i]);
+
+        readback_fences[i] = 0;
+    }
+
+    stats = GpuCullingStats();
+}
+
+/*
+ * This binds the buffers and the depth pyramid for one of the passes, and sets the uniforms they share.
+ * @param matrix: The matrix the depth pyramid is tested with
+ * @return The number of OpenGL calls made
+ */
+static int BindCullingPass(GLuint program, const glm::mat4& matrix)
+{
+    UseProgramCached(program);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, box_buffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, matrix_buffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, visible_buffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, count_buffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, state_buffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, command_buffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, mesh_buffer);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, pyramid_texture);
+
+    glUniform1i(0, instance_count);
+    glUniformMatrix4fv(1, 1, GL_FALSE, &matrix[0][0]);
+    glUniform1i(2, pyramid_valid ? pyramid_levels : 0);
+    glUniform2f(3, depth_width, depth_height);
+
+    return 13;
+}
+
+/*
+ * This writes the commands of one of the draws (0 or 1) from the number of instances the pass put in it, once the pass
+ * is done. Its buffers are still bound from the pass.
+ * @return The number of OpenGL calls made
+ */
+static int BuildDrawCommands(int pass)
+{
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    UseProgramCached(command_program);
+    glUniform1i(10, pass);
+    glUniform1i(11, mesh_count);
+    glDispatchCompute((mesh_count + CULLING_GROUP_SIZE - 1) / CULLING_GROUP_SIZE, 1, 1);
+    return 4;
+}
+
+void CullInstancesOnGpu(const glm::mat4& matrix)
+{
+    //both draws start out empty, and the passes count the instances into them
+    GLuint counts[2] = {0, 0};
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, count_buffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(counts), counts);
+
+    //the depth pyramid of the last frame is tested with the matrix it was drawn with, and only the frustum uses the
+    //matrix of this frame
+    int calls = BindCullingPass(first_pass_program, pyramid_matrix);
+
+    Frustum frustum;
+    ExtractFrustumPlanes(matrix, frustum);
+    glUniform4fv(4, 6, &frustum.planes[0].x);
+    glDispatchCompute((instance_count + CULLING_GROUP_SIZE - 1) / CULLING_GROUP_SIZE, 1, 1);
+    calls += BuildDrawCommands(0);
+
+    //the draw reads the instance buffer and the commands, and the second pass reads the marks and the counts
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+    AddIssuedGLCalls(calls + 5);
+}
+
+/*
+ * This (re)creates the depth texture and the depth pyramid for a framebuffer of the passed size. The depth texture
+ * has the same format as the depth buffer of the framebuffer, which is needed to blit between them.
+ */
+static void CreateDepthPyramid(GLuint framebuffer, int width, int height)
+{
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    GLenum depth_attachment = framebuffer == 0 ? GL_DEPTH : GL_DEPTH_ATTACHMENT;
+    GLenum stencil_attachment = framebuffer == 0 ? GL_STENCIL : GL_STENCIL_ATTACHMENT;
+
+    GLint depth_bits = 24;
+    GLint stencil_type = GL_NONE;
+    GLint stencil_bits = 0;
+    glGetFramebufferAttachmentParameteriv(GL_READ_FRAMEBUFFER, depth_attachment,
+                                          GL_FRAMEBUFFER_ATTACHMENT_DEPTH_SIZE, &depth_bits);
+    glGetFramebufferAttachmentParameteriv(GL_READ_FRAMEBUFFER, stencil_attachment,
+                                          GL_FRAMEBUFFER_ATTACHMENT_OBJECT_TYPE, &stencil_type);
+    if(stencil_type != GL_NONE)
+        glGetFramebufferAttachmentParameteriv(GL_READ_FRAMEBUFFER, stencil_attachment,
+                                              GL_FRAMEBUFFER_ATTACHMENT_STENCIL_SIZE, &stencil_bits);
+
+    GLenum depth_format = GL_DEPTH_COMPONENT24;
+    if(stencil_bits > 0)
+        depth_format = depth_bits == 32 ? GL_DEPTH32F_STENCIL8 : GL_DEPTH24_STENCIL8;
+
+    else if(depth_bits == 16)
+        depth_format = GL_DEPTH_COMPONENT16;
+
+    else if(depth_bits == 32)
+        depth_format = GL_DEPTH_COMPONENT32F;
+
+    glDeleteTextures(1, &depth_texture);
+    glDeleteTextures(1, &pyramid_texture);
+
+    glGenTextures(1, &depth_texture);
+    glBindTexture(GL_TEXTURE_2D, depth_texture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, depth_format, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, depth_framebuffer);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, stencil_bits > 0 ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT,
+                           GL_TEXTURE_2D, depth_texture, 0);
+    glDrawBuffer(GL_NONE);
+
+    //every level from half of the size of the depth buffer down to 1x1, each one holding the farthest depth of the
+    //texels it covers
+    depth_width = width;
+    depth_height = height;
+    pyramid_levels = std::max((int)std::floor(std::log2((double)std::max(width, height))), 1);
+
+    glGenTextures(1, &pyramid_texture);
+    glBindTexture(GL_TEXTURE_2D, pyramid_texture);
+    glTexStorage2D(GL_TEXTURE_2D, pyramid_levels, GL_R32F, std::max(width / 2, 1), std::max(height / 2, 1));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    pyramid_valid = false;
+}
+
+/*
+ * This copies the depth buffer of the passed framebuffer, and reduces it into each level of the depth pyramid in turn.
+ * @return The number of OpenGL calls made
+ */
+static int BuildDepthPyramid(GLuint framebuffer, int width, int height)
+{
+    if(width != depth_width || height != depth_height)
+        CreateDepthPyramid(framebuffer, width, height);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, depth_framebuffer);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+    UseProgramCached(pyramid_program);
+    glActiveTexture(GL_TEXTURE0);
+    int calls = 5;
+
+    //the first level is reduced from the depth buffer, and each of the others from the level before it once that one is
+    //done being written
+    for(int level = 0; level < pyramid_levels; level++)
+    {
+        int level_width = std::max(width >> (level + 1), 1);
+        int level_height = std::max(height >> (level + 1), 1);
+
+        if(level <= 1)
+        {
+            glBindTexture(GL_TEXTURE_2D, level == 0 ? depth_texture : pyramid_texture);
+            calls++;
+        }
+
+        glUniform1i(0, std::max(level - 1, 0));
+        glUniform2i(1, std::max(width >> level, 1), std::max(height >> level, 1)); //the size of the level it reads
+        glBindImageTexture(0, pyramid_texture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+        glDispatchCompute((level_width + PYRAMID_GROUP_SIZE - 1) / PYRAMID_GROUP_SIZE,
+                          (level_height + PYRAMID_GROUP_SIZE - 1) / PYRAMID_GROUP_SIZE, 1);
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+        calls += 5;
+    }
+
+    return calls;
+}
+
+/*
+ * This copies the counts of the draws of this frame out, and reads the ones copied out a few frames ago if the GPU is
+ * done with them (they are skipped otherwise).
+ * @return The number of OpenGL calls made
+ */
+static int ReadBackCounts()
+{
+    int slot = readback_frame % GPU_CULLING_READBACK_FRAMES;
+    readback_frame++;
+    int calls = 0;
+
+    if(readback_fences[slot] != 0)
+    {
+        GLenum status = glClientWaitSync(readback_fences[slot], 0, 0);
+        if(status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+        {
+            GLuint counts[2];
+            glBindBuffer(GL_COPY_READ_BUFFER, readback_buffers[slot]);
+            glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(counts), counts);
+            stats.first_pass = counts[0];
+            stats.second_pass = counts[1];
+            calls += 2;
+        }
+
+        glDeleteSync(readback_fences[slot]);
+        calls += 2;
+    }
+
+    glBindBuffer(GL_COPY_READ_BUFFER, count_buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, readback_buffers[slot]);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, sizeof(GLuint) * 2);
+    readback_fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    return calls + 4;
+}
+
+void RetestInstancesOnGpu(const glm::mat4& matrix, GLuint framebuffer, int width, int height)
+{
+    int calls = BuildDepthPyramid(framebuffer, width, height);
+    pyramid_valid = true;
+    pyramid_matrix = matrix;
+
+    calls += BindCullingPass(second_pass_program, matrix);
+    glDispatchCompute((instance_count + CULLING_GROUP_SIZE - 1) / CULLING_GROUP_SIZE, 1, 1);
+    calls += BuildDrawCommands(1);
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+    calls += 2;
+
+    calls += ReadBackCounts();
+    AddIssuedGLCalls(calls);
+}
+
+void DrawGpuCulledInstances(int pass, bool multi_draw)
+{
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer);
+    AddIssuedGLCalls(1);
+
+    //the commands of the draw follow each other, one per mesh
+    size_t offset = sizeof(DrawElementsIndirectCommand) * mesh_count * pass;
+    if(multi_draw)
+    {
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)offset, mesh_count, 0);
+        AddDrawCalls(1);
+        return;
+    }
+
+    for(int i = 0; i < mesh_count; i++)
+        glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                               (void*)(offset + sizeof(DrawElementsIndirectCommand) * i));
+
+    AddDrawCalls(mesh_count);
+}
+
+GpuCullingStats GetGpuCullingStats()
+{
+    return stats;
+}
@@ -0,0 +1,84 @@
+#ifndef COMP_371_A2_GPUCULLING_H
+#define COMP_371_A2_GPUCULLING_H
+
+#include <glew.h>
+#include <vector>
+#include "../GLM/glm/glm.hpp"
+#include "../Scene/FrustumCulling.h"
+#include "MeshPool.h"
+
+//this contains the definitions for culling the instances on the GPU with compute shaders (OpenGL 4.3), which write the
+//matrices of the visible instances straight into the instance buffer and write the indirect commands that draw every
+//mesh of the pool for them (see MeshPool.h), so that the CPU never sees which ones are drawn. Each frame is done in two
+//passes:
+//
+//  1. The instances inside of the view frustum are tested against a depth pyramid (hierarchical Z) built from the last
+//     frame, and the ones that were not hidden in it are drawn.
+//  2. A new depth pyramid is built from what was just drawn, the instances that were hidden last frame are tested
+//     against it, and the ones that are visible after all are drawn as well.
+//
+//The second pass is what keeps an instance that just came into view from missing a frame. The depth pyramid keeps the
+//farthest depth of each of its texels, so an instance is only rejected if it is behind everything drawn in each texel
+//its rectangle on the screen covers (see Shaders/CullingComputeShader.glsl and Shaders/HiZComputeShader.glsl).
+
+/*
+ * This holds what the culling did during a frame. Since it is read back from the GPU, it is a few frames old.
+ */
+struct GpuCullingStats
+{
+    int first_pass; //the number of instances drawn by the first pass
+    int second_pass; //the number of instances drawn by the second pass
+};
+
+/*
+ * This method builds the compute shaders and the buffers the culling needs.
+ * @return A boolean specifying if the culling can be done on this GPU or not (it needs OpenGL 4.3).
+ */
+bool InitGpuCulling();
+
+/*
+ * This method deletes everything InitGpuCulling created.
+ */
+void ShutdownGpuCulling();
+
+/*
+ * This method hands the instances to the GPU. It needs to be called every time they change.
+ * @param matrices: The model matrix of each instance
+ * @param bounds: The bounds of each instance (see FrustumCulling.h)
+ * @param pool: The meshes each instance is drawn with
+ * @param instance_buffer: The buffer the matrices of the visible instances are written to, which must have room for
+ * all of them (see InstanceBuffer.h)
+ */
+void SetGpuCullingInstances(const std::vector<glm::mat4>& matrices, const InstanceBounds& bounds,
+                            const MeshPool& pool, GLuint instance_buffer);
+
+/*
+ * This method runs the first pass of the culling. Its draw can be issued once it is done (see DrawGpuCulledInstances).
+ * @param matrix: The matrix that takes the object to clip space (Projection * View * Model)
+ */
+void CullInstancesOnGpu(const glm::mat4& matrix);
+
+/*
+ * This method builds the depth pyramid from the depth buffer of the passed framebuffer, and runs the second pass of the
+ * culling against it.
+ * @param matrix: The same matrix as for the first pass
+ * @param framebuffer: The framebuffer the first pass was drawn into (0 for the window)
+ * @param width: The size of that framebuffer, in pixels
+ * @param height: The size of that framebuffer, in pixels
+ */
+void RetestInstancesOnGpu(const glm::mat4& matrix, GLuint framebuffer, int width, int height);
+
+/*
+ * This method issues the indirect draws of one of the passes (0 or 1) with the current program and vertex array, which
+ * must be attached to the pool and read their instance matrices from the instance buffer.
+ * @param pass: The pass whose instances are drawn
+ * @param multi_draw: Whether every mesh is drawn in a single call, rather than one call per mesh
+ */
+void DrawGpuCulledInstances(int pass, bool multi_draw);
+
+/*
+ * This method returns the most recent counts that have been read back from the GPU (without waiting for any).
+ */
+GpuCullingStats GetGpuCullingStats();
+
+#endif //COMP_371_A2_GPUCULLING_H
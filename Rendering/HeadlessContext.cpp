@@ -0,0 +1,105 @@
+#include "HeadlessContext.h"
+#include <iostream>
+
+#ifdef COMP_371_A2_HEADLESS_EGL
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+static EGLDisplay display = EGL_NO_DISPLAY;
+static EGLContext context = EGL_NO_CONTEXT;
+
+bool CreateHeadlessContext()
+{
+    //the surfaceless platform gives us a display that is not tied to a window system
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+            (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+    if(getPlatformDisplay == NULL)
+    {
+        std::cout << "EGL does not support EGL_EXT_platform_base" << std::endl;
+        return false;
+    }
+
+    display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+
+    EGLint major;
+    EGLint minor;
+    if(display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+    {
+        std::cout << "Unable to initialize the surfaceless EGL display" << std::endl;
+        return false;
+    }
+
+    //we never draw to an EGL surface, so any config that supports desktop OpenGL will do (or none at all, with
+    //EGL_KHR_no_config_context)
+    EGLint config_attributes[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+    EGLConfig config = NULL;
+    EGLint config_count = 0;
+    eglChooseConfig(display, config_attributes, &config, 1, &config_count);
+
+    //the shaders need the same context as the window would have given us
+    EGLint context_attributes[] =
+    {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+
+    eglBindAPI(EGL_OPENGL_API);
+    context = eglCreateContext(display, config_count > 0 ? config : EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT,
+                               context_attributes);
+
+    if(context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+    {
+        std::cout << "Unable to create a surfaceless OpenGL 3.3 context (EGL error 0x" << std::hex << eglGetError()
+                  << std::dec << ")" << std::endl;
+        DestroyHeadlessContext();
+        return false;
+    }
+
+    std::cout << "Rendering without a window, with EGL " << major << "." << minor << std::endl;
+    return true;
+}
+
+bool MakeHeadlessContextCurrent(bool current)
+{
+    if(display == EGL_NO_DISPLAY)
+        return false;
+
+    return eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, current ? context : EGL_NO_CONTEXT) == EGL_TRUE;
+}
+
+void DestroyHeadlessContext()
+{
+    if(display == EGL_NO_DISPLAY)
+        return;
+
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if(context != EGL_NO_CONTEXT)
+        eglDestroyContext(display, context);
+
+    eglTerminate(display);
+    display = EGL_NO_DISPLAY;
+    context = EGL_NO_CONTEXT;
+}
+
+#else
+
+bool CreateHeadlessContext()
+{
+    std::cout << "This build can not render without a window (build it with the HEADLESS_EGL option)" << std::endl;
+    return false;
+}
+
+bool MakeHeadlessContextCurrent(bool current)
+{
+    return false;
+}
+
+void DestroyHeadlessContext()
+{
+}
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef COMP_371_A2_HEADLESSCONTEXT_H
+#define COMP_371_A2_HEADLESSCONTEXT_H
+
+//this contains the definitions for creating an OpenGL context without a window or a display, so that the viewer can
+//render on machines that have neither (i.e. build servers, with Mesa's llvmpipe). The context is created through EGL
+//with the surfaceless platform, which is only available when the program is built with the HEADLESS_EGL option.
+//Since there is no default framebuffer, everything has to be rendered into a framebuffer object (see Framebuffer.h).
+
+/*
+ * This method creates an OpenGL 3.3 core profile context without a window, and makes it current on this thread.
+ * @return A boolean specifying if the context was created or not.
+ */
+bool CreateHeadlessContext();
+
+/*
+ * This method makes the context current on the calling thread, or releases it so that another thread can make it
+ * current (it can only be current on one thread at a time).
+ * @return A boolean specifying if the context was made current (or released) or not.
+ */
+bool MakeHeadlessContextCurrent(bool current);
+
+/*
+ * This method destroys the context created by CreateHeadlessContext.
+ */
+void DestroyHeadlessContext();
+
+#endif //COMP_371_A2_HEADLESSCONTEXT_H
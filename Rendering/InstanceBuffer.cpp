@@ -0,0 +1,55 @@
+#include "InstanceBuffer.h"
+#include "GLStateCache.h"
+
+void CreateInstanceBuffer(InstanceBuffer& instances)
+{
+    glGenBuffers(1, &instances.buffer);
+    instances.count = 0;
+}
+
+void DeleteInstanceBuffer(InstanceBuffer& instances)
+{
+    glDeleteBuffers(1, &instances.buffer);
+    instances.buffer = 0;
+    instances.count = 0;
+}
+
+void AttachInstanceBuffer(const InstanceBuffer& instances, GLuint vertex_array)
+{
+    BindVertexArrayCached(vertex_array);
+    BindArrayBufferCached(instances.buffer);
+
+    //each column of the matrix is its own attribute
+    for(GLuint column = 0; column < 4; column++)
+    {
+        GLuint location = INSTANCE_MATRIX_LOCATION + column;
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                              (void*)(sizeof(glm::vec4) * column));
+        glVertexAttribDivisor(location, 1);
+    }
+}
+
+void AttachInstanceMatrices(GLuint vertex_array, GLuint buffer, GLintptr offset)
+{
+    BindVertexArrayCached(vertex_array);
+    BindArrayBufferCached(buffer);
+
+    //the attributes are already enabled and advance once per instance, so only where they read from changes
+    for(GLuint column = 0; column < 4; column++)
+        glVertexAttribPointer(INSTANCE_MATRIX_LOCATION + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                              (void*)(offset + sizeof(glm::vec4) * column));
+
+    AddIssuedGLCalls(4);
+}
+
+void UploadInstanceMatrices(InstanceBuffer& instances, const std::vector<glm::mat4>& matrices)
+{
+    BindArrayBufferCached(instances.buffer);
+
+    //the whole buffer is replaced, which lets the driver hand us new storage rather than waiting for draws that may
+    //still be reading the old one
+    glBufferData(GL_ARRAY_BUFFER, sizeof(glm::mat4) * matrices.size(), matrices.empty() ? NULL : &matrices.front(),
+                 GL_STATIC_DRAW);
+    instances.count = matrices.size();
+}
@@ -0,0 +1,56 @@
+#ifndef COMP_371_A2_INSTANCEBUFFER_H
+#define COMP_371_A2_INSTANCEBUFFER_H
+
+#include <glew.h>
+#include <vector>
+#include "../GLM/glm/glm.hpp"
+
+//this contains the definitions for drawing many copies (instances) of the same object in a single draw call. Each
+//instance has its own model matrix, which is kept in a buffer and read by the vertex shader through an instanced
+//attribute (see the INSTANCED define in the vertex shaders). A mat4 attribute takes 4 locations, one per column.
+
+//the first of the 4 attribute locations of the instance matrices
+const GLuint INSTANCE_MATRIX_LOCATION = 2;
+
+/*
+ * This is the buffer holding the model matrix of every instance.
+ */
+struct InstanceBuffer
+{
+    GLuint buffer;
+    int count; //the number of instances in the buffer
+};
+
+/*
+ * This method creates an empty instance buffer.
+ */
+void CreateInstanceBuffer(InstanceBuffer& instances);
+
+/*
+ * This method deletes the buffer of the instances.
+ */
+void DeleteInstanceBuffer(InstanceBuffer& instances);
+
+/*
+ * This method sets up the instance attributes of the passed vertex array to read from the instance buffer, advancing
+ * once per instance instead of once per vertex. This only needs to be done once per vertex array.
+ */
+void AttachInstanceBuffer(const InstanceBuffer& instances, GLuint vertex_array);
+
+/*
+ * This method points the instance attributes of the passed vertex array at matrices somewhere else, i.e. in a stream
+ * buffer (see StreamBuffer.h), until the instance buffer is attached again.
+ * @param vertex_array: The vertex array
+ * @param buffer: The buffer holding the matrices
+ * @param offset: Where the matrix of the first instance is in the buffer
+ */
+void AttachInstanceMatrices(GLuint vertex_array, GLuint buffer, GLintptr offset);
+
+/*
+ * This method replaces the matrices in the instance buffer.
+ * @param instances: The instance buffer. Passed by reference.
+ * @param matrices: The model matrix of each instance
+ */
+void UploadInstanceMatrices(InstanceBuffer& instances, const std::vector<glm::mat4>& matrices);
+
+#endif //COMP_371_A2_INSTANCEBUFFER_H
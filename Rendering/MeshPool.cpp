@@ -0,0 +1,242 @@
+#include "MeshPool.h"
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include "GLStateCache.h"
+
+void CreateMeshPool(MeshPool& pool)
+{
+    glGenBuffers(1, &pool.vertex_buffer);
+    glGenBuffers(1, &pool.normal_buffer);
+    glGenBuffers(1, &pool.index_buffer);
+    glGenBuffers(1, &pool.command_buffer);
+    ClearMeshPool(pool);
+}
+
+void DeleteMeshPool(MeshPool& pool)
+{
+    glDeleteBuffers(1, &pool.vertex_buffer);
+    glDeleteBuffers(1, &pool.normal_buffer);
+    glDeleteBuffers(1, &pool.index_buffer);
+    glDeleteBuffers(1, &pool.command_buffer);
+    pool.vertex_buffer = pool.normal_buffer = pool.index_buffer = pool.command_buffer = 0;
+    ClearMeshPool(pool);
+}
+
+void ClearMeshPool(MeshPool& pool)
+{
+    pool.meshes.clear();
+    pool.index_count = 0;
+    pool.vertices.clear();
+    pool.normals.clear();
+    pool.indices.clear();
+    pool.uploaded_commands.clear();
+}
+
+/*
+ * This is a vertex of a mesh, as the key it is shared by in the index buffer. Two vertices are only the same if their
+ * position and normal are exactly the same.
+ */
+struct VertexKey
+{
+    glm::vec3 position;
+    glm::vec3 normal;
+
+    bool operator==(const VertexKey& other) const
+    {
+        return position == other.position && normal == other.normal;
+    }
+};
+
+struct VertexKeyHash
+{
+    size_t operator()(const VertexKey& key) const
+    {
+        //the bits of the 6 floats, mixed together (FNV-1a)
+        GLuint bits[6];
+        memcpy(bits, &key.position, sizeof(glm::vec3));
+        memcpy(bits + 3, &key.normal, sizeof(glm::vec3));
+
+        size_t hash = 2166136261u;
+        for(int i = 0; i < 6; i++)
+            hash = (hash ^ bits[i]) * 16777619u;
+
+        return hash;
+    }
+};
+
+int AddMeshToPool(MeshPool& pool, const std::vector<glm::vec3>& vertices, const std::vector<glm::vec3>& normals,
+                  int first, int count)
+{
+    PooledMesh mesh;
+    mesh.first_index = pool.indices.size();
+    mesh.index_count = count;
+    mesh.base_vertex = pool.vertices.size();
+
+    //the indices are relative to the first vertex of the mesh, which is passed to the draw as its base vertex
+    std::unordered_map<VertexKey, GLuint, VertexKeyHash> shared;
+    shared.reserve(count);
+    for(int i = first; i < first + count; i++)
+    {
+        VertexKey key = {vertices[i], i < normals.size() ? normals[i] : glm::vec3(0)};
+        std::pair<std::unordered_map<VertexKey, GLuint, VertexKeyHash>::iterator, bool> inserted =
+            shared.insert(std::make_pair(key, (GLuint)(pool.vertices.size() - mesh.base_vertex)));
+
+        if(inserted.second)
+        {
+            pool.vertices.push_back(key.position);
+            pool.normals.push_back(key.normal);
+        }
+
+        pool.indices.push_back(inserted.first->second);
+    }
+
+    pool.meshes.push_back(mesh);
+    pool.index_count += count;
+    return pool.meshes.size() - 1;
+}
+
+void UploadMeshPool(MeshPool& pool)
+{
+    BindArrayBufferCached(pool.vertex_buffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * pool.vertices.size(),
+                 pool.vertices.empty() ? NULL : &pool.vertices.front(), GL_STATIC_DRAW);
+
+    BindArrayBufferCached(pool.normal_buffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * pool.normals.size(),
+                 pool.normals.empty() ? NULL : &pool.normals.front(), GL_STATIC_DRAW);
+
+    //the element array binding belongs to whatever vertex array is bound, so the index buffer is filled through another
+    //target to leave it alone
+    glBindBuffer(GL_COPY_WRITE_BUFFER, pool.index_buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, sizeof(GLuint) * pool.indices.size(),
+                 pool.indices.empty() ? NULL : &pool.indices.front(), GL_STATIC_DRAW);
+
+    //the data is only needed until it is on the GPU
+    std::vector<glm::vec3>().swap(pool.vertices);
+    std::vector<glm::vec3>().swap(pool.normals);
+    std::vector<GLuint>().swap(pool.indices);
+}
+
+void AttachMeshPool(const MeshPool& pool, GLuint vertex_array)
+{
+    BindVertexArrayCached(vertex_array);
+
+    glEnableVertexAttribArray(0);
+    BindArrayBufferCached(pool.vertex_buffer);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+
+    glEnableVertexAttribArray(1);
+    BindArrayBufferCached(pool.normal_buffer);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pool.index_buffer);
+}
+
+bool CanMultiDrawMeshPool()
+{
+    return GLEW_VERSION_4_3 != 0;
+}
+
+bool CanBaseInstanceMeshPool()
+{
+    return GLEW_VERSION_4_2 != 0 || GLEW_ARB_base_instance != 0;
+}
+
+/*
+ * This fills in the command of each packet.
+ */
+static void WriteDrawCommands(const MeshPool& pool, const std::vector<DrawPacket>& packets,
+                              DrawElementsIndirectCommand* commands)
+{
+    for(int i = 0; i < packets.size(); i++)
+    {
+        const PooledMesh& mesh = pool.meshes[packets[i].mesh];
+        DrawElementsIndirectCommand& command = commands[i];
+        command.count = mesh.index_count;
+        command.instance_count = packets[i].instance_count;
+        command.first_index = mesh.first_index;
+        command.base_vertex = mesh.base_vertex;
+        command.base_instance = packets[i].first_instance;
+    }
+}
+
+void DrawMeshPool(MeshPool& pool, int instance_count, bool multi_draw, StreamBuffer* stream)
+{
+    //every mesh is drawn for all of the instances (once, without instancing)
+    std::vector<DrawPacket>& packets = pool.packets;
+    packets.resize(pool.meshes.size());
+    for(int i = 0; i < packets.size(); i++)
+    {
+        DrawPacket packet = {i, 0, std::max(instance_count, 1)};
+        packets[i] = packet;
+    }
+
+    DrawMeshPoolPackets(pool, packets, instance_count > 0, multi_draw, stream);
+}
+
+void DrawMeshPoolPackets(MeshPool& pool, const std::vector<DrawPacket>& packets, bool instanced, bool multi_draw,
+                         StreamBuffer* stream)
+{
+    int count = packets.size();
+    if(multi_draw && CanMultiDrawMeshPool())
+    {
+        //the commands are written straight into the stream buffer, if there is room for them
+        GLintptr offset = 0;
+        void* streamed = NULL;
+        if(stream != NULL)
+            streamed = AllocateStreamBuffer(*stream, sizeof(DrawElementsIndirectCommand) * count, sizeof(GLuint),
+                                            offset);
+
+        if(streamed != NULL)
+        {
+            WriteDrawCommands(pool, packets, (DrawElementsIndirectCommand*)streamed);
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, stream->buffer);
+            AddIssuedGLCalls(1);
+        }
+
+        else
+        {
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, pool.command_buffer);
+            AddIssuedGLCalls(1);
+
+            //the commands are only uploaded again when they change (i.e. when culling)
+            std::vector<DrawElementsIndirectCommand> commands(count);
+            WriteDrawCommands(pool, packets, commands.empty() ? NULL : &commands.front());
+            if(commands.size() != pool.uploaded_commands.size() ||
+               memcmp(commands.data(), pool.uploaded_commands.data(), sizeof(DrawElementsIndirectCommand) * count) != 0)
+            {
+                glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(DrawElementsIndirectCommand) * count,
+                             commands.empty() ? NULL : &commands.front(), GL_DYNAMIC_DRAW);
+                pool.uploaded_commands.swap(commands);
+                AddIssuedGLCalls(1);
+            }
+        }
+
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)offset, count, 0);
+        AddDrawCalls(1);
+        return;
+    }
+
+    //without it, each packet is its own draw call. Only the packets that do not start at the first instance need
+    //CanBaseInstanceMeshPool.
+    for(int i = 0; i < count; i++)
+    {
+        const DrawPacket& packet = packets[i];
+        const PooledMesh& mesh = pool.meshes[packet.mesh];
+        void* offset = (void*)(sizeof(GLuint) * mesh.first_index);
+        if(!instanced)
+            glDrawElementsBaseVertex(GL_TRIANGLES, mesh.index_count, GL_UNSIGNED_INT, offset, mesh.base_vertex);
+
+        else if(packet.first_instance == 0)
+            glDrawElementsInstancedBaseVertex(GL_TRIANGLES, mesh.index_count, GL_UNSIGNED_INT, offset,
+                                              packet.instance_count, mesh.base_vertex);
+
+        else
+            glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, mesh.index_count, GL_UNSIGNED_INT, offset,
+                                                          packet.instance_count, mesh.base_vertex,
+                                                          packet.first_instance);
+    }
+
+    AddDrawCalls(count);
+}
@@ -0,0 +1,139 @@
+#ifndef COMP_371_A2_MESHPOOL_H
+#define COMP_371_A2_MESHPOOL_H
+
+#include <glew.h>
+#include <vector>
+#include "../GLM/glm/glm.hpp"
+#include "StreamBuffer.h"
+#include "DrawPackets.h"
+
+//this contains the definitions for packing any number of meshes into a single set of vertex, normal and index buffers,
+//so that they can all be drawn with the same vertex array. Each mesh keeps where its indices and vertices start in the
+//buffers, and is drawn by an indirect command that points at them (see DrawElementsIndirectCommand in the OpenGL
+//specification). When the driver has it (OpenGL 4.3), the commands of every mesh are issued in a single call to
+//glMultiDrawElementsIndirect, and otherwise with one draw call per mesh. The commands are written into a stream buffer
+//every frame when there is one (see StreamBuffer.h), and kept in a buffer of the pool otherwise.
+//
+//The vertices of each mesh are shared between its triangles wherever they have the same position and normal, which is
+//what the index buffer is for.
+
+/*
+ * This is an indirect draw of indexed triangles, laid out the way OpenGL reads it from the draw indirect buffer.
+ */
+struct DrawElementsIndirectCommand
+{
+    GLuint count; //the number of indices
+    GLuint instance_count;
+    GLuint first_index;
+    GLint base_vertex;
+    GLuint base_instance; //the first instance the instanced attributes are read from
+};
+
+/*
+ * This is where one of the meshes of the pool is in the buffers.
+ */
+struct PooledMesh
+{
+    GLuint first_index;
+    GLsizei index_count;
+    GLint base_vertex;
+};
+
+/*
+ * This holds the buffers shared by every mesh, the commands that draw them, and a copy of the data until it is
+ * uploaded.
+ */
+struct MeshPool
+{
+    GLuint vertex_buffer;
+    GLuint normal_buffer;
+    GLuint index_buffer;
+    GLuint command_buffer; //the draw indirect buffer, one command per mesh
+
+    std::vector<PooledMesh> meshes;
+    GLsizei index_count; //the number of indices of all of the meshes together
+
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec3> normals;
+    std::vector<GLuint> indices;
+
+    //the commands in the command buffer, so that they are only uploaded when they change, and the packets drawing
+    //every mesh once
+    std::vector<DrawElementsIndirectCommand> uploaded_commands;
+    std::vector<DrawPacket> packets;
+};
+
+/*
+ * This method creates an empty pool.
+ */
+void CreateMeshPool(MeshPool& pool);
+
+/*
+ * This method deletes the buffers of the pool.
+ */
+void DeleteMeshPool(MeshPool& pool);
+
+/*
+ * This method removes every mesh from the pool. The buffers keep their data until the pool is uploaded again.
+ */
+void ClearMeshPool(MeshPool& pool);
+
+/*
+ * This method adds a range of the triangles of a mesh to the pool, as a mesh of its own.
+ * @param pool: The pool. Passed by reference.
+ * @param vertices: The vertices of the triangles (3 per triangle), as loaded by LoadOBJ
+ * @param normals: The normal of each vertex
+ * @param first: The first vertex of the range (a multiple of 3)
+ * @param count: The number of vertices in the range (a multiple of 3)
+ * @return The index of the new mesh in the pool
+ */
+int AddMeshToPool(MeshPool& pool, const std::vector<glm::vec3>& vertices, const std::vector<glm::vec3>& normals,
+                  int first, int count);
+
+/*
+ * This method replaces the data of the buffers with the meshes added since the pool was last cleared, and frees the
+ * copy that was kept of them.
+ */
+void UploadMeshPool(MeshPool& pool);
+
+/*
+ * This method sets up the position (0) and normal (1) attributes of the passed vertex array to read from the pool, and
+ * its element array to be the index buffer. This only needs to be done once per vertex array.
+ */
+void AttachMeshPool(const MeshPool& pool, GLuint vertex_array);
+
+/*
+ * This method checks if the commands can be issued in a single glMultiDrawElementsIndirect (OpenGL 4.3).
+ */
+bool CanMultiDrawMeshPool();
+
+/*
+ * This method checks if a draw can start at any instance (OpenGL 4.2, or ARB_base_instance), rather than only at the
+ * first one. The commands of a single glMultiDrawElementsIndirect always can.
+ */
+bool CanBaseInstanceMeshPool();
+
+/*
+ * This method draws every mesh of the pool with the current program and vertex array, which must be attached to the
+ * pool.
+ * @param pool: The pool. Passed by reference.
+ * @param instance_count: The number of instances of each mesh, or 0 to draw them once without instancing
+ * @param multi_draw: Whether all of the meshes are drawn in a single call, rather than one call per mesh. This is
+ * ignored if CanMultiDrawMeshPool is false.
+ * @param stream: The stream buffer the commands are written into for this frame, or NULL to keep them in the pool
+ */
+void DrawMeshPool(MeshPool& pool, int instance_count, bool multi_draw, StreamBuffer* stream);
+
+/*
+ * This method draws the passed packets (see DrawPackets.h) the same way, each of them with its own command. Without a
+ * single multi-draw, the packets that do not start at the first instance need CanBaseInstanceMeshPool.
+ * @param pool: The pool. Passed by reference.
+ * @param packets: The meshes to draw, and the instances to draw each of them for
+ * @param instanced: Whether the vertex array reads instance matrices (the packets are drawn once otherwise)
+ * @param multi_draw: Whether all of the packets are drawn in a single call, rather than one call each
+ * @param stream: The stream buffer the commands are written into for this frame, or NULL to keep them in the pool
+ */
+void DrawMeshPoolPackets(MeshPool& pool, const std::vector<DrawPacket>& packets, bool instanced, bool multi_draw,
+                         StreamBuffer* stream);
+
+#endif //COMP_371_A2_MESHPOOL_H
@@ -0,0 +1,98 @@
+#include "RenderState.h"
+#include "../Loaders/ShaderVariants.h"
+
+RenderState::RenderState()
+{
+    projection = glm::mat4(1.0f);
+
+    //initially all the channels and the light are on, and we use the Phong permutations
+    toggles = DEFAULT_TOGGLES;
+    gouraud = GL_FALSE;
+    uber_shader = GL_FALSE;
+
+    light_position = glm::vec3(0, 20, 5);
+    light_color = glm::vec3(0.8, 0.8, 0.8);
+    view_position = glm::vec3(100, 100, 100);
+
+    //nothing has been sent to OpenGL yet
+    dirty = DIRTY_ALL;
+}
+
+/*
+ * This sets the uniform if the program uses it, and returns the number of calls made to OpenGL (0 or 1).
+ */
+template<typename T, typename V>
+static int FlushUniform(const Uniform<T>& uniform, const V& value)
+{
+    if(uniform.location < 0)
+        return 0;
+
+    SetUniform(uniform, value);
+    return 1;
+}
+
+int FlushRenderState(RenderState& state, const ProgramUniforms& uniforms)
+{
+    int calls = 0;
+
+    if(state.dirty & DIRTY_MODEL)
+        calls += FlushUniform(uniforms.model_matrix, GetTransformMatrix(state.model));
+
+    if(state.dirty & DIRTY_VIEW)
+        calls += FlushUniform(uniforms.view_matrix, GetTransformMatrix(state.view));
+
+    if(state.dirty & DIRTY_PROJECTION)
+        calls += FlushUniform(uniforms.projection_matrix, state.projection);
+
+    //these only exist in the uber-shaders, since the permutations have them baked in
+    if(state.dirty & DIRTY_TOGGLES)
+    {
+        calls += FlushUniform(uniforms.red_channel, state.toggles & TOGGLE_RED_CHANNEL ? 1.0f : 0.0f);
+        calls += FlushUniform(uniforms.green_channel, state.toggles & TOGGLE_GREEN_CHANNEL ? 1.0f : 0.0f);
+        calls += FlushUniform(uniforms.blue_channel, state.toggles & TOGGLE_BLUE_CHANNEL ? 1.0f : 0.0f);
+        calls += FlushUniform(uniforms.light_on, state.toggles & TOGGLE_LIGHT_ON ? 1 : 0);
+        calls += FlushUniform(uniforms.normal_as_color, state.toggles & TOGGLE_NORMAL_AS_COLOR ? 1 : 0);
+        calls += FlushUniform(uniforms.gray_scale, state.toggles & TOGGLE_GRAY_SCALE ? 1 : 0);
+    }
+
+    if(state.dirty & DIRTY_LIGHT)
+    {
+        calls += FlushUniform(uniforms.light_position, state.light_position);
+        calls += FlushUniform(uniforms.light_color, state.light_color);
+        calls += FlushUniform(uniforms.view_position, state.view_position);
+    }
+
+    state.dirty = 0;
+    return calls;
+}
+
+/*
+ * This adds the passed bytes to a 32 bit FNV-1a hash.
+ */
+static unsigned int HashBytes(unsigned int hash, const void* data, size_t size)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    for(size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+unsigned int HashRenderState(const RenderState& state)
+{
+    unsigned int hash = 2166136261u;
+    hash = HashBytes(hash, &state.model.position[0], sizeof(state.model.position));
+    hash = HashBytes(hash, &state.model.orientation[0], sizeof(state.model.orientation));
+    hash = HashBytes(hash, &state.model.scale, sizeof(state.model.scale));
+    hash = HashBytes(hash, &state.view.position[0], sizeof(state.view.position));
+    hash = HashBytes(hash, &state.view.orientation[0], sizeof(state.view.orientation));
+    hash = HashBytes(hash, &state.view.scale, sizeof(state.view.scale));
+    hash = HashBytes(hash, &state.projection[0][0], sizeof(state.projection));
+    hash = HashBytes(hash, &state.toggles, sizeof(state.toggles));
+    hash = HashBytes(hash, &state.gouraud, sizeof(state.gouraud));
+    hash = HashBytes(hash, &state.uber_shader, sizeof(state.uber_shader));
+    return hash;
+}
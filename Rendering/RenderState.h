@@ -0,0 +1,71 @@
+#ifndef COMP_371_A2_RENDERSTATE_H
+#define COMP_371_A2_RENDERSTATE_H
+
+#include <glew.h>
+#include <GLFW/glfw3.h>
+#include "../GLM/glm/matrix.hpp"
+#include "../Loaders/ShaderReflection.h"
+#include "../Scene/Transform.h"
+
+//this contains the definitions for the CPU side copy of everything the shaders need to know about the scene. The
+//controls only ever change this copy (and mark what they changed as dirty), and the changes are sent to OpenGL once
+//per frame by FlushRenderState. Nothing ever needs to be read back from OpenGL.
+
+/*
+ * These are the bits that say which parts of the render state have changed since the last flush.
+ */
+enum RenderStateDirty
+{
+    DIRTY_MODEL = 1 << 0,
+    DIRTY_VIEW = 1 << 1,
+    DIRTY_PROJECTION = 1 << 2,
+    DIRTY_TOGGLES = 1 << 3,
+    DIRTY_LIGHT = 1 << 4,
+    DIRTY_ALL = DIRTY_MODEL | DIRTY_VIEW | DIRTY_PROJECTION | DIRTY_TOGGLES | DIRTY_LIGHT
+};
+
+/*
+ * This is the authoritative state of the scene.
+ */
+struct RenderState
+{
+    //the Model View Projection matrices. The model and view are kept as transforms (see Transform.h), whose matrices
+    //are only rebuilt when they are flushed after changing.
+    Transform model;
+    Transform view;
+    glm::mat4 projection;
+
+    //the color channel, light, normal as color and grayscale toggles (ShaderToggle flags)
+    unsigned int toggles;
+
+    //which illumination model is used, and whether it is the uber-shader or the permutations
+    GLboolean gouraud;
+    GLboolean uber_shader;
+
+    //the light (see Lighting.glsl)
+    glm::vec3 light_position;
+    glm::vec3 light_color;
+    glm::vec3 view_position;
+
+    //the RenderStateDirty bits for everything that changed since the last flush
+    unsigned int dirty;
+
+    RenderState();
+};
+
+/*
+ * This method sends every dirty part of the state to the current program through its uniform handles, and then
+ * clears the dirty bits. Uniforms the program does not use are skipped.
+ * @param state: The render state to flush. Passed by reference.
+ * @param uniforms: The handles for the uniforms of the current program
+ * @return The number of OpenGL calls that were made
+ */
+int FlushRenderState(RenderState& state, const ProgramUniforms& uniforms);
+
+/*
+ * This method computes a hash of the matrices, toggles and flags of the state. Two runs that end with the same hash
+ * ended up in the same state (i.e. when checking that replaying a recording is deterministic).
+ */
+unsigned int HashRenderState(const RenderState& state);
+
+#endif //COMP_371_A2_RENDERSTATE_H
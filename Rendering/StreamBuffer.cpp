@@ -0,0 +1,129 @@
+#include "StreamBuffer.h"
+#include "../Stats/Clock.h"
+#include "GLStateCache.h"
+
+//how long a single wait for a fence lasts before it is checked again, in nanoseconds
+const GLuint64 STREAM_WAIT_TIMEOUT_NS = 1000000;
+
+bool CanStreamBuffer()
+{
+    return GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+}
+
+void CreateStreamBuffer(StreamBuffer& stream, GLsizeiptr frame_size)
+{
+    //every region starts on a multiple of 256 bytes, so that the alignment of what is written in it is the same for
+    //all of them
+    frame_size = (frame_size + 255) / 256 * 256;
+    stream.frame_size = frame_size;
+    stream.frame = 0;
+    stream.used = 0;
+    stream.waits = 0;
+    stream.wait_ms = 0;
+    for(int i = 0; i < STREAM_BUFFER_FRAMES; i++)
+        stream.fences[i] = 0;
+
+    //the mapping is coherent, so what the CPU writes is seen by the GPU without flushing it, and the fences are all
+    //that keeps the two from touching the same region at once
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glGenBuffers(1, &stream.buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, stream.buffer);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, frame_size * STREAM_BUFFER_FRAMES, NULL, flags);
+    stream.mapped = (char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, frame_size * STREAM_BUFFER_FRAMES, flags);
+}
+
+void DeleteStreamBuffer(StreamBuffer& stream)
+{
+    for(int i = 0; i < STREAM_BUFFER_FRAMES; i++)
+    {
+        if(stream.fences[i] != 0)
+            glDeleteSync(stream.fences[i]);
+
+        stream.fences[i] = 0;
+    }
+
+    if(stream.buffer == 0)
+        return;
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, stream.buffer);
+    glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    glDeleteBuffers(1, &stream.buffer);
+    stream.buffer = 0;
+    stream.mapped = NULL;
+}
+
+/*
+ * This waits for the GPU to be done with the region of the passed frame, if it has not been already.
+ * @return The number of OpenGL calls made
+ */
+static int WaitForRegion(StreamBuffer& stream, int frame)
+{
+    GLsync& fence = stream.fences[frame];
+    if(fence == 0)
+        return 0;
+
+    int calls = 2;
+    GLenum status = glClientWaitSync(fence, 0, 0);
+    if(status == GL_TIMEOUT_EXPIRED)
+    {
+        //the first wait flushes, so that the fence is sure to be signaled eventually
+        double start_time = GetTime();
+        GLbitfield wait_flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+        do
+        {
+            status = glClientWaitSync(fence, wait_flags, STREAM_WAIT_TIMEOUT_NS);
+            wait_flags = 0;
+            calls++;
+        }
+        while(status == GL_TIMEOUT_EXPIRED);
+
+        stream.waits++;
+        stream.wait_ms += (GetTime() - start_time) * 1000.0;
+    }
+
+    glDeleteSync(fence);
+    fence = 0;
+    return calls;
+}
+
+void ReserveStreamBuffer(StreamBuffer& stream, GLsizeiptr frame_size)
+{
+    if(frame_size <= stream.frame_size)
+        return;
+
+    //the storage of the buffer can not change, so a bigger one takes its place once nothing reads the old one anymore.
+    //The counters carry over.
+    for(int i = 0; i < STREAM_BUFFER_FRAMES; i++)
+        WaitForRegion(stream, i);
+
+    int waits = stream.waits;
+    double wait_ms = stream.wait_ms;
+    DeleteStreamBuffer(stream);
+    CreateStreamBuffer(stream, frame_size);
+    stream.waits = waits;
+    stream.wait_ms = wait_ms;
+}
+
+void BeginStreamFrame(StreamBuffer& stream)
+{
+    stream.frame = (stream.frame + 1) % STREAM_BUFFER_FRAMES;
+    stream.used = 0;
+    AddIssuedGLCalls(WaitForRegion(stream, stream.frame));
+}
+
+void* AllocateStreamBuffer(StreamBuffer& stream, GLsizeiptr size, GLsizeiptr alignment, GLintptr& out_offset)
+{
+    GLsizeiptr start = (stream.used + alignment - 1) / alignment * alignment;
+    if(start + size > stream.frame_size)
+        return NULL;
+
+    stream.used = start + size;
+    out_offset = stream.frame_size * stream.frame + start;
+    return stream.mapped + out_offset;
+}
+
+void EndStreamFrame(StreamBuffer& stream)
+{
+    stream.fences[stream.frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    AddIssuedGLCalls(1);
+}
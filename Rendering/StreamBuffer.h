@@ -0,0 +1,80 @@
+#ifndef COMP_371_A2_STREAMBUFFER_H
+#define COMP_371_A2_STREAMBUFFER_H
+
+#include <glew.h>
+
+//this contains the definitions for a buffer that the data written every frame (the matrices of the visible instances
+//and the indirect draw commands) is streamed through. The buffer is created with immutable storage (glBufferStorage,
+//OpenGL 4.4) and stays mapped for as long as it exists, so the CPU writes straight into it without any call into
+//OpenGL, and without the driver having to copy or reallocate anything.
+//
+//The buffer is split into one region per frame in flight. Each frame writes into its own region, and puts a fence
+//after the draws that read it. Before a region is written again, STREAM_BUFFER_FRAMES frames later, its fence is
+//checked: if the GPU is not done with it yet, the CPU has to wait, which is counted so that we can see when the GPU is
+//falling behind.
+
+//the number of regions, so that the CPU can be writing one frame while the GPU is still reading the two before it
+const int STREAM_BUFFER_FRAMES = 3;
+
+/*
+ * This is a persistently mapped buffer, split in one region per frame in flight.
+ */
+struct StreamBuffer
+{
+    GLuint buffer;
+    char* mapped; //where the whole buffer is mapped
+    GLsizeiptr frame_size; //the size of the region of each frame
+    int frame; //the region being written
+    GLsizeiptr used; //how much of that region has been handed out
+    GLsync fences[STREAM_BUFFER_FRAMES]; //the fence after the draws that read each region (0 if there is none)
+
+    int waits; //the number of times a region was still being read by the GPU, since these were last reset
+    double wait_ms; //the time spent waiting for those regions
+};
+
+/*
+ * This method checks if the driver can map a buffer persistently (OpenGL 4.4, or ARB_buffer_storage).
+ */
+bool CanStreamBuffer();
+
+/*
+ * This method creates a stream buffer and maps it.
+ * @param stream: This will hold the new buffer. Passed by reference.
+ * @param frame_size: The most data that can be written per frame, in bytes
+ */
+void CreateStreamBuffer(StreamBuffer& stream, GLsizeiptr frame_size);
+
+/*
+ * This method unmaps and deletes the buffer.
+ */
+void DeleteStreamBuffer(StreamBuffer& stream);
+
+/*
+ * This method makes sure that at least the passed number of bytes can be written per frame. If the regions are too
+ * small, the buffer is created again with bigger ones, which waits for the GPU to be done with all of them.
+ */
+void ReserveStreamBuffer(StreamBuffer& stream, GLsizeiptr frame_size);
+
+/*
+ * This method moves on to the region of the next frame, waiting for the GPU to be done reading it if it has to. It is
+ * called once per frame, before anything is written.
+ */
+void BeginStreamFrame(StreamBuffer& stream);
+
+/*
+ * This method hands out part of the region of the current frame.
+ * @param stream: The stream buffer. Passed by reference.
+ * @param size: The number of bytes to write
+ * @param alignment: What the offset of the data in the buffer must be a multiple of
+ * @param out_offset: This will hold the offset of the data in the buffer, to point OpenGL at it. Passed by reference.
+ * @return Where to write the data, or NULL if there is not enough room left in the region
+ */
+void* AllocateStreamBuffer(StreamBuffer& stream, GLsizeiptr size, GLsizeiptr alignment, GLintptr& out_offset);
+
+/*
+ * This method puts a fence after everything that has been submitted to read the region of the current frame. It is
+ * called once per frame, after the last draw.
+ */
+void EndStreamFrame(StreamBuffer& stream);
+
+#endif //COMP_371_A2_STREAMBUFFER_H
@@ -0,0 +1,272 @@
+#include "FrustumCulling.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "../Threading/ParallelFor.h"
+
+//the instances are tested 8 at a time with AVX2 (when the compiler targets it, see the SIMD_AVX2 option), 4 at a time
+//with SSE (which all x86-64 compilers target), and one at a time otherwise
+#if defined(__AVX2__)
+#define COMP_371_A2_CULLING_AVX2
+#include <immintrin.h>
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define COMP_371_A2_CULLING_SSE
+#include <xmmintrin.h>
+#endif
+
+//the number of entries the bounds are padded to, which is enough for any of the instruction sets
+const int BOUNDS_PADDING = 8;
+
+//the number of instances culled by each task, which is a multiple of the padding so that only the last chunk has a
+//partial group of instances
+const int CULLING_CHUNK_SIZE = 4096;
+
+void ExtractFrustumPlanes(const glm::mat4& matrix, Frustum& out_frustum)
+{
+    //each plane is the sum or the difference of the last row of the matrix and one of the others (the matrix is column
+    //major, so a row is made of the same component of every column)
+    glm::vec4 rows[4];
+    for(int i = 0; i < 4; i++)
+        rows[i] = glm::vec4(matrix[0][i], matrix[1][i], matrix[2][i], matrix[3][i]);
+
+    out_frustum.planes[0] = rows[3] + rows[0];
+    out_frustum.planes[1] = rows[3] - rows[0];
+    out_frustum.planes[2] = rows[3] + rows[1];
+    out_frustum.planes[3] = rows[3] - rows[1];
+    out_frustum.planes[4] = rows[3] + rows[2];
+    out_frustum.planes[5] = rows[3] - rows[2];
+
+    for(int i = 0; i < 6; i++)
+        out_frustum.planes[i] /= glm::length(glm::vec3(out_frustum.planes[i]));
+}
+
+void BuildInstanceBounds(const std::vector<glm::mat4>& matrices, const glm::vec3& box_min, const glm::vec3& box_max,
+                         float radius, InstanceBounds& out_bounds)
+{
+    int count = matrices.size();
+    int padded = (count + BOUNDS_PADDING - 1) / BOUNDS_PADDING * BOUNDS_PADDING;
+
+    out_bounds.count = count;
+    out_bounds.center_x.assign(padded, 0);
+    out_bounds.center_y.assign(padded, 0);
+    out_bounds.center_z.assign(padded, 0);
+    out_bounds.radius.assign(padded, 0);
+    out_bounds.box_x.assign(padded, 0);
+    out_bounds.box_y.assign(padded, 0);
+    out_bounds.box_z.assign(padded, 0);
+    out_bounds.extent_x.assign(padded, 0);
+    out_bounds.extent_y.assign(padded, 0);
+    out_bounds.extent_z.assign(padded, 0);
+
+    glm::vec3 box_center = (box_min + box_max) * 0.5f;
+    glm::vec3 box_extent = (box_max - box_min) * 0.5f;
+
+    for(int i = 0; i < count; i++)
+    {
+        const glm::mat4& matrix = matrices[i];
+
+        //the sphere moves with the origin of the instance, and grows with the largest of its scales
+        float scale = std::max(glm::length(glm::vec3(matrix[0])),
+                               std::max(glm::length(glm::vec3(matrix[1])), glm::length(glm::vec3(matrix[2]))));
+        out_bounds.center_x[i] = matrix[3].x;
+        out_bounds.center_y[i] = matrix[3].y;
+        out_bounds.center_z[i] = matrix[3].z;
+        out_bounds.radius[i] = radius * scale;
+
+        //the box is the one that holds the transformed box of the object, whose half size along each axis is the sum
+        //of the half sizes of the object projected onto that axis
+        glm::vec3 center = glm::vec3(matrix * glm::vec4(box_center, 1.0f));
+        glm::vec3 extent = glm::abs(glm::vec3(matrix[0])) * box_extent.x +
+                           glm::abs(glm::vec3(matrix[1])) * box_extent.y +
+                           glm::abs(glm::vec3(matrix[2])) * box_extent.z;
+        out_bounds.box_x[i] = center.x;
+        out_bounds.box_y[i] = center.y;
+        out_bounds.box_z[i] = center.z;
+        out_bounds.extent_x[i] = extent.x;
+        out_bounds.extent_y[i] = extent.y;
+        out_bounds.extent_z[i] = extent.z;
+    }
+}
+
+/*
+ * This culls the instances from first (a multiple of the padding) to last, and writes the indices of the visible
+ * ones to out_visible, which must have room for the whole range rounded up to the padding.
+ * @return The number of visible instances
+ */
+static int CullRange(const Frustum& frustum, const InstanceBounds& bounds, int first, int last, int* out_visible)
+{
+    int visible = 0;
+
+#if defined(COMP_371_A2_CULLING_AVX2)
+    const int lanes = 8;
+    __m256 plane_x[6], plane_y[6], plane_z[6], plane_w[6], abs_x[6], abs_y[6], abs_z[6];
+    for(int p = 0; p < 6; p++)
+    {
+        const glm::vec4& plane = frustum.planes[p];
+        plane_x[p] = _mm256_set1_ps(plane.x);
+        plane_y[p] = _mm256_set1_ps(plane.y);
+        plane_z[p] = _mm256_set1_ps(plane.z);
+        plane_w[p] = _mm256_set1_ps(plane.w);
+        abs_x[p] = _mm256_set1_ps(std::fabs(plane.x));
+        abs_y[p] = _mm256_set1_ps(std::fabs(plane.y));
+        abs_z[p] = _mm256_set1_ps(std::fabs(plane.z));
+    }
+
+    for(int i = first; i < last; i += lanes)
+    {
+        __m256 center_x = _mm256_loadu_ps(&bounds.center_x[i]);
+        __m256 center_y = _mm256_loadu_ps(&bounds.center_y[i]);
+        __m256 center_z = _mm256_loadu_ps(&bounds.center_z[i]);
+        __m256 radius = _mm256_loadu_ps(&bounds.radius[i]);
+        __m256 box_x = _mm256_loadu_ps(&bounds.box_x[i]);
+        __m256 box_y = _mm256_loadu_ps(&bounds.box_y[i]);
+        __m256 box_z = _mm256_loadu_ps(&bounds.box_z[i]);
+        __m256 extent_x = _mm256_loadu_ps(&bounds.extent_x[i]);
+        __m256 extent_y = _mm256_loadu_ps(&bounds.extent_y[i]);
+        __m256 extent_z = _mm256_loadu_ps(&bounds.extent_z[i]);
+        __m256 outside = _mm256_setzero_ps();
+
+        for(int p = 0; p < 6; p++)
+        {
+            //the sphere is outside if its center is further than its radius behind the plane, and the box is outside
+            //if its center is further behind than the extent of the box along the normal of the plane
+            __m256 sphere_distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(plane_x[p], center_x),
+                                                                 _mm256_mul_ps(plane_y[p], center_y)),
+                                                   _mm256_add_ps(_mm256_mul_ps(plane_z[p], center_z), plane_w[p]));
+            __m256 box_distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(plane_x[p], box_x),
+                                                              _mm256_mul_ps(plane_y[p], box_y)),
+                                                _mm256_add_ps(_mm256_mul_ps(plane_z[p], box_z), plane_w[p]));
+            __m256 box_radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(abs_x[p], extent_x),
+                                                            _mm256_mul_ps(abs_y[p], extent_y)),
+                                              _mm256_mul_ps(abs_z[p], extent_z));
+
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(sphere_distance, radius),
+                                                          _mm256_setzero_ps(), _CMP_LT_OQ));
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(box_distance, box_radius),
+                                                          _mm256_setzero_ps(), _CMP_LT_OQ));
+        }
+
+        int mask = ~_mm256_movemask_ps(outside);
+#elif defined(COMP_371_A2_CULLING_SSE)
+    const int lanes = 4;
+    __m128 plane_x[6], plane_y[6], plane_z[6], plane_w[6], abs_x[6], abs_y[6], abs_z[6];
+    for(int p = 0; p < 6; p++)
+    {
+        const glm::vec4& plane = frustum.planes[p];
+        plane_x[p] = _mm_set1_ps(plane.x);
+        plane_y[p] = _mm_set1_ps(plane.y);
+        plane_z[p] = _mm_set1_ps(plane.z);
+        plane_w[p] = _mm_set1_ps(plane.w);
+        abs_x[p] = _mm_set1_ps(std::fabs(plane.x));
+        abs_y[p] = _mm_set1_ps(std::fabs(plane.y));
+        abs_z[p] = _mm_set1_ps(std::fabs(plane.z));
+    }
+
+    for(int i = first; i < last; i += lanes)
+    {
+        __m128 center_x = _mm_loadu_ps(&bounds.center_x[i]);
+        __m128 center_y = _mm_loadu_ps(&bounds.center_y[i]);
+        __m128 center_z = _mm_loadu_ps(&bounds.center_z[i]);
+        __m128 radius = _mm_loadu_ps(&bounds.radius[i]);
+        __m128 box_x = _mm_loadu_ps(&bounds.box_x[i]);
+        __m128 box_y = _mm_loadu_ps(&bounds.box_y[i]);
+        __m128 box_z = _mm_loadu_ps(&bounds.box_z[i]);
+        __m128 extent_x = _mm_loadu_ps(&bounds.extent_x[i]);
+        __m128 extent_y = _mm_loadu_ps(&bounds.extent_y[i]);
+        __m128 extent_z = _mm_loadu_ps(&bounds.extent_z[i]);
+        __m128 outside = _mm_setzero_ps();
+
+        for(int p = 0; p < 6; p++)
+        {
+            //the sphere is outside if its center is further than its radius behind the plane, and the box is outside
+            //if its center is further behind than the extent of the box along the normal of the plane
+            __m128 sphere_distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(plane_x[p], center_x),
+                                                           _mm_mul_ps(plane_y[p], center_y)),
+                                                _mm_add_ps(_mm_mul_ps(plane_z[p], center_z), plane_w[p]));
+            __m128 box_distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(plane_x[p], box_x), _mm_mul_ps(plane_y[p], box_y)),
+                                             _mm_add_ps(_mm_mul_ps(plane_z[p], box_z), plane_w[p]));
+            __m128 box_radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(abs_x[p], extent_x), _mm_mul_ps(abs_y[p], extent_y)),
+                                           _mm_mul_ps(abs_z[p], extent_z));
+
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(sphere_distance, radius), _mm_setzero_ps()));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(box_distance, box_radius), _mm_setzero_ps()));
+        }
+
+        int mask = ~_mm_movemask_ps(outside);
+#else
+    const int lanes = 1;
+    for(int i = first; i < last; i++)
+    {
+        bool outside = false;
+
+        for(int p = 0; p < 6; p++)
+        {
+            const glm::vec4& plane = frustum.planes[p];
+            float sphere_distance = plane.x * bounds.center_x[i] + plane.y * bounds.center_y[i] +
+                                    plane.z * bounds.center_z[i] + plane.w;
+            float box_distance = plane.x * bounds.box_x[i] + plane.y * bounds.box_y[i] + plane.z * bounds.box_z[i] +
+                                 plane.w;
+            float box_radius = std::fabs(plane.x) * bounds.extent_x[i] + std::fabs(plane.y) * bounds.extent_y[i] +
+                               std::fabs(plane.z) * bounds.extent_z[i];
+
+            outside |= sphere_distance + bounds.radius[i] < 0 || box_distance + box_radius < 0;
+        }
+
+        int mask = outside ? 0 : 1;
+#endif
+
+        //the index of every lane is written, but only counted if it is visible (and not part of the padding), which
+        //compacts the visible instances without branching
+        int valid = std::min(last - i, lanes);
+        for(int lane = 0; lane < lanes; lane++)
+        {
+            out_visible[visible] = i + lane;
+            visible += (mask >> lane) & (lane < valid ? 1 : 0);
+        }
+    }
+
+    return visible;
+}
+
+int CullInstances(const Frustum& frustum, const InstanceBounds& bounds, std::vector<int>& out_visible)
+{
+    int chunk_count = (bounds.count + CULLING_CHUNK_SIZE - 1) / CULLING_CHUNK_SIZE;
+    size_t needed = chunk_count * CULLING_CHUNK_SIZE + BOUNDS_PADDING;
+    if(out_visible.size() < needed)
+        out_visible.resize(needed);
+
+    //each chunk writes the visible instances at the start of its own part of the list, and they are moved together
+    //once every chunk is done
+    static std::vector<int> chunk_visible;
+    chunk_visible.resize(chunk_count);
+
+    int* visible = out_visible.empty() ? NULL : &out_visible[0];
+    ParallelFor(chunk_count, [&](int chunk)
+    {
+        int first = chunk * CULLING_CHUNK_SIZE;
+        int last = std::min(first + CULLING_CHUNK_SIZE, bounds.count);
+        chunk_visible[chunk] = CullRange(frustum, bounds, first, last, visible + first);
+    });
+
+    int total = 0;
+    for(int chunk = 0; chunk < chunk_count; chunk++)
+    {
+        if(total != chunk * CULLING_CHUNK_SIZE)
+            memmove(visible + total, visible + chunk * CULLING_CHUNK_SIZE, chunk_visible[chunk] * sizeof(int));
+
+        total += chunk_visible[chunk];
+    }
+
+    return total;
+}
+
+const char* GetFrustumCullingSimd()
+{
+#if defined(COMP_371_A2_CULLING_AVX2)
+    return "AVX2";
+#elif defined(COMP_371_A2_CULLING_SSE)
+    return "SSE";
+#else
+    return "none";
+#endif
+}
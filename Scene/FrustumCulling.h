@@ -0,0 +1,81 @@
+#ifndef COMP_371_A2_FRUSTUMCULLING_H
+#define COMP_371_A2_FRUSTUMCULLING_H
+
+#include <vector>
+#include "../GLM/glm/glm.hpp"
+
+//this contains the definitions for finding which instances of an object are inside of the view frustum, so that only
+//those are drawn. The bounds of the instances (a sphere and a box around each of them) are kept as separate arrays
+//of floats (one per component), so that 8 instances can be tested at once with AVX2 (or 4 with SSE). The instances are
+//split in chunks that are culled on several threads (see ParallelFor.h), and the visible ones are gathered in a
+//single list.
+//
+//The instances are culled in the space of the object (before the model matrix is applied), which means that their
+//bounds only need to be computed when they are placed, and the frustum planes are extracted from
+//Projection * View * Model instead.
+
+/*
+ * These are the 6 planes of a frustum (left, right, bottom, top, near and far), each one as (normal, distance) with
+ * the normal pointing inside of the frustum and of unit length.
+ */
+struct Frustum
+{
+    glm::vec4 planes[6];
+};
+
+/*
+ * This holds the bounds of every instance. Each array is padded to a multiple of 8 entries so that the last
+ * instances can be loaded 8 at a time.
+ */
+struct InstanceBounds
+{
+    //the bounding spheres
+    std::vector<float> center_x;
+    std::vector<float> center_y;
+    std::vector<float> center_z;
+    std::vector<float> radius;
+
+    //the axis aligned bounding boxes, as their centers and half sizes
+    std::vector<float> box_x;
+    std::vector<float> box_y;
+    std::vector<float> box_z;
+    std::vector<float> extent_x;
+    std::vector<float> extent_y;
+    std::vector<float> extent_z;
+
+    int count;
+};
+
+/*
+ * This method extracts the planes of the frustum of the passed matrix (i.e. Projection * View * Model).
+ */
+void ExtractFrustumPlanes(const glm::mat4& matrix, Frustum& out_frustum);
+
+/*
+ * This method computes the bounds of each instance from its model matrix.
+ * @param matrices: The model matrix of each instance
+ * @param box_min: The corner of the bounding box of the object with the smallest coordinates
+ * @param box_max: The corner of the bounding box of the object with the largest coordinates
+ * @param radius: The radius of the bounding sphere of the object, around its origin
+ * @param out_bounds: This will hold the bounds. Passed by reference.
+ */
+void BuildInstanceBounds(const std::vector<glm::mat4>& matrices, const glm::vec3& box_min, const glm::vec3& box_max,
+                         float radius, InstanceBounds& out_bounds);
+
+/*
+ * This method finds the instances that are inside of the frustum (or that may be, since the bounds are bigger than
+ * the object). An instance is culled if either its sphere or its box is entirely outside of one of the planes. The
+ * work is split across the threads of ParallelFor.
+ * @param out_visible: The index of every visible instance is written at the start of this list, in order. It is only
+ * ever grown (so that it does not need to be cleared every frame), which means that it may hold more entries than
+ * there are visible instances. Passed by reference.
+ * @return The number of visible instances
+ */
+int CullInstances(const Frustum& frustum, const InstanceBounds& bounds, std::vector<int>& out_visible);
+
+/*
+ * This method returns the name of the instruction set the instances are tested with (i.e. "AVX2").
+ */
+const char* GetFrustumCullingSimd();
+
+#endif //COMP_371_A2_FRUSTUMCULLING_H
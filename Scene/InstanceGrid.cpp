@@ -0,0 +1,32 @@
+#include "InstanceGrid.h"
+#include <cmath>
+#include "Transform.h"
+
+void BuildInstanceGrid(int count, float radius, float spread, std::vector<glm::mat4>& out_matrices)
+{
+    out_matrices.resize(count);
+    if(count == 0)
+        return;
+
+    //the number of instances along each side of the grid, and the space each of them gets
+    int side = (int)std::ceil(std::cbrt((double)count) - 1e-9);
+    float extent = radius * spread;
+    float spacing = 2.0f * extent / side;
+    float first = -extent + spacing * 0.5f;
+
+    for(int i = 0; i < count; i++)
+    {
+        int x = i % side;
+        int y = (i / side) % side;
+        int z = i / (side * side);
+
+        //each instance is scaled down to fit in its cell (leaving a small gap), and turned by the golden angle times
+        //its index
+        Transform transform;
+        TranslateTransform(transform, glm::vec3(first + x * spacing, first + y * spacing, first + z * spacing));
+        RotateTransform(transform, 2.39996323f * i, glm::vec3(0, 1, 0));
+        ScaleTransform(transform, 0.9f * spread / side);
+
+        out_matrices[i] = GetTransformMatrix(transform);
+    }
+}
@@ -0,0 +1,24 @@
+#ifndef COMP_371_A2_INSTANCEGRID_H
+#define COMP_371_A2_INSTANCEGRID_H
+
+#include <vector>
+#include "../GLM/glm/glm.hpp"
+
+//this contains the definitions for laying out many copies of an object, to draw them as instances (see
+//InstanceBuffer.h).
+
+/*
+ * This method places the passed number of instances on a cubic grid centered on the origin. The grid is scaled so that
+ * it takes the same space as a number of copies of the object across, whatever the number of instances, and the
+ * instances are scaled with it so that the gaps between them stay small. With a spread of 1, anything that frames the
+ * object (i.e. the camera path of the benchmark) frames all of the instances, and with a larger spread the instances
+ * fill more of the scene (and hide each other). Each instance is also turned by its own angle so that they do not all
+ * look the same.
+ * @param count: The number of instances
+ * @param radius: The radius of the bounding sphere of the object
+ * @param spread: The number of copies of the object the grid spans across
+ * @param out_matrices: This will hold the model matrix of each instance. Passed by reference.
+ */
+void BuildInstanceGrid(int count, float radius, float spread, std::vector<glm::mat4>& out_matrices);
+
+#endif //COMP_371_A2_INSTANCEGRID_H
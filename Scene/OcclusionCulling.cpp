@@ -0,0 +1,540 @@
+#include "OcclusionCulling.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <cfloat>
+#include <utility>
+#include "../Threading/ParallelFor.h"
+#include "../Stats/Clock.h"
+
+//the occluders are rasterized 4 pixels at a time with SSE (which all x86-64 compilers target), and one pixel at a
+//time otherwise
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define COMP_371_A2_OCCLUSION_SSE
+#include <xmmintrin.h>
+#endif
+
+const int OCCLUSION_TILES_X = OCCLUSION_WIDTH / OCCLUSION_TILE_WIDTH;
+const int OCCLUSION_TILES_Y = OCCLUSION_HEIGHT / OCCLUSION_TILE_HEIGHT;
+
+//the number of instances handled by each task, when picking the occluders and when testing the instances
+const int OCCLUSION_CHUNK_SIZE = 4096;
+
+//the number of boxes projected at a time when testing the instances
+const int OCCLUSION_BOX_GROUP = 64;
+
+//the number of instances the depth the nearest ones are in front of is estimated from
+const int OCCLUSION_SAMPLE_SIZE = 4096;
+
+/*
+ * An occluder triangle once it has been projected, in pixels (x and y) and normalized device coordinates (z).
+ */
+struct ScreenTriangle
+{
+    float x[3];
+    float y[3];
+    float z[3];
+};
+
+//the depth of every pixel, and the farthest depth of every tile (both are cleared to the far plane)
+static float depth_buffer[OCCLUSION_WIDTH * OCCLUSION_HEIGHT];
+static float tile_depth[OCCLUSION_TILES_X * OCCLUSION_TILES_Y];
+
+//the candidates for being occluders (their depth and index), the projected triangles of the occluders, and how many
+//of the triangles of each occluder were kept (the others were behind the camera)
+static std::vector<float> samples;
+static std::vector<std::pair<float, int> > candidates;
+static std::vector<int> chunk_candidates;
+static std::vector<ScreenTriangle> screen_triangles;
+static std::vector<int> occluder_triangle_count;
+static std::vector<int> chunk_visible;
+
+/*
+ * This returns the depth of the center of the box of the passed instance, as the distance in front of the camera (or
+ * the largest float for an instance behind the camera).
+ */
+static float InstanceDepth(const glm::vec4& depth_row, const InstanceBounds& bounds, int instance)
+{
+    float depth = depth_row.x * bounds.box_x[instance] + depth_row.y * bounds.box_y[instance] +
+                  depth_row.z * bounds.box_z[instance] + depth_row.w;
+
+    return depth > 0 ? depth : FLT_MAX;
+}
+
+/*
+ * This projects the passed triangles of an occluder with the passed matrix, and keeps the ones that are entirely in
+ * front of the near plane.
+ * @return The number of triangles kept
+ */
+static int ProjectOccluder(const glm::mat4& matrix, const std::vector<glm::vec3>& triangles, ScreenTriangle* out)
+{
+    int kept = 0;
+    for(int t = 0; t + 2 < triangles.size(); t += 3)
+    {
+        ScreenTriangle& screen = out[kept];
+        bool in_front = true;
+        for(int v = 0; v < 3; v++)
+        {
+            glm::vec4 clip = matrix * glm::vec4(triangles[t + v], 1.0f);
+            in_front &= clip.w > 0 && clip.z > -clip.w;
+
+            screen.x[v] = (clip.x / clip.w * 0.5f + 0.5f) * OCCLUSION_WIDTH;
+            screen.y[v] = (clip.y / clip.w * 0.5f + 0.5f) * OCCLUSION_HEIGHT;
+            screen.z[v] = clip.z / clip.w;
+        }
+
+        //clipping the triangles against the near plane would only make the occluders a little bigger, so the ones
+        //that cross it are simply left out. The back faces are left out as well, since they are hidden behind the
+        //front faces of the occluder (leaving out a triangle never rejects an instance that is visible).
+        float area = (screen.x[1] - screen.x[0]) * (screen.y[2] - screen.y[0]) -
+                     (screen.x[2] - screen.x[0]) * (screen.y[1] - screen.y[0]);
+        kept += in_front && area > 0 ? 1 : 0;
+    }
+
+    return kept;
+}
+
+/*
+ * This draws the part of the passed triangle that is inside of the rows first_row to last_row (included) into the
+ * depth buffer, keeping the nearest depth of each pixel. A pixel is only covered if its center is strictly inside of
+ * the triangle, so that the occluders never cover more than they should.
+ */
+static void RasterizeTriangle(const ScreenTriangle& triangle, int first_row, int last_row)
+{
+    const float* x = triangle.x;
+    const float* y = triangle.y;
+    const float* z = triangle.z;
+
+    //the pixels whose centers are inside of the bounding box of the triangle (the coordinates are clamped first, since
+    //triangles near the camera can be huge)
+    float min_x = std::max(std::min(x[0], std::min(x[1], x[2])), -1.0f);
+    float max_x = std::min(std::max(x[0], std::max(x[1], x[2])), (float)OCCLUSION_WIDTH);
+    float min_y = std::max(std::min(y[0], std::min(y[1], y[2])), -1.0f);
+    float max_y = std::min(std::max(y[0], std::max(y[1], y[2])), (float)OCCLUSION_HEIGHT);
+    int first_x = std::max((int)std::ceil(min_x - 0.5f), 0);
+    int last_x = std::min((int)std::floor(max_x - 0.5f), OCCLUSION_WIDTH - 1);
+    int first_y = std::max((int)std::ceil(min_y - 0.5f), first_row);
+    int last_y = std::min((int)std::floor(max_y - 0.5f), last_row);
+    if(first_x > last_x || first_y > last_y)
+        return;
+
+    float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+    if(area < 1e-6f)
+        return;
+
+    //each edge function is a * x + b * y + c, which is positive inside of the triangle (the triangles are all front
+    //facing, so wound counter clockwise)
+    float edge_a[3], edge_b[3], edge_c[3];
+    for(int e = 0; e < 3; e++)
+    {
+        int from = (e + 1) % 3;
+        int to = (e + 2) % 3;
+        edge_a[e] = -(y[to] - y[from]);
+        edge_b[e] = x[to] - x[from];
+        edge_c[e] = (y[to] - y[from]) * x[from] - (x[to] - x[from]) * y[from];
+    }
+
+    //the depth is interpolated linearly across the screen
+    float depth_dx = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) / area;
+    float depth_dy = ((z[2] - z[0]) * (x[1] - x[0]) - (z[1] - z[0]) * (x[2] - x[0])) / area;
+    float depth_c = z[0] - depth_dx * x[0] - depth_dy * y[0];
+
+#if defined(COMP_371_A2_OCCLUSION_SSE)
+    //the pixels are handled in aligned groups of 4, and the ones of a group that are outside of the bounding box are
+    //outside of the triangle as well
+    first_x &= ~3;
+    __m128 a0 = _mm_set1_ps(edge_a[0]), a1 = _mm_set1_ps(edge_a[1]), a2 = _mm_set1_ps(edge_a[2]);
+    __m128 dx = _mm_set1_ps(depth_dx);
+    __m128 zero = _mm_setzero_ps();
+    __m128 four = _mm_set1_ps(4.0f);
+
+    for(int row = first_y; row <= last_y; row++)
+    {
+        float center_y = row + 0.5f;
+        __m128 row_e0 = _mm_set1_ps(edge_b[0] * center_y + edge_c[0]);
+        __m128 row_e1 = _mm_set1_ps(edge_b[1] * center_y + edge_c[1]);
+        __m128 row_e2 = _mm_set1_ps(edge_b[2] * center_y + edge_c[2]);
+        __m128 row_depth = _mm_set1_ps(depth_dy * center_y + depth_c);
+        __m128 center_x = _mm_add_ps(_mm_set1_ps(first_x + 0.5f), _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f));
+        float* depth = &depth_buffer[row * OCCLUSION_WIDTH];
+
+        for(int column = first_x; column <= last_x; column += 4, center_x = _mm_add_ps(center_x, four))
+        {
+            __m128 inside = _mm_and_ps(_mm_cmpgt_ps(_mm_add_ps(_mm_mul_ps(a0, center_x), row_e0), zero),
+                                       _mm_cmpgt_ps(_mm_add_ps(_mm_mul_ps(a1, center_x), row_e1), zero));
+            inside = _mm_and_ps(inside, _mm_cmpgt_ps(_mm_add_ps(_mm_mul_ps(a2, center_x), row_e2), zero));
+            if(_mm_movemask_ps(inside) == 0)
+                continue;
+
+            //the covered pixels keep the nearest of their depth and the one of the triangle
+            __m128 triangle_depth = _mm_add_ps(_mm_mul_ps(dx, center_x), row_depth);
+            __m128 old_depth = _mm_loadu_ps(depth + column);
+            __m128 new_depth = _mm_min_ps(old_depth, triangle_depth);
+            _mm_storeu_ps(depth + column, _mm_or_ps(_mm_and_ps(inside, new_depth), _mm_andnot_ps(inside, old_depth)));
+        }
+    }
+#else
+    for(int row = first_y; row <= last_y; row++)
+    {
+        float center_y = row + 0.5f;
+        float* depth = &depth_buffer[row * OCCLUSION_WIDTH];
+
+        for(int column = first_x; column <= last_x; column++)
+        {
+            float center_x = column + 0.5f;
+            bool inside = true;
+            for(int e = 0; e < 3; e++)
+                inside &= edge_a[e] * center_x + edge_b[e] * center_y + edge_c[e] > 0;
+
+            if(inside)
+                depth[column] = std::min(depth[column], depth_dx * center_x + depth_dy * center_y + depth_c);
+        }
+    }
+#endif
+}
+
+/*
+ * This keeps the farthest depth of each tile of the passed row of tiles.
+ */
+static void UpdateTileDepth(int tile_row)
+{
+    for(int tile = 0; tile < OCCLUSION_TILES_X; tile++)
+    {
+        int first_column = tile * OCCLUSION_TILE_WIDTH;
+        float farthest = -1.0f;
+
+        for(int row = tile_row * OCCLUSION_TILE_HEIGHT; row < (tile_row + 1) * OCCLUSION_TILE_HEIGHT; row++)
+            for(int column = first_column; column < first_column + OCCLUSION_TILE_WIDTH; column++)
+                farthest = std::max(farthest, depth_buffer[row * OCCLUSION_WIDTH + column]);
+
+        tile_depth[tile_row * OCCLUSION_TILES_X + tile] = farthest;
+    }
+}
+
+/*
+ * The part of the depth buffer covered by the box of an instance, in pixels, and the nearest depth of the box.
+ */
+struct ScreenBox
+{
+    float min_x;
+    float min_y;
+    float max_x;
+    float max_y;
+    float nearest;
+    bool crosses_near_plane; //a box that crosses the near plane cannot be projected
+};
+
+/*
+ * This projects the boxes of the passed instances (4 at a time with SSE), keeping the smallest rectangle that holds
+ * their corners.
+ */
+static void ProjectBoxes(const glm::mat4& matrix, const InstanceBounds& bounds, const int* instances, int count,
+                         ScreenBox* out)
+{
+#if defined(COMP_371_A2_OCCLUSION_SSE)
+    const int lanes = 4;
+    __m128 half = _mm_set1_ps(0.5f);
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 zero = _mm_setzero_ps();
+
+    for(int i = 0; i < count; i += lanes)
+    {
+        //the last group repeats its last instance in the lanes that are left over
+        int instance[lanes];
+        for(int lane = 0; lane < lanes; lane++)
+            instance[lane] = instances[std::min(i + lane, count - 1)];
+
+        __m128 box[3], extent[3];
+        const std::vector<float>* box_components[3] = {&bounds.box_x, &bounds.box_y, &bounds.box_z};
+        const std::vector<float>* extent_components[3] = {&bounds.extent_x, &bounds.extent_y, &bounds.extent_z};
+        for(int axis = 0; axis < 3; axis++)
+        {
+            const std::vector<float>& b = *box_components[axis];
+            const std::vector<float>& e = *extent_components[axis];
+            box[axis] = _mm_setr_ps(b[instance[0]], b[instance[1]], b[instance[2]], b[instance[3]]);
+            extent[axis] = _mm_setr_ps(e[instance[0]], e[instance[1]], e[instance[2]], e[instance[3]]);
+        }
+
+        //the corners of the box are its center plus or minus each of its half sizes along the axes, in clip space
+        __m128 center[4], axis_offset[3][4];
+        for(int row = 0; row < 4; row++)
+        {
+            center[row] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(matrix[0][row]), box[0]),
+                                                _mm_mul_ps(_mm_set1_ps(matrix[1][row]), box[1])),
+                                     _mm_add_ps(_mm_mul_ps(_mm_set1_ps(matrix[2][row]), box[2]),
+                                                _mm_set1_ps(matrix[3][row])));
+            for(int axis = 0; axis < 3; axis++)
+                axis_offset[axis][row] = _mm_mul_ps(_mm_set1_ps(matrix[axis][row]), extent[axis]);
+        }
+
+        __m128 min_x = _mm_set1_ps(FLT_MAX), min_y = min_x, nearest = min_x;
+        __m128 max_x = _mm_set1_ps(-FLT_MAX), max_y = max_x;
+        __m128 crosses = zero;
+        __m128 corners[8][4];
+        for(int row = 0; row < 4; row++)
+        {
+            __m128 along_x[2] = {_mm_sub_ps(center[row], axis_offset[0][row]),
+                                 _mm_add_ps(center[row], axis_offset[0][row])};
+            for(int i = 0; i < 2; i++)
+            {
+                __m128 along_y[2] = {_mm_sub_ps(along_x[i], axis_offset[1][row]),
+                                     _mm_add_ps(along_x[i], axis_offset[1][row])};
+                for(int j = 0; j < 2; j++)
+                {
+                    corners[i + 2 * j][row] = _mm_sub_ps(along_y[j], axis_offset[2][row]);
+                    corners[i + 2 * j + 4][row] = _mm_add_ps(along_y[j], axis_offset[2][row]);
+                }
+            }
+        }
+
+        for(int corner = 0; corner < 8; corner++)
+        {
+            const __m128* clip = corners[corner];
+            crosses = _mm_or_ps(crosses, _mm_or_ps(_mm_cmple_ps(clip[3], zero),
+                                                   _mm_cmplt_ps(clip[2], _mm_sub_ps(zero, clip[3]))));
+            __m128 inverse_w = _mm_div_ps(one, clip[3]);
+            __m128 x = _mm_mul_ps(clip[0], inverse_w);
+            __m128 y = _mm_mul_ps(clip[1], inverse_w);
+            min_x = _mm_min_ps(min_x, x);
+            max_x = _mm_max_ps(max_x, x);
+            min_y = _mm_min_ps(min_y, y);
+            max_y = _mm_max_ps(max_y, y);
+            nearest = _mm_min_ps(nearest, _mm_mul_ps(clip[2], inverse_w));
+        }
+
+        //the rectangle is converted from normalized device coordinates to pixels
+        __m128 width = _mm_set1_ps((float)OCCLUSION_WIDTH);
+        __m128 height = _mm_set1_ps((float)OCCLUSION_HEIGHT);
+        float rectangle[4][lanes], depth[lanes];
+        _mm_storeu_ps(rectangle[0], _mm_mul_ps(_mm_add_ps(_mm_mul_ps(min_x, half), half), width));
+        _mm_storeu_ps(rectangle[1], _mm_mul_ps(_mm_add_ps(_mm_mul_ps(min_y, half), half), height));
+        _mm_storeu_ps(rectangle[2], _mm_mul_ps(_mm_add_ps(_mm_mul_ps(max_x, half), half), width));
+        _mm_storeu_ps(rectangle[3], _mm_mul_ps(_mm_add_ps(_mm_mul_ps(max_y, half), half), height));
+        _mm_storeu_ps(depth, nearest);
+        int crosses_mask = _mm_movemask_ps(crosses);
+
+        for(int lane = 0; lane < lanes && i + lane < count; lane++)
+        {
+            ScreenBox& screen = out[i + lane];
+            screen.min_x = rectangle[0][lane];
+            screen.min_y = rectangle[1][lane];
+            screen.max_x = rectangle[2][lane];
+            screen.max_y = rectangle[3][lane];
+            screen.nearest = depth[lane];
+            screen.crosses_near_plane = (crosses_mask >> lane) & 1;
+        }
+    }
+#else
+    for(int i = 0; i < count; i++)
+    {
+        int instance = instances[i];
+        glm::vec4 center = matrix * glm::vec4(bounds.box_x[instance], bounds.box_y[instance], bounds.box_z[instance],
+                                              1.0f);
+        glm::vec4 axis_x = matrix[0] * bounds.extent_x[instance];
+        glm::vec4 axis_y = matrix[1] * bounds.extent_y[instance];
+        glm::vec4 axis_z = matrix[2] * bounds.extent_z[instance];
+
+        ScreenBox& screen = out[i];
+        screen.min_x = screen.min_y = screen.nearest = FLT_MAX;
+        screen.max_x = screen.max_y = -FLT_MAX;
+        screen.crosses_near_plane = false;
+        for(int corner = 0; corner < 8; corner++)
+        {
+            glm::vec4 clip = center + ((corner & 1) ? axis_x : -axis_x) + ((corner & 2) ? axis_y : -axis_y) +
+                             ((corner & 4) ? axis_z : -axis_z);
+            screen.crosses_near_plane |= clip.w <= 0 || clip.z < -clip.w;
+
+            float x = (clip.x / clip.w * 0.5f + 0.5f) * OCCLUSION_WIDTH;
+            float y = (clip.y / clip.w * 0.5f + 0.5f) * OCCLUSION_HEIGHT;
+            screen.min_x = std::min(screen.min_x, x);
+            screen.max_x = std::max(screen.max_x, x);
+            screen.min_y = std::min(screen.min_y, y);
+            screen.max_y = std::max(screen.max_y, y);
+            screen.nearest = std::min(screen.nearest, clip.z / clip.w);
+        }
+    }
+#endif
+}
+
+/*
+ * This tests the passed projected box against the farthest depth of the tiles it covers.
+ * @return A boolean specifying if the box is hidden behind the occluders or not.
+ */
+static bool IsOccluded(const ScreenBox& box)
+{
+    //a box that crosses the near plane is right in front of the camera anyway
+    if(box.crosses_near_plane)
+        return false;
+
+    int first_tile_x = (int)std::max(box.min_x, 0.0f) / OCCLUSION_TILE_WIDTH;
+    int last_tile_x = (int)std::min(box.max_x, OCCLUSION_WIDTH - 1.0f) / OCCLUSION_TILE_WIDTH;
+    int first_tile_y = (int)std::max(box.min_y, 0.0f) / OCCLUSION_TILE_HEIGHT;
+    int last_tile_y = (int)std::min(box.max_y, OCCLUSION_HEIGHT - 1.0f) / OCCLUSION_TILE_HEIGHT;
+
+    for(int tile_y = first_tile_y; tile_y <= last_tile_y; tile_y++)
+        for(int tile_x = first_tile_x; tile_x <= last_tile_x; tile_x++)
+            if(tile_depth[tile_y * OCCLUSION_TILES_X + tile_x] >= box.nearest)
+                return false;
+
+    return true;
+}
+
+int OcclusionCullInstances(const glm::mat4& matrix, const std::vector<glm::vec3>& occluder_triangles,
+                           const std::vector<glm::mat4>& instance_matrices, const InstanceBounds& bounds,
+                           double budget_ms, std::vector<int>& visible, int visible_count, OcclusionStats& out_stats)
+{
+    //drawing the occluders may take half of the budget, so that there is always time left to test the instances
+    double start_time = GetTime();
+    double draw_deadline = start_time + budget_ms / 2000.0;
+    double deadline = start_time + budget_ms / 1000.0;
+    std::atomic<bool> over_budget(false);
+    int* indices = visible.empty() ? NULL : &visible[0];
+    int chunk_count = (visible_count + OCCLUSION_CHUNK_SIZE - 1) / OCCLUSION_CHUNK_SIZE;
+
+    //fewer occluders are drawn when the mesh is detailed, so that the triangles drawn per frame stay about the same
+    int triangle_count = occluder_triangles.size() / 3;
+    int max_occluders = std::min(OCCLUSION_MAX_OCCLUDERS, std::max(OCCLUSION_MAX_TRIANGLES / std::max(triangle_count, 1),
+                                                                   1));
+
+    //the occluders are the nearest of the instances (the ones behind the camera being the farthest). Sorting all of
+    //them would take too long, so the depth that about twice as many instances as needed are in front of is estimated
+    //from an even sample of them first, and only the ones in front of that are sorted.
+    glm::vec4 depth_row(matrix[0][3], matrix[1][3], matrix[2][3], matrix[3][3]);
+    int stride = std::max(visible_count / OCCLUSION_SAMPLE_SIZE, 1);
+    samples.clear();
+    for(int n = 0; n < visible_count; n += stride)
+        samples.push_back(InstanceDepth(depth_row, bounds, indices[n]));
+
+    float cutoff = FLT_MAX;
+    int rank = (int)((long long)2 * max_occluders * samples.size() / std::max(visible_count, 1));
+    if(rank < samples.size())
+    {
+        std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+        cutoff = samples[rank];
+    }
+
+    candidates.resize(chunk_count * OCCLUSION_CHUNK_SIZE);
+    chunk_candidates.resize(chunk_count);
+    ParallelFor(chunk_count, [&](int chunk)
+    {
+        int first = chunk * OCCLUSION_CHUNK_SIZE;
+        int last = std::min(first + OCCLUSION_CHUNK_SIZE, visible_count);
+        int kept = 0;
+        for(int n = first; n < last; n++)
+        {
+            float depth = InstanceDepth(depth_row, bounds, indices[n]);
+            candidates[first + kept] = std::make_pair(depth, indices[n]);
+            kept += depth <= cutoff ? 1 : 0;
+        }
+
+        chunk_candidates[chunk] = kept;
+    });
+
+    int candidate_count = 0;
+    for(int chunk = 0; chunk < chunk_count; chunk++)
+    {
+        std::copy(candidates.begin() + chunk * OCCLUSION_CHUNK_SIZE,
+                  candidates.begin() + chunk * OCCLUSION_CHUNK_SIZE + chunk_candidates[chunk],
+                  candidates.begin() + candidate_count);
+        candidate_count += chunk_candidates[chunk];
+    }
+
+    int occluder_count = std::min(max_occluders, candidate_count);
+    std::nth_element(candidates.begin(), candidates.begin() + occluder_count, candidates.begin() + candidate_count);
+    std::sort(candidates.begin(), candidates.begin() + occluder_count);
+
+    //the occluders are projected nearest first, until the budget runs out
+    screen_triangles.resize(std::max(occluder_count * triangle_count, 1));
+    occluder_triangle_count.assign(occluder_count, 0);
+    ParallelFor(occluder_count, [&](int occluder)
+    {
+        if(GetTime() > draw_deadline)
+        {
+            over_budget = true;
+            return;
+        }
+
+        occluder_triangle_count[occluder] = ProjectOccluder(matrix * instance_matrices[candidates[occluder].second],
+                                                            occluder_triangles,
+                                                            &screen_triangles[occluder * triangle_count]);
+    });
+
+    //each band of rows is cleared and drawn on its own, and stops drawing occluders once the budget runs out
+    ParallelFor(OCCLUSION_TILES_Y, [&](int band)
+    {
+        int first_row = band * OCCLUSION_TILE_HEIGHT;
+        int last_row = first_row + OCCLUSION_TILE_HEIGHT - 1;
+        std::fill(depth_buffer + first_row * OCCLUSION_WIDTH, depth_buffer + (last_row + 1) * OCCLUSION_WIDTH, 1.0f);
+
+        for(int occluder = 0; occluder < occluder_count; occluder++)
+        {
+            if(GetTime() > draw_deadline)
+            {
+                over_budget = true;
+                break;
+            }
+
+            const ScreenTriangle* triangles = &screen_triangles[occluder * triangle_count];
+            for(int t = 0; t < occluder_triangle_count[occluder]; t++)
+                RasterizeTriangle(triangles[t], first_row, last_row);
+        }
+
+        UpdateTileDepth(band);
+    });
+
+    //every instance is then tested, except for the chunks that start after the budget ran out, which are kept
+    chunk_visible.resize(chunk_count);
+    ParallelFor(chunk_count, [&](int chunk)
+    {
+        int first = chunk * OCCLUSION_CHUNK_SIZE;
+        int last = std::min(first + OCCLUSION_CHUNK_SIZE, visible_count);
+        if(GetTime() > deadline)
+        {
+            over_budget = true;
+            chunk_visible[chunk] = last - first;
+            return;
+        }
+
+        //the boxes are projected a group at a time, and the instances that are kept are moved to the start of the
+        //chunk, which never overwrites one not yet tested
+        int kept = 0;
+        ScreenBox boxes[OCCLUSION_BOX_GROUP];
+        for(int group = first; group < last; group += OCCLUSION_BOX_GROUP)
+        {
+            int group_size = std::min(OCCLUSION_BOX_GROUP, last - group);
+            ProjectBoxes(matrix, bounds, indices + group, group_size, boxes);
+
+            for(int n = 0; n < group_size; n++)
+            {
+                indices[first + kept] = indices[group + n];
+                kept += IsOccluded(boxes[n]) ? 0 : 1;
+            }
+        }
+
+        chunk_visible[chunk] = kept;
+    });
+
+    int total = 0;
+    for(int chunk = 0; chunk < chunk_count; chunk++)
+    {
+        if(total != chunk * OCCLUSION_CHUNK_SIZE)
+            memmove(indices + total, indices + chunk * OCCLUSION_CHUNK_SIZE, chunk_visible[chunk] * sizeof(int));
+
+        total += chunk_visible[chunk];
+    }
+
+    out_stats.occluders = 0;
+    out_stats.triangles = 0;
+    for(int occluder = 0; occluder < occluder_count; occluder++)
+    {
+        out_stats.occluders += occluder_triangle_count[occluder] > 0 ? 1 : 0;
+        out_stats.triangles += occluder_triangle_count[occluder];
+    }
+
+    out_stats.tested = visible_count;
+    out_stats.occluded = visible_count - total;
+    out_stats.over_budget = over_budget;
+
+    return total;
+}
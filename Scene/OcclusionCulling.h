@@ -0,0 +1,61 @@
+#ifndef COMP_371_A2_OCCLUSIONCULLING_H
+#define COMP_371_A2_OCCLUSIONCULLING_H
+
+#include <vector>
+#include "../GLM/glm/glm.hpp"
+#include "FrustumCulling.h"
+
+//this contains the definitions for finding which of the instances that are inside of the view frustum are hidden
+//behind others, so that they are not drawn either. The nearest instances are drawn as occluders into a small depth
+//buffer on the CPU, and the boxes of every instance are then tested against the farthest depth of each tile of that
+//buffer. An instance is only rejected if its box is behind the occluders in every tile it covers.
+//
+//The depth buffer is split in bands of one row of tiles, and each band is rasterized by its own task (see
+//ParallelFor.h), 4 pixels at a time with SSE. All of this runs within a budget of time per frame: the occluders are
+//drawn nearest first for up to half of it, and once it runs out the remaining instances are kept, which only means
+//that fewer instances are rejected. Like any depth buffer, this one is only sampled at the center of its pixels, so an
+//instance that is only seen through a gap narrower than one of its pixels may be rejected.
+
+//the size of the depth buffer, in pixels. It covers the whole viewport, whatever its aspect ratio.
+const int OCCLUSION_WIDTH = 256;
+const int OCCLUSION_HEIGHT = 128;
+
+//the size of the tiles the farthest depth is kept for
+const int OCCLUSION_TILE_WIDTH = 8;
+const int OCCLUSION_TILE_HEIGHT = 8;
+
+//the most occluders drawn per frame, and the most occluder triangles (fewer occluders are drawn for a detailed mesh)
+const int OCCLUSION_MAX_OCCLUDERS = 256;
+const int OCCLUSION_MAX_TRIANGLES = 1 << 16;
+
+/*
+ * This holds what the occlusion culling did during a frame.
+ */
+struct OcclusionStats
+{
+    int occluders; //the number of occluders drawn into the depth buffer
+    long long triangles; //the number of occluder triangles drawn
+    int tested; //the number of instances tested against the depth buffer
+    int occluded; //the number of instances that were rejected
+    bool over_budget; //whether some of the work was skipped to stay within the budget
+};
+
+/*
+ * This method rejects the instances that are hidden behind the nearest ones.
+ * @param matrix: The matrix that takes the object to clip space (Projection * View * Model)
+ * @param occluder_triangles: The triangles (3 vertices each) of the mesh the occluders are drawn with. It must not be
+ * bigger than the object, or instances that are visible could be rejected (the object itself is always safe).
+ * @param instance_matrices: The model matrix of each instance
+ * @param bounds: The bounds of each instance (see FrustumCulling.h)
+ * @param budget_ms: The time the occlusion culling may take, in milliseconds
+ * @param visible: The indices of the instances to test, in order, as found by CullInstances. The instances that are
+ * not rejected are moved to the start of the list. Passed by reference.
+ * @param visible_count: The number of instances to test
+ * @param out_stats: This will hold what was done. Passed by reference.
+ * @return The number of instances that were not rejected
+ */
+int OcclusionCullInstances(const glm::mat4& matrix, const std::vector<glm::vec3>& occluder_triangles,
+                           const std::vector<glm::mat4>& instance_matrices, const InstanceBounds& bounds,
+                           double budget_ms, std::vector<int>& visible, int visible_count, OcclusionStats& out_stats);
+
+#endif //COMP_371_A2_OCCLUSIONCULLING_H
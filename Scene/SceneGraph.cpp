@@ -0,0 +1,180 @@
+#include "SceneGraph.h"
+#include <algorithm>
+
+//the world matrices are multiplied with SSE when the compiler targets it (which all x86-64 compilers do)
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define COMP_371_A2_SCENE_SSE
+#include <xmmintrin.h>
+#endif
+
+SceneGraph::SceneGraph()
+{
+    sorted = true;
+}
+
+/*
+ * This computes out = a * b for column major matrices. With SSE, each column of the result is the sum of the columns
+ * of a, each multiplied by one element of the matching column of b.
+ */
+static inline void MultiplyMatrices(const glm::mat4& a, const glm::mat4& b, glm::mat4& out)
+{
+#ifdef COMP_371_A2_SCENE_SSE
+    const float* pa = &a[0][0];
+    const float* pb = &b[0][0];
+    float* po = &out[0][0];
+
+    __m128 a0 = _mm_loadu_ps(pa);
+    __m128 a1 = _mm_loadu_ps(pa + 4);
+    __m128 a2 = _mm_loadu_ps(pa + 8);
+    __m128 a3 = _mm_loadu_ps(pa + 12);
+
+    for(int column = 0; column < 4; column++)
+    {
+        const float* b_column = pb + 4 * column;
+        __m128 result = _mm_mul_ps(a0, _mm_set1_ps(b_column[0]));
+        result = _mm_add_ps(result, _mm_mul_ps(a1, _mm_set1_ps(b_column[1])));
+        result = _mm_add_ps(result, _mm_mul_ps(a2, _mm_set1_ps(b_column[2])));
+        result = _mm_add_ps(result, _mm_mul_ps(a3, _mm_set1_ps(b_column[3])));
+        _mm_storeu_ps(po + 4 * column, result);
+    }
+#else
+    out = a * b;
+#endif
+}
+
+int AddSceneNode(SceneGraph& graph, int parent, const glm::mat4& local)
+{
+    int node = graph.nodes.size();
+    int slot = node;
+
+    //the new node goes at the end for now, and the slots are put back in depth order by the next update
+    graph.parents.push_back(parent >= 0 ? graph.slots[parent] : -1);
+    graph.depths.push_back(parent >= 0 ? graph.depths[graph.slots[parent]] + 1 : 0);
+    graph.locals.push_back(local);
+    graph.worlds.push_back(local);
+    graph.dirty.push_back(1);
+    graph.nodes.push_back(node);
+    graph.slots.push_back(slot);
+
+    //a node added to the deepest level keeps the slots in depth order
+    if(slot > 0 && graph.depths[slot] < graph.depths[slot - 1])
+        graph.sorted = false;
+
+    return node;
+}
+
+void SetNodeLocal(SceneGraph& graph, int node, const glm::mat4& local)
+{
+    int slot = graph.slots[node];
+    graph.locals[slot] = local;
+    graph.dirty[slot] = 1;
+}
+
+const glm::mat4& GetNodeWorld(const SceneGraph& graph, int node)
+{
+    return graph.worlds[graph.slots[node]];
+}
+
+/*
+ * This puts the slots back in depth order (keeping the order of the nodes within each depth), with a counting sort.
+ */
+static void SortSceneGraph(SceneGraph& graph)
+{
+    int count = graph.nodes.size();
+    int max_depth = *std::max_element(graph.depths.begin(), graph.depths.end());
+
+    //the first new slot for each depth
+    std::vector<int> depth_starts(max_depth + 2, 0);
+    for(int i = 0; i < count; i++)
+        depth_starts[graph.depths[i] + 1]++;
+
+    for(int depth = 1; depth <= max_depth + 1; depth++)
+        depth_starts[depth] += depth_starts[depth - 1];
+
+    std::vector<int> new_slots(count);
+    for(int i = 0; i < count; i++)
+        new_slots[i] = depth_starts[graph.depths[i]]++;
+
+    //now every field is moved to its new slot (and the parents are changed to refer to the new slots)
+    SceneGraph sorted;
+    sorted.parents.resize(count);
+    sorted.depths.resize(count);
+    sorted.locals.resize(count);
+    sorted.worlds.resize(count);
+    sorted.dirty.resize(count);
+    sorted.nodes.resize(count);
+    sorted.slots.resize(count);
+
+    for(int i = 0; i < count; i++)
+    {
+        int slot = new_slots[i];
+        sorted.parents[slot] = graph.parents[i] >= 0 ? new_slots[graph.parents[i]] : -1;
+        sorted.depths[slot] = graph.depths[i];
+        sorted.locals[slot] = graph.locals[i];
+        sorted.worlds[slot] = graph.worlds[i];
+        sorted.dirty[slot] = graph.dirty[i];
+        sorted.nodes[slot] = graph.nodes[i];
+        sorted.slots[graph.nodes[i]] = slot;
+    }
+
+    graph.parents.swap(sorted.parents);
+    graph.depths.swap(sorted.depths);
+    graph.locals.swap(sorted.locals);
+    graph.worlds.swap(sorted.worlds);
+    graph.dirty.swap(sorted.dirty);
+    graph.nodes.swap(sorted.nodes);
+    graph.slots.swap(sorted.slots);
+    graph.sorted = true;
+}
+
+int UpdateSceneGraph(SceneGraph& graph)
+{
+    if(!graph.sorted)
+        SortSceneGraph(graph);
+
+    int count = graph.nodes.size();
+    const int* parents = graph.parents.data();
+    unsigned char* dirty = graph.dirty.data();
+
+    //first we find every node that needs to be recomputed. Since the parents come first, a node whose parent is dirty
+    //can be marked as dirty as we go, which carries the dirty flags all the way down the subtrees.
+    graph.updated.clear();
+    for(int i = 0; i < count; i++)
+    {
+        if(parents[i] >= 0)
+            dirty[i] |= dirty[parents[i]];
+
+        if(dirty[i])
+            graph.updated.push_back(i);
+    }
+
+    //then the world matrices of those nodes are computed in one batch, again in depth order so that the world matrix
+    //of each parent is ready before its children need it
+    const glm::mat4* locals = graph.locals.data();
+    glm::mat4* worlds = graph.worlds.data();
+    const int* updated = graph.updated.data();
+    int updated_count = graph.updated.size();
+
+    for(int i = 0; i < updated_count; i++)
+    {
+        int slot = updated[i];
+        if(parents[slot] >= 0)
+            MultiplyMatrices(worlds[parents[slot]], locals[slot], worlds[slot]);
+
+        else
+            worlds[slot] = locals[slot];
+
+        dirty[slot] = 0;
+    }
+
+    return updated_count;
+}
+
+const char* GetSceneGraphSimd()
+{
+#ifdef COMP_371_A2_SCENE_SSE
+    return "SSE";
+#else
+    return "none";
+#endif
+}
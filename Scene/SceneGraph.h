@@ -0,0 +1,67 @@
+#ifndef COMP_371_A2_SCENEGRAPH_H
+#define COMP_371_A2_SCENEGRAPH_H
+
+#include <vector>
+#include "../GLM/glm/glm.hpp"
+
+//this contains the definitions for a scene graph, which lets an object be made of parts that move with their parent
+//(i.e. an arm that moves with the body it is attached to). Each node has a local matrix (relative to its parent) and a
+//world matrix (the product of the local matrices from the root down to the node).
+//
+//The nodes are kept in flat arrays (one per field) that are ordered by depth, so every node comes after its parent and
+//the world matrices can all be updated in a single pass. Changing the local matrix of a node only marks it as dirty,
+//and the next update recomputes the world matrices of the dirty nodes and of everything below them, and nothing else.
+
+/*
+ * This is the scene graph. The nodes are referred to by the handle returned by AddSceneNode, which stays the same when
+ * the nodes are reordered. Everything else is indexed by the slot of the node in the depth order.
+ */
+struct SceneGraph
+{
+    std::vector<int> parents; //the slot of the parent of each node (-1 for the roots)
+    std::vector<int> depths; //the depth of each node (0 for the roots)
+    std::vector<glm::mat4> locals;
+    std::vector<glm::mat4> worlds;
+    std::vector<unsigned char> dirty;
+    std::vector<int> nodes; //the handle of the node in each slot
+
+    std::vector<int> slots; //the slot of each node, indexed by its handle
+    bool sorted; //false when nodes were added since the slots were last ordered by depth
+
+    std::vector<int> updated; //the slots that were recomputed by the last update, in order
+
+    SceneGraph();
+};
+
+/*
+ * This method adds a node to the scene graph.
+ * @param graph: The graph to add the node to. Passed by reference.
+ * @param parent: The handle of the parent node, or -1 to add a root
+ * @param local: The matrix of the node, relative to its parent
+ * @return The handle of the new node
+ */
+int AddSceneNode(SceneGraph& graph, int parent, const glm::mat4& local);
+
+/*
+ * This method changes the local matrix of a node, and marks it as dirty so that its world matrix (and the ones of every
+ * node below it) are recomputed by the next update.
+ */
+void SetNodeLocal(SceneGraph& graph, int node, const glm::mat4& local);
+
+/*
+ * This method returns the world matrix of a node, as of the last update.
+ */
+const glm::mat4& GetNodeWorld(const SceneGraph& graph, int node);
+
+/*
+ * This method recomputes the world matrices of the dirty nodes and of all the nodes below them.
+ * @return The number of nodes that were recomputed
+ */
+int UpdateSceneGraph(SceneGraph& graph);
+
+/*
+ * This method returns the name of the instruction set used to multiply the matrices (i.e. "SSE").
+ */
+const char* GetSceneGraphSimd();
+
+#endif //COMP_371_A2_SCENEGRAPH_H
@@ -0,0 +1,57 @@
+#include "Transform.h"
+
+Transform::Transform()
+{
+    position = glm::vec3(0.0f);
+    orientation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+    scale = 1.0f;
+
+    matrix = glm::mat4(1.0f);
+    dirty = false;
+}
+
+void TranslateTransform(Transform& transform, const glm::vec3& offset)
+{
+    //the offset is rotated and scaled by the transform before being added to its position
+    transform.position += transform.orientation * (offset * transform.scale);
+    transform.dirty = true;
+}
+
+void RotateTransform(Transform& transform, float angle, const glm::vec3& axis)
+{
+    //the orientation is normalized each time so that rounding errors can not build up in it
+    transform.orientation = glm::normalize(transform.orientation * glm::angleAxis(angle, axis));
+    transform.dirty = true;
+}
+
+void ScaleTransform(Transform& transform, float factor)
+{
+    //since the scale is uniform, it does not matter whether it is applied before or after the rotation
+    transform.scale *= factor;
+    transform.dirty = true;
+}
+
+void SetTransformMatrix(Transform& transform, const glm::mat4& matrix)
+{
+    transform.scale = glm::length(glm::vec3(matrix[0]));
+    transform.orientation = glm::normalize(glm::quat_cast(glm::mat3(matrix) / transform.scale));
+    transform.position = glm::vec3(matrix[3]);
+    transform.dirty = true;
+}
+
+const glm::mat4& GetTransformMatrix(Transform& transform)
+{
+    if(transform.dirty)
+    {
+        //the rotation matrix has its first three columns scaled, and the position goes in the last one
+        glm::mat3 rotation = glm::mat3_cast(transform.orientation);
+
+        transform.matrix[0] = glm::vec4(rotation[0] * transform.scale, 0.0f);
+        transform.matrix[1] = glm::vec4(rotation[1] * transform.scale, 0.0f);
+        transform.matrix[2] = glm::vec4(rotation[2] * transform.scale, 0.0f);
+        transform.matrix[3] = glm::vec4(transform.position, 1.0f);
+        transform.dirty = false;
+    }
+
+    return transform.matrix;
+}
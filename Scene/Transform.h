@@ -0,0 +1,59 @@
+#ifndef COMP_371_A2_TRANSFORM_H
+#define COMP_371_A2_TRANSFORM_H
+
+#include "../GLM/glm/glm.hpp"
+#include "../GLM/glm/gtc/quaternion.hpp"
+
+//this contains the definitions for transforms stored as a position, an orientation and a uniform scale rather than
+//as a matrix. Moving, rotating or scaling a transform only changes those (so it never drifts, no matter how many
+//times it is done), and the matrix is only rebuilt when it is asked for after something changed.
+
+/*
+ * This is a transform made of a uniform scale, followed by a rotation, followed by a translation.
+ */
+struct Transform
+{
+    glm::vec3 position;
+    glm::quat orientation;
+    float scale;
+
+    //the matrix for the transform, which is only valid if it is not dirty
+    glm::mat4 matrix;
+    bool dirty;
+
+    Transform();
+};
+
+/*
+ * This method translates the transform by the passed offset, which is given in the space of the transform (it is the
+ * same as multiplying the matrix of the transform on the right by a translation matrix).
+ */
+void TranslateTransform(Transform& transform, const glm::vec3& offset);
+
+/*
+ * This method rotates the transform about the passed axis, which is given in the space of the transform (it is the
+ * same as multiplying the matrix of the transform on the right by a rotation matrix).
+ * @param angle: The angle to rotate by, in radians
+ * @param axis: The axis to rotate about (it must be of unit length)
+ */
+void RotateTransform(Transform& transform, float angle, const glm::vec3& axis);
+
+/*
+ * This method scales the transform uniformly by the passed factor (it is the same as multiplying the matrix of the
+ * transform on the right by a scaling matrix).
+ */
+void ScaleTransform(Transform& transform, float factor);
+
+/*
+ * This method sets the transform from a matrix that is made of a uniform scale, a rotation and a translation (i.e. the
+ * matrix returned by glm::lookAt).
+ */
+void SetTransformMatrix(Transform& transform, const glm::mat4& matrix);
+
+/*
+ * This method returns the matrix for the transform, rebuilding it first if the transform changed since it was last
+ * built.
+ */
+const glm::mat4& GetTransformMatrix(Transform& transform);
+
+#endif //COMP_371_A2_TRANSFORM_H
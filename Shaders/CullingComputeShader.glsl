@@ -0,0 +1,170 @@
+#version 430 core
+
+//this culls the instances on the GPU, one invocation per instance (see GpuCulling.h). The matrices of the instances
+//that are kept are appended to the instance buffer, and counted in one of the two draws.
+//
+//With FIRST_PASS, the instances outside of the view frustum are dropped, the ones that were hidden in the depth pyramid
+//of the last frame are marked to be tested again, and the others are added to the first draw. With SECOND_PASS, the
+//marked instances are tested against the depth pyramid of the first draw, and the ones that are visible after all are
+//added to the second draw, after those of the first. With BUILD_COMMANDS, one invocation per mesh of the pool (see
+//MeshPool.h) writes the indirect command that draws that mesh for the instances of one of the draws.
+
+layout(local_size_x = 64) in;
+
+//the bounding box of each instance, in the space of the object
+struct InstanceBox
+{
+    vec4 center;
+    vec4 extent;
+};
+
+layout(std430, binding = 0) readonly buffer Boxes { InstanceBox boxes[]; };
+layout(std430, binding = 1) readonly buffer Matrices { mat4 matrices[]; };
+layout(std430, binding = 2) writeonly buffer Visible { mat4 visible_matrices[]; };
+
+//the number of instances in each of the two draws
+layout(std430, binding = 3) buffer Counts { uint counts[2]; };
+
+//1 for each instance that the first pass marked to be tested again, 0 otherwise
+layout(std430, binding = 4) buffer States { uint states[]; };
+
+//the indirect commands of the two draws, one per mesh for each of them (see DrawElementsIndirectCommand), and where
+//each mesh is in the buffers of the pool
+struct DrawCommand
+{
+    uint count;
+    uint instance_count;
+    uint first_index;
+    int base_vertex;
+    uint base_instance;
+};
+
+struct PooledMesh
+{
+    uint index_count;
+    uint first_index;
+    int base_vertex;
+    uint unused;
+};
+
+layout(std430, binding = 5) writeonly buffer Commands { DrawCommand commands[]; };
+layout(std430, binding = 6) readonly buffer Meshes { PooledMesh meshes[]; };
+
+//the depth pyramid, holding the farthest depth of each texel (see HiZComputeShader.glsl). Its first level is half of
+//the size of the depth buffer it was built from.
+layout(binding = 0) uniform sampler2D depth_pyramid;
+
+layout(location = 0) uniform int instance_count;
+layout(location = 1) uniform mat4 culling_matrix; //Projection * View * Model, for the depth pyramid being tested
+layout(location = 2) uniform int pyramid_levels; //0 when there is no depth pyramid yet
+layout(location = 3) uniform vec2 depth_size; //the size of the depth buffer, in pixels
+layout(location = 4) uniform vec4 frustum_planes[6];
+layout(location = 10) uniform int draw_pass; //the draw the commands are written for (0 or 1)
+layout(location = 11) uniform int mesh_count;
+
+/*
+ * This checks if the box is entirely outside of one of the planes of the frustum.
+ */
+bool is_outside_frustum(vec3 center, vec3 extent)
+{
+    for(int i = 0; i < 6; i++)
+    {
+        vec4 plane = frustum_planes[i];
+        if(dot(plane.xyz, center) + plane.w + dot(abs(plane.xyz), extent) < 0.0)
+            return true;
+    }
+
+    return false;
+}
+
+/*
+ * This checks if the box is behind the farthest depth of every texel its rectangle on the screen covers, in the first
+ * level of the pyramid where that rectangle spans at most 2x2 texels. A box that crosses the near plane is never
+ * hidden.
+ */
+bool is_occluded(vec3 center, vec3 extent)
+{
+    if(pyramid_levels == 0)
+        return false;
+
+    vec3 ndc_min = vec3(1.0e30);
+    vec3 ndc_max = vec3(-1.0e30);
+    for(int i = 0; i < 8; i++)
+    {
+        vec3 corner = center + extent * vec3((i & 1) != 0 ? 1.0 : -1.0, (i & 2) != 0 ? 1.0 : -1.0,
+                                             (i & 4) != 0 ? 1.0 : -1.0);
+        vec4 clip = culling_matrix * vec4(corner, 1.0);
+        if(clip.w <= 0.0 || clip.z < -clip.w)
+            return false;
+
+        vec3 ndc = clip.xyz / clip.w;
+        ndc_min = min(ndc_min, ndc);
+        ndc_max = max(ndc_max, ndc);
+    }
+
+    //each texel of a level covers 2^(level + 1) pixels across
+    vec2 pixel_min = clamp((ndc_min.xy * 0.5 + 0.5) * depth_size, vec2(0.0), depth_size - 1.0);
+    vec2 pixel_max = clamp((ndc_max.xy * 0.5 + 0.5) * depth_size, vec2(0.0), depth_size - 1.0);
+    vec2 pixels = pixel_max - pixel_min;
+    int level = clamp(int(ceil(log2(max(max(pixels.x, pixels.y), 1.0)))) - 1, 0, pyramid_levels - 1);
+
+    //the size of the level is worked out the same way as for glTexStorage2D, rather than with textureSize (which gives
+    //the size of the first level whatever the level on some drivers)
+    ivec2 level_size = max(ivec2(depth_size) >> (level + 1), ivec2(1));
+    ivec2 first = min(ivec2(pixel_min) >> (level + 1), level_size - 1);
+    ivec2 last = min(ivec2(pixel_max) >> (level + 1), level_size - 1);
+
+    float farthest = 0.0;
+    for(int y = first.y; y <= last.y; y++)
+        for(int x = first.x; x <= last.x; x++)
+            farthest = max(farthest, texelFetch(depth_pyramid, ivec2(x, y), level).r);
+
+    //the depth buffer holds window depths, from 0 at the near plane to 1 at the far plane
+    return ndc_min.z * 0.5 + 0.5 > farthest;
+}
+
+void main()
+{
+    uint i = gl_GlobalInvocationID.x;
+
+#ifdef BUILD_COMMANDS
+    if(i >= uint(mesh_count))
+        return;
+
+    //the instances of the second draw start where those of the first one end in the instance buffer
+    DrawCommand command;
+    command.count = meshes[i].index_count;
+    command.instance_count = counts[draw_pass];
+    command.first_index = meshes[i].first_index;
+    command.base_vertex = meshes[i].base_vertex;
+    command.base_instance = draw_pass == 0 ? 0u : counts[0];
+    commands[uint(draw_pass * mesh_count) + i] = command;
+#else
+    if(i >= uint(instance_count))
+        return;
+
+    vec3 center = boxes[i].center.xyz;
+    vec3 extent = boxes[i].extent.xyz;
+
+#ifdef FIRST_PASS
+    states[i] = 0u;
+    if(is_outside_frustum(center, extent))
+        return;
+
+    if(is_occluded(center, extent))
+    {
+        states[i] = 1u;
+        return;
+    }
+
+    uint slot = atomicAdd(counts[0], 1u);
+    visible_matrices[slot] = matrices[i];
+#else
+    if(states[i] == 0u || is_occluded(center, extent))
+        return;
+
+    uint slot = counts[0] + atomicAdd(counts[1], 1u);
+    visible_matrices[slot] = matrices[i];
+#endif
+#endif
+}
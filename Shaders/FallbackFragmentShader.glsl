@@ -0,0 +1,11 @@
+#version 330 core
+
+out vec3 color;
+
+in vec3 normal;
+
+void main()
+{
+    //a flat gray, just darkened a little based on the direction of the normal so the shape can still be made out
+    color = vec3(0.5f + 0.3f*abs(normalize(normal).z));
+}
@@ -0,0 +1,24 @@
+#version 330 core
+
+layout(location = 0) in vec3 vertexPosition_modelspace;
+layout(location = 1) in vec3 normals;
+
+uniform mat4 model_matrix;
+uniform mat4 view_matrix;
+uniform mat4 projection_matrix;
+
+#ifdef INSTANCED
+layout(location = 2) in mat4 instance_matrix;
+#define MODEL_MATRIX (model_matrix*instance_matrix)
+#else
+#define MODEL_MATRIX model_matrix
+#endif
+
+out vec3 normal;
+
+//this is the cheap shader that is used while the real one is still compiling, so it does no lighting at all
+void main()
+{
+    normal = mat3(MODEL_MATRIX)*normals;
+    gl_Position = projection_matrix*view_matrix*MODEL_MATRIX*vec4(vertexPosition_modelspace, 1);
+}
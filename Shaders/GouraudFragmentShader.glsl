@@ -2,20 +2,26 @@
 
 out vec3 color;
 
+//when compiled as a permutation, the toggles are injected as defines by LoadShaders instead of being uniforms
+#ifndef PERMUTATION
 //the flag to turn the light on and off
 uniform int light_on;
 
 uniform int gray_scale;
 
+#define LIGHT_ON (light_on == 1)
+#define GRAY_SCALE (gray_scale == 1)
+#endif
+
 in vec3 vertex_color;
 
 void main()
 {
-    if(light_on == 1)
+    if(LIGHT_ON)
     {
         color = vertex_color;
 
-        if(gray_scale == 1)
+        if(GRAY_SCALE)
             color = vec3(color.x*0.2989+color.y*0.5870+color.z*0.1140);
     }
 
@@ -3,56 +3,58 @@
 layout(location = 0) in vec3 vertexPosition_modelspace;
 layout(location = 1) in vec3 normals;
 
-//the three color channels
-uniform float red_channel;
-uniform float green_channel;
-uniform float blue_channel;
-
 //information required for lighting
-uniform vec3 light_color;
-uniform vec3 light_position;
-uniform vec3 view_position;
+#include "Lighting.glsl"
 
 uniform mat4 model_matrix;
 uniform mat4 view_matrix;
 uniform mat4 projection_matrix;
+
+//when drawing instances, each one has its own model matrix (read from the instance buffer, one column per attribute),
+//which places it relative to the model matrix shared by all of them
+#ifdef INSTANCED
+layout(location = 2) in mat4 instance_matrix;
+#define MODEL_MATRIX (model_matrix*instance_matrix)
+#else
+#define MODEL_MATRIX model_matrix
+#endif
+
+//when compiled as a permutation, the toggles are injected as defines by LoadShaders instead of being uniforms
+#ifndef PERMUTATION
+//the three color channels
+uniform float red_channel;
+uniform float green_channel;
+uniform float blue_channel;
+
 uniform int normal_as_color;
 
+#define RED_CHANNEL red_channel
+#define GREEN_CHANNEL green_channel
+#define BLUE_CHANNEL blue_channel
+#define NORMAL_AS_COLOR (normal_as_color == 1)
+#endif
+
 out vec3 fragment_position;
 out vec3 normal;
 out vec3 vertex_color;
 
 void main()
 {
-    normal = mat3(model_matrix)*normals;
-    fragment_position = mat3(model_matrix)*vertexPosition_modelspace;
-    gl_Position = projection_matrix*view_matrix*model_matrix*vec4(vertexPosition_modelspace, 1);
-
-    //Ambient light
-    float ambient_strength = 0.25f;
-    vec3 ambient = ambient_strength * light_color;
-
-    //diffuse light
-    float diffuse_coeff = 0.75f;
-    vec3 light_direction = normalize(light_position - vertexPosition_modelspace);
-    float diffuse_strength = max(dot(normalize(normal), light_direction), 0.0f);
-    vec3 diffuse = diffuse_strength*diffuse_coeff*light_color;
-
-    //specular light
-    float spec_coeff = 1.0f;
-    vec3 view_direction = normalize(view_position - vertexPosition_modelspace);
-    vec3 reflect_light_direction = reflect(-light_direction, normalize(normal));
-    float specular_strength = pow(max(dot(reflect_light_direction, view_direction), 0.0f), 32);
-    vec3 specular = specular_strength*spec_coeff*light_color;
-
-    if(normal_as_color == 1)
+    normal = mat3(MODEL_MATRIX)*normals;
+    fragment_position = vec3(MODEL_MATRIX*vec4(vertexPosition_modelspace, 1));
+    gl_Position = projection_matrix*view_matrix*MODEL_MATRIX*vec4(vertexPosition_modelspace, 1);
+
+    //the ambient, diffuse and specular light are computed per vertex
+    vec3 light = compute_lighting(fragment_position, normal);
+
+    if(NORMAL_AS_COLOR)
     {
-        vertex_color = (specular + ambient + diffuse)*normal;
+        vertex_color = light*normal;
     }
 
     else
     {
-        vertex_color = (specular + ambient + diffuse)*vec3(red_channel, green_channel, blue_channel);
+        vertex_color = light*vec3(RED_CHANNEL, GREEN_CHANNEL, BLUE_CHANNEL);
     }
 
 }
\ No newline at end of file
@@ -0,0 +1,34 @@
+#version 430 core
+
+//this builds one level of the depth pyramid the instances are tested against on the GPU (see GpuCulling.h). Each texel
+//of a level keeps the farthest depth of the 2x2 texels below it, in the depth buffer for the first level and in the
+//level before it for the others. When the level below has an odd size, the last texel of the row (or column) covers
+//the 3 texels left over, so that no depth is ever left out.
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+//the level being written
+layout(r32f, binding = 0) uniform writeonly image2D destination;
+
+//the depth buffer, or the pyramid itself, read at source_level
+layout(binding = 0) uniform sampler2D source;
+layout(location = 0) uniform int source_level;
+layout(location = 1) uniform ivec2 source_size; //the size of source_level (see CullingComputeShader.glsl)
+
+void main()
+{
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 size = imageSize(destination);
+    if(any(greaterThanEqual(texel, size)))
+        return;
+
+    ivec2 first = texel * 2;
+    ivec2 last = min(first + 1 + ivec2(equal(texel, size - 1)) * (source_size & 1), source_size - 1);
+
+    float depth = 0.0;
+    for(int y = first.y; y <= last.y; y++)
+        for(int x = first.x; x <= last.x; x++)
+            depth = max(depth, texelFetch(source, ivec2(x, y), source_level).r);
+
+    imageStore(destination, texel, vec4(depth));
+}
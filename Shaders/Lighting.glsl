@@ -0,0 +1,33 @@
+//this is the lighting model shared by the Phong fragment shader and the Gouraud vertex shader. It is included into
+//both of them by the shader preprocessor (see ShaderPreprocessor.h).
+
+//information required for lighting
+uniform vec3 light_color;
+uniform vec3 light_position;
+uniform vec3 view_position;
+
+/*
+ * This computes the sum of the ambient, diffuse and specular light at the passed position for the passed normal.
+ * The result should be multiplied by the color of the surface.
+ */
+vec3 compute_lighting(vec3 position, vec3 normal)
+{
+    //Ambient light
+    float ambient_strength = 0.25f;
+    vec3 ambient = ambient_strength * light_color;
+
+    //diffuse light
+    float diffuse_coeff = 0.75f;
+    vec3 light_direction = normalize(light_position - position);
+    float diffuse_strength = max(dot(normalize(normal), light_direction), 0.0f);
+    vec3 diffuse = diffuse_strength*diffuse_coeff*light_color;
+
+    //specular light
+    float spec_coeff = 1.0f;
+    vec3 view_direction = normalize(view_position - position);
+    vec3 reflect_light_direction = reflect(-light_direction, normalize(normal));
+    float specular_strength = pow(max(dot(reflect_light_direction, view_direction), 0.0f), 32);
+    vec3 specular = specular_strength*spec_coeff*light_color;
+
+    return specular + ambient + diffuse;
+}
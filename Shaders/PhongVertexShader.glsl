@@ -7,13 +7,22 @@
  uniform mat4 view_matrix;
  uniform mat4 projection_matrix;
 
+ //when drawing instances, each one has its own model matrix (read from the instance buffer, one column per attribute),
+ //which places it relative to the model matrix shared by all of them
+ #ifdef INSTANCED
+ layout(location = 2) in mat4 instance_matrix;
+ #define MODEL_MATRIX (model_matrix*instance_matrix)
+ #else
+ #define MODEL_MATRIX model_matrix
+ #endif
+
  out vec3 fragment_position;
  out vec3 normal;
 
  void main()
  {
-     normal = mat3(model_matrix)*normals;
-     fragment_position = mat3(model_matrix)*vertexPosition_modelspace;
+     normal = mat3(MODEL_MATRIX)*normals;
+     fragment_position = vec3(MODEL_MATRIX*vec4(vertexPosition_modelspace, 1));
 
-     gl_Position = projection_matrix*view_matrix*model_matrix*vec4(vertexPosition_modelspace, 1);
+     gl_Position = projection_matrix*view_matrix*MODEL_MATRIX*vec4(vertexPosition_modelspace, 1);
  }
\ No newline at end of file
@@ -0,0 +1,18 @@
+#ifndef COMP_371_A2_CLOCK_H
+#define COMP_371_A2_CLOCK_H
+
+//this contains the definition of the clock that everything is timed with, and of the CPU time used by the process
+//(to tell how busy it is). Neither depends on GLFW being initialized, so they also work when rendering without a
+//window.
+
+/*
+ * This method returns the time in seconds since the program started, from a clock that never goes backwards.
+ */
+double GetTime();
+
+/*
+ * This method returns the CPU time the process has used so far, on all of its threads, in seconds.
+ */
+double GetCpuTime();
+
+#endif //COMP_371_A2_CLOCK_H
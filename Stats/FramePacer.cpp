@@ -0,0 +1,54 @@
+#include "FramePacer.h"
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include "Clock.h"
+
+//the last part of the wait that is spun rather than slept, in seconds
+const double FRAME_LIMITER_SPIN = 0.002;
+
+//how much longer than its interval a frame may take before it is counted as late, as a fraction of the interval, so
+//that the jitter of the clock and of the limiter is not mistaken for a missed deadline
+const double LATE_FRAME_TOLERANCE = 0.25;
+
+void StartFramePacer(FramePacer& pacer, double interval, bool limit)
+{
+    pacer.interval = interval;
+    pacer.limit = limit && interval > 0;
+    pacer.next_start = -1;
+    pacer.last_end = -1;
+}
+
+double WaitForFrameStart(FramePacer& pacer)
+{
+    if(!pacer.limit)
+        return 0;
+
+    double start_time = GetTime();
+    if(pacer.next_start < 0 || start_time > pacer.next_start + pacer.interval)
+        pacer.next_start = start_time;
+
+    double sleep_until = pacer.next_start - FRAME_LIMITER_SPIN;
+    if(start_time < sleep_until)
+        std::this_thread::sleep_for(std::chrono::duration<double>(sleep_until - start_time));
+
+    while(GetTime() < pacer.next_start)
+        std::this_thread::yield();
+
+    pacer.next_start += pacer.interval;
+    return (GetTime() - start_time) * 1000.0;
+}
+
+int EndPacedFrame(FramePacer& pacer, double end_time)
+{
+    int missed = 0;
+    if(pacer.interval > 0 && pacer.last_end >= 0)
+    {
+        double frames = (end_time - pacer.last_end) / pacer.interval;
+        if(frames > 1 + LATE_FRAME_TOLERANCE)
+            missed = (int)ceil(frames - 1 - LATE_FRAME_TOLERANCE);
+    }
+
+    pacer.last_end = end_time;
+    return missed;
+}
@@ -0,0 +1,48 @@
+#ifndef COMP_371_A2_FRAMEPACER_H
+#define COMP_371_A2_FRAMEPACER_H
+
+//this contains the definitions for pacing the frames: holding the start of each frame back so that they come at a
+//steady rate (the frame limiter), and finding the frames that took longer than the time they had, whether that time
+//is set by the limiter or by the refresh rate of the display (when the swap waits for it).
+//
+//The limiter sleeps until shortly before the frame is due, since the sleep of the OS can overshoot by a millisecond or
+//more, and spins for the rest so that the frame starts on time without keeping a core busy for the whole wait.
+
+/*
+ * This holds the rate the frames are paced at, and when the next one is due.
+ */
+struct FramePacer
+{
+    double interval; //the time each frame has, in seconds (0 when there is no deadline)
+    bool limit; //whether the start of each frame is held back to the interval, rather than by the swap
+    double next_start; //when the next frame is due to start, when limiting (-1 before the first one)
+    double last_end; //when the last frame ended (-1 before the first one)
+};
+
+/*
+ * This method sets the rate the frames are paced at.
+ * @param pacer: The pacer. Passed by reference.
+ * @param interval: The time each frame has, in seconds, or 0 for no deadline at all
+ * @param limit: Whether the start of each frame is held back to the interval (the frame limiter), or if only the late
+ * frames are found (when the swap waits for the display)
+ */
+void StartFramePacer(FramePacer& pacer, double interval, bool limit);
+
+/*
+ * This method waits until the next frame is due, when limiting. It is called at the start of each frame. If the frames
+ * have fallen a whole interval behind, the next one starts right away and the ones after it are paced from there,
+ * rather than rushed to catch up.
+ * @return The time spent waiting, in milliseconds
+ */
+double WaitForFrameStart(FramePacer& pacer);
+
+/*
+ * This method checks if the frame that just ended was late, from the time since the last frame ended.
+ * @param pacer: The pacer. Passed by reference.
+ * @param end_time: When the frame ended (after the swap), in seconds (see Clock.h)
+ * @return The number of deadlines the frame missed: 0 when it was on time, 1 when it took the time of two frames, and
+ * so on (each one is a refresh of the display, or a slot of the limiter, that went by without a new frame)
+ */
+int EndPacedFrame(FramePacer& pacer, double end_time);
+
+#endif //COMP_371_A2_FRAMEPACER_H
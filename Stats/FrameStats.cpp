@@ -0,0 +1,130 @@
+#include "FrameStats.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+//the names the timings are printed and exported with, in the same order as the FrameMetric enum
+static const char* METRIC_NAMES[METRIC_COUNT] =
+{
+    "cpu_limiter",
+    "cpu_poll",
+    "cpu_update",
+    "cpu_cull",
+    "cpu_occlusion",
+    "cpu_packets",
+    "cpu_fence_wait",
+    "cpu_submit",
+    "cpu_swap",
+    "cpu_frame",
+    "frame_interval",
+    "input_latency",
+    "gpu_clear",
+    "gpu_scene",
+    "gpu_cull",
+    "gpu_upscale",
+    "gpu_frame"
+};
+
+static std::vector<RollingStats> metrics(METRIC_COUNT, RollingStats(FRAME_STATS_SAMPLES));
+
+//the time each frame has (0 if there is no deadline), the number of frames counted against it, how many of them were
+//late and how many deadlines they missed between them
+static double deadline_ms = 0;
+static long long paced_frames = 0;
+static long long late_frames = 0;
+static long long missed_deadlines = 0;
+
+void AddFrameSample(FrameMetric metric, double ms)
+{
+    AddSample(metrics[metric], ms);
+}
+
+const RollingStats& GetFrameMetric(FrameMetric metric)
+{
+    return metrics[metric];
+}
+
+void SetFrameDeadline(double interval_ms)
+{
+    deadline_ms = interval_ms;
+}
+
+void AddFrameDeadlines(int missed)
+{
+    paced_frames++;
+    if(missed > 0)
+    {
+        late_frames++;
+        missed_deadlines += missed;
+    }
+}
+
+void PrintFrameStats()
+{
+    std::cout << "Frame timings (ms): average / p50 / p95 / p99 / max" << std::endl;
+
+    for(int i = 0; i < METRIC_COUNT; i++)
+    {
+        const RollingStats& stats = metrics[i];
+        if(stats.count == 0)
+            continue;
+
+        std::cout << "  " << METRIC_NAMES[i] << ": " << GetAverage(stats) << " / " << GetPercentile(stats, 50)
+                  << " / " << GetPercentile(stats, 95) << " / " << GetPercentile(stats, 99) << " / "
+                  << GetPercentile(stats, 100) << " (" << stats.count << " samples)" << std::endl;
+    }
+
+    if(deadline_ms > 0)
+        std::cout << "Late frames: " << late_frames << " of " << paced_frames << " missed their deadline of "
+                  << deadline_ms << " ms (" << missed_deadlines << " deadlines missed in all)" << std::endl;
+}
+
+bool ExportFrameStats(const char* file_path)
+{
+    std::ofstream out(file_path);
+    if(!out.is_open())
+    {
+        std::cout << "Could not open " << file_path << " to save the frame timings" << std::endl;
+        return false;
+    }
+
+    int length = strlen(file_path);
+    bool json = length >= 5 && strcmp(file_path + length - 5, ".json") == 0;
+
+    if(json)
+        out << "{" << std::endl;
+
+    else
+        out << "metric,samples,average_ms,p50_ms,p95_ms,p99_ms,max_ms" << std::endl;
+
+    bool first = true;
+    for(int i = 0; i < METRIC_COUNT; i++)
+    {
+        const RollingStats& stats = metrics[i];
+        if(stats.count == 0)
+            continue;
+
+        if(json)
+        {
+            out << (first ? "" : ",\n") << "  \"" << METRIC_NAMES[i] << "\": {\"samples\": " << stats.count
+                << ", \"average_ms\": " << GetAverage(stats) << ", \"p50_ms\": " << GetPercentile(stats, 50)
+                << ", \"p95_ms\": " << GetPercentile(stats, 95) << ", \"p99_ms\": " << GetPercentile(stats, 99)
+                << ", \"max_ms\": " << GetPercentile(stats, 100) << "}";
+        }
+
+        else
+        {
+            out << METRIC_NAMES[i] << "," << stats.count << "," << GetAverage(stats) << ","
+                << GetPercentile(stats, 50) << "," << GetPercentile(stats, 95) << "," << GetPercentile(stats, 99)
+                << "," << GetPercentile(stats, 100) << std::endl;
+        }
+
+        first = false;
+    }
+
+    if(json)
+        out << std::endl << "}" << std::endl;
+
+    return out.good();
+}
@@ -0,0 +1,73 @@
+#ifndef COMP_371_A2_FRAMESTATS_H
+#define COMP_371_A2_FRAMESTATS_H
+
+#include "RollingStats.h"
+
+//this contains the definitions for the timings that are taken every frame, on the CPU (around each phase of the main
+//loop) and on the GPU (around each pass, see GpuTimer.h). Each one keeps its most recent samples, so that its
+//percentiles can be printed or exported (to track both CPU bound and GPU bound slowdowns).
+
+/*
+ * These are the timings taken every frame, in milliseconds.
+ */
+enum FrameMetric
+{
+    METRIC_CPU_LIMITER, //waiting for the frame to be due, with the frame limiter (not part of the frame)
+    METRIC_CPU_POLL, //polling the window events
+    METRIC_CPU_UPDATE, //reloading shaders, applying the input and updating the state of the programs
+    METRIC_CPU_CULL, //culling the instances against the view frustum (part of the update)
+    METRIC_CPU_OCCLUSION, //rejecting the instances hidden behind others (part of the update)
+    METRIC_CPU_PACKETS, //building the draws of the visible instances on the worker threads (part of the update)
+    METRIC_CPU_FENCE_WAIT, //waiting for the GPU to be done with the region of the stream buffer (part of the update)
+    METRIC_CPU_SUBMIT, //issuing the draw calls
+    METRIC_CPU_SWAP, //swapping the buffers (or waiting for the frame to finish, without a window)
+    METRIC_CPU_FRAME, //the whole frame
+    METRIC_FRAME_INTERVAL, //the time between the ends of two frames in a row, which is what the frame pacing looks like
+    METRIC_INPUT_LATENCY, //from sampling the input to the end of the frame showing it
+    METRIC_GPU_CLEAR, //clearing the framebuffer
+    METRIC_GPU_SCENE, //drawing the scene
+    METRIC_GPU_CULL, //culling the instances with compute shaders (part of the scene, only when culling on the GPU)
+    METRIC_GPU_UPSCALE, //stretching the scene over the output (only with dynamic resolution)
+    METRIC_GPU_FRAME, //the whole frame
+    METRIC_COUNT
+};
+
+//the number of samples kept for each timing
+const int FRAME_STATS_SAMPLES = 10000;
+
+/*
+ * This method adds a sample to one of the timings.
+ */
+void AddFrameSample(FrameMetric metric, double ms);
+
+/*
+ * This method returns the samples of one of the timings.
+ */
+const RollingStats& GetFrameMetric(FrameMetric metric);
+
+/*
+ * This method sets the time each frame has, which the late frames are counted against (see FramePacer.h).
+ * @param interval_ms: The time each frame has, in milliseconds, or 0 if the frames have no deadline
+ */
+void SetFrameDeadline(double interval_ms);
+
+/*
+ * This method counts a frame, and whether it was late.
+ * @param missed_deadlines: The number of deadlines the frame missed (0 if it was on time)
+ */
+void AddFrameDeadlines(int missed_deadlines);
+
+/*
+ * This method prints the average, p50, p95, p99 and max of every timing, and the number of late frames if the frames
+ * have a deadline.
+ */
+void PrintFrameStats();
+
+/*
+ * This method saves the average, p50, p95, p99 and max of every timing to a file, as JSON if its name ends with
+ * ".json" or as CSV otherwise.
+ * @return A boolean specifying if the file could be written or not.
+ */
+bool ExportFrameStats(const char* file_path);
+
+#endif //COMP_371_A2_FRAMESTATS_H
@@ -0,0 +1,69 @@
+#include "GpuTimer.h"
+
+//the queries of each frame in the ring, one after the other
+static std::vector<GLuint> queries;
+static int timestamps_per_frame = 0;
+
+//the frame of the ring the timestamps are written to, and whether each frame of the ring holds timestamps that have
+//not been read back yet
+static int current_frame = 0;
+static bool pending[GPU_TIMER_FRAMES];
+static int dropped_frames = 0;
+
+void InitGpuTimer(int timestamp_count)
+{
+    timestamps_per_frame = timestamp_count;
+    queries.resize(GPU_TIMER_FRAMES * timestamp_count);
+    glGenQueries(queries.size(), &queries[0]);
+
+    current_frame = 0;
+    dropped_frames = 0;
+    for(int i = 0; i < GPU_TIMER_FRAMES; i++)
+        pending[i] = false;
+}
+
+void ShutdownGpuTimer()
+{
+    if(!queries.empty())
+        glDeleteQueries(queries.size(), &queries[0]);
+
+    queries.clear();
+}
+
+void WriteGpuTimestamp(int index)
+{
+    glQueryCounter(queries[current_frame * timestamps_per_frame + index], GL_TIMESTAMP);
+}
+
+bool EndGpuTimerFrame(std::vector<GLuint64>& out_timestamps)
+{
+    pending[current_frame] = true;
+
+    //the next frame of the ring is the oldest one, whose queries the next frame is going to reuse
+    current_frame = (current_frame + 1) % GPU_TIMER_FRAMES;
+    if(!pending[current_frame])
+        return false;
+
+    pending[current_frame] = false;
+    GLuint* frame_queries = &queries[current_frame * timestamps_per_frame];
+
+    //the timestamps are written in order, so once the last one is available all of them are
+    GLint available = 0;
+    glGetQueryObjectiv(frame_queries[timestamps_per_frame - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if(!available)
+    {
+        dropped_frames++;
+        return false;
+    }
+
+    out_timestamps.resize(timestamps_per_frame);
+    for(int i = 0; i < timestamps_per_frame; i++)
+        glGetQueryObjectui64v(frame_queries[i], GL_QUERY_RESULT, &out_timestamps[i]);
+
+    return true;
+}
+
+int GetDroppedGpuTimerFrames()
+{
+    return dropped_frames;
+}
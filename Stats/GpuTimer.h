@@ -0,0 +1,46 @@
+#ifndef COMP_371_A2_GPUTIMER_H
+#define COMP_371_A2_GPUTIMER_H
+
+#include <glew.h>
+#include <vector>
+
+//this contains the definitions for timing the passes of a frame on the GPU. Each frame writes a number of GPU
+//timestamps (i.e. one before and one after each pass), and the difference between two of them is how long the GPU
+//took to get from one to the other.
+//
+//The results of a frame are only read a few frames later, once the GPU is done with it, so the render thread never
+//waits on them. To do this, the queries are kept in a ring with one set of timestamps per frame in flight.
+
+//the number of frames whose timestamps can be in flight at once
+const int GPU_TIMER_FRAMES = 4;
+
+/*
+ * This method creates the queries for the passed number of timestamps per frame.
+ */
+void InitGpuTimer(int timestamp_count);
+
+/*
+ * This method deletes the queries.
+ */
+void ShutdownGpuTimer();
+
+/*
+ * This method writes the timestamp with the passed index for the current frame, once the GPU gets to this point.
+ */
+void WriteGpuTimestamp(int index);
+
+/*
+ * This method ends the current frame. If the oldest frame in the ring is done on the GPU, its timestamps are read back.
+ * Otherwise they are dropped, since their queries are about to be reused. This never waits on the GPU.
+ * @param out_timestamps: This will hold the timestamps of the oldest frame (in nanoseconds), if they were read back.
+ * Passed by reference.
+ * @return A boolean specifying if the timestamps of a frame were read back or not.
+ */
+bool EndGpuTimerFrame(std::vector<GLuint64>& out_timestamps);
+
+/*
+ * This method returns the number of frames whose timestamps were dropped because they were not ready in time.
+ */
+int GetDroppedGpuTimerFrames();
+
+#endif //COMP_371_A2_GPUTIMER_H
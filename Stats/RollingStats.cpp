@@ -0,0 +1,43 @@
+#include "RollingStats.h"
+#include <algorithm>
+#include <cmath>
+
+RollingStats::RollingStats(int capacity)
+{
+    samples.resize(capacity);
+    next = 0;
+    count = 0;
+}
+
+void AddSample(RollingStats& stats, double sample)
+{
+    stats.samples[stats.next] = sample;
+    stats.next = (stats.next + 1) % stats.samples.size();
+    stats.count = std::min(stats.count + 1, (int)stats.samples.size());
+}
+
+double GetPercentile(const RollingStats& stats, double percentile)
+{
+    if(stats.count == 0)
+        return 0;
+
+    //we only need the one sample at the rank of the percentile, so a partial sort of a copy is enough
+    std::vector<double> sorted(stats.samples.begin(), stats.samples.begin() + stats.count);
+    int rank = (int)std::ceil(percentile / 100.0 * stats.count) - 1;
+    rank = std::max(0, std::min(rank, stats.count - 1));
+
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+    return sorted[rank];
+}
+
+double GetAverage(const RollingStats& stats)
+{
+    if(stats.count == 0)
+        return 0;
+
+    double total = 0;
+    for(int i = 0; i < stats.count; i++)
+        total += stats.samples[i];
+
+    return total / stats.count;
+}
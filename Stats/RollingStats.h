@@ -0,0 +1,42 @@
+#ifndef COMP_371_A2_ROLLINGSTATS_H
+#define COMP_371_A2_ROLLINGSTATS_H
+
+#include <vector>
+
+//this contains the definitions for keeping track of the most recent samples of a measurement (i.e. frame times or
+//latencies), so that percentiles of it can be reported while the program runs.
+
+/*
+ * This holds the last samples of a measurement. Once it is full, each new sample replaces the oldest one.
+ */
+struct RollingStats
+{
+    std::vector<double> samples;
+    int next; //the index the next sample is written to
+    int count; //the number of samples held (at most the capacity)
+
+    RollingStats(int capacity);
+};
+
+/*
+ * This method adds a sample, replacing the oldest one if the stats are full.
+ * @param stats: The stats to add the sample to. Passed by reference.
+ * @param sample: The value of the new sample
+ */
+void AddSample(RollingStats& stats, double sample);
+
+/*
+ * This method computes a percentile of the samples that are held (i.e. 50 for the median).
+ * @param stats: The stats to compute the percentile of
+ * @param percentile: The percentile, between 0 and 100
+ * @return The smallest sample that is greater than or equal to the passed percentage of the samples (0 if there are no
+ * samples)
+ */
+double GetPercentile(const RollingStats& stats, double percentile);
+
+/*
+ * This method computes the average of the samples that are held (0 if there are no samples).
+ */
+double GetAverage(const RollingStats& stats);
+
+#endif //COMP_371_A2_ROLLINGSTATS_H
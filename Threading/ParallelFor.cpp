@@ -0,0 +1,143 @@
+#include "ParallelFor.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//everything shared with the worker threads. Each call to ParallelFor starts a new generation of work, which the
+//workers wait for.
+static std::vector<std::thread> workers;
+static std::mutex work_mutex;
+static std::condition_variable work_condition;
+static std::condition_variable done_condition;
+static int generation = 0;
+static bool stop_workers = false;
+
+//the work of the current generation: the tasks are handed out through next_task, and counted in done_tasks. The
+//workers that picked up the generation are counted in active_workers, so that none of them is still holding on to it
+//when ParallelFor returns.
+static const std::function<void(int)>* current_task = nullptr;
+static int current_task_count = 0;
+static std::atomic<int> next_task(0);
+static int done_tasks = 0;
+static int active_workers = 0;
+
+/*
+ * This takes tasks of the current generation until there are none left, and returns how many it ran.
+ */
+static int RunTasks(const std::function<void(int)>& task, int task_count)
+{
+    int ran = 0;
+
+    for(int index = next_task++; index < task_count; index = next_task++)
+    {
+        task(index);
+        ran++;
+    }
+
+    return ran;
+}
+
+/*
+ * This is the loop run by each of the worker threads.
+ */
+static void WorkerLoop()
+{
+    int seen_generation = 0;
+
+    while(true)
+    {
+        const std::function<void(int)>* task;
+        int task_count;
+
+        {
+            std::unique_lock<std::mutex> lock(work_mutex);
+            work_condition.wait(lock, [&]{ return stop_workers || generation != seen_generation; });
+
+            if(stop_workers)
+                return;
+
+            //a worker that only wakes up once ParallelFor has returned finds the work of that generation gone, and
+            //must not take the tasks of the next one (which it will be woken up for)
+            seen_generation = generation;
+            if(current_task == nullptr)
+                continue;
+
+            task = current_task;
+            task_count = current_task_count;
+            active_workers++;
+        }
+
+        int ran = RunTasks(*task, task_count);
+
+        std::lock_guard<std::mutex> lock(work_mutex);
+        done_tasks += ran;
+        active_workers--;
+        if(done_tasks == task_count && active_workers == 0)
+            done_condition.notify_one();
+    }
+}
+
+void StartParallelFor(int thread_count)
+{
+    if(thread_count <= 0)
+        thread_count = std::max((int)std::thread::hardware_concurrency(), 1);
+
+    stop_workers = false;
+    for(int i = 1; i < thread_count; i++)
+        workers.push_back(std::thread(WorkerLoop));
+}
+
+void StopParallelFor()
+{
+    {
+        std::lock_guard<std::mutex> lock(work_mutex);
+        stop_workers = true;
+    }
+
+    work_condition.notify_all();
+    for(int i = 0; i < workers.size(); i++)
+        workers[i].join();
+
+    workers.clear();
+}
+
+int GetParallelForThreads()
+{
+    return workers.size() + 1;
+}
+
+void ParallelFor(int task_count, const std::function<void(int)>& task)
+{
+    //with nothing to split, there is no need to wake anyone up
+    if(workers.empty() || task_count <= 1)
+    {
+        for(int i = 0; i < task_count; i++)
+            task(i);
+
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(work_mutex);
+        current_task = &task;
+        current_task_count = task_count;
+        next_task = 0;
+        done_tasks = 0;
+        generation++;
+    }
+
+    work_condition.notify_all();
+
+    //this thread takes tasks like the workers do, and then waits for the ones they are still running
+    int ran = RunTasks(task, task_count);
+
+    std::unique_lock<std::mutex> lock(work_mutex);
+    done_tasks += ran;
+    done_condition.wait(lock, [&]{ return done_tasks == task_count && active_workers == 0; });
+
+    //the task belongs to the caller, so no worker may hold on to it past this point
+    current_task = nullptr;
+}
@@ -0,0 +1,33 @@
+#ifndef COMP_371_A2_PARALLELFOR_H
+#define COMP_371_A2_PARALLELFOR_H
+
+#include <functional>
+
+//this contains the definitions for splitting work that is done every frame (i.e. culling thousands of instances)
+//across a few threads. The threads are started once and wait for work between frames, and the thread that hands out
+//the work takes part in it as well.
+
+/*
+ * This method starts the worker threads.
+ * @param thread_count: The total number of threads the work is split across, including the calling thread. 0 uses one
+ * thread per hardware thread, and 1 does everything on the calling thread.
+ */
+void StartParallelFor(int thread_count);
+
+/*
+ * This method stops the worker threads, waiting for them to finish.
+ */
+void StopParallelFor();
+
+/*
+ * This method returns the number of threads the work is split across, including the calling thread.
+ */
+int GetParallelForThreads();
+
+/*
+ * This method runs the passed task once for each index from 0 to task_count - 1, spread across the threads, and
+ * returns once every task is done. Tasks may run in any order, and should not depend on each other.
+ */
+void ParallelFor(int task_count, const std::function<void(int)>& task);
+
+#endif //COMP_371_A2_PARALLELFOR_H
@@ -0,0 +1,74 @@
+#ifndef COMP_371_A2_SPSCQUEUE_H
+#define COMP_371_A2_SPSCQUEUE_H
+
+#include <atomic>
+
+//this contains the definitions for a queue that one thread pushes into and another one pops from (i.e. the input
+//sampled on the window thread, for the render thread), without either of them ever taking a lock or waiting for the
+//other. The items live in a ring of fixed size: the producer only ever writes the tail and the consumer the head, and
+//each of them publishes the slot it is done with through its index (release), which the other reads before touching
+//that slot (acquire).
+
+/*
+ * This is a queue between a single producer thread and a single consumer thread. It holds up to CAPACITY - 1 items,
+ * since one slot is always left empty to tell a full ring from an empty one.
+ */
+template<typename T, int CAPACITY>
+struct SpscQueue
+{
+    T items[CAPACITY];
+    std::atomic<int> head; //the next slot to pop from, only written by the consumer
+    std::atomic<int> tail; //the next slot to push into, only written by the producer
+
+    SpscQueue() : head(0), tail(0)
+    {
+    }
+};
+
+/*
+ * This method checks if the queue is full. It is only called by the producer, for which the answer can only go from
+ * true to false while it is not looking.
+ */
+template<typename T, int CAPACITY>
+bool IsSpscQueueFull(const SpscQueue<T, CAPACITY>& queue)
+{
+    int next = (queue.tail.load(std::memory_order_relaxed) + 1) % CAPACITY;
+    return next == queue.head.load(std::memory_order_acquire);
+}
+
+/*
+ * This method adds an item at the end of the queue. It is only called by the producer.
+ * @return A boolean specifying if the item was added, or if the queue was full.
+ */
+template<typename T, int CAPACITY>
+bool PushSpscQueue(SpscQueue<T, CAPACITY>& queue, const T& item)
+{
+    int tail = queue.tail.load(std::memory_order_relaxed);
+    int next = (tail + 1) % CAPACITY;
+    if(next == queue.head.load(std::memory_order_acquire))
+        return false;
+
+    queue.items[tail] = item;
+    queue.tail.store(next, std::memory_order_release);
+    return true;
+}
+
+/*
+ * This method takes the item at the front of the queue. It is only called by the consumer.
+ * @param queue: The queue. Passed by reference.
+ * @param out_item: This will hold the item, if there was one. Passed by reference.
+ * @return A boolean specifying if there was an item, or if the queue was empty.
+ */
+template<typename T, int CAPACITY>
+bool PopSpscQueue(SpscQueue<T, CAPACITY>& queue, T& out_item)
+{
+    int head = queue.head.load(std::memory_order_relaxed);
+    if(head == queue.tail.load(std::memory_order_acquire))
+        return false;
+
+    out_item = queue.items[head];
+    queue.head.store((head + 1) % CAPACITY, std::memory_order_release);
+    return true;
+}
+
+#endif //COMP_371_A2_SPSCQUEUE_H
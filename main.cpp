@@ -1,4 +1,14 @@
 #include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <algorithm>
+#include <set>
+#include <vector>
 #include <glew.h>
 #include <GLFW/glfw3.h>
 #include "GLM/glm/matrix.hpp"
@@ -6,84 +16,570 @@
 #include "GLM/glm/gtc/type_ptr.hpp"
 #include "Loaders/ShaderLoader.h"
 #include "Loaders/ObjectLoader.h"
+#include "Loaders/ShaderVariants.h"
+#include "Loaders/ShaderCompiler.h"
+#include "Loaders/ShaderWatcher.h"
+#include "Loaders/ShaderReflection.h"
+#include "Rendering/RenderState.h"
+#include "Stats/RollingStats.h"
+#include "Stats/Clock.h"
+#include "Stats/FrameStats.h"
+#include "Stats/GpuTimer.h"
+#include "Stats/FramePacer.h"
+#include "Rendering/HeadlessContext.h"
+#include "Rendering/Framebuffer.h"
+#include "Rendering/DynamicResolution.h"
+#include "Rendering/GLStateCache.h"
+#include "Rendering/InstanceBuffer.h"
+#include "Rendering/MeshPool.h"
+#include "Rendering/StreamBuffer.h"
+#include "Rendering/DrawPackets.h"
+#include "Rendering/GpuCulling.h"
+#include "Scene/InstanceGrid.h"
+#include "Scene/SceneGraph.h"
+#include "Scene/FrustumCulling.h"
+#include "Scene/OcclusionCulling.h"
+#include "Threading/ParallelFor.h"
+#include "Threading/SpscQueue.h"
 #include "Controls/KeyboardControls.h"
+#include "Controls/ActionBindings.h"
+#include "Controls/InputRecording.h"
+#include "Benchmark/BenchmarkRuns.h"
+
+//the state of the scene (matrices, toggles and light). The controls only ever change this, and it is flushed to the
+//uniforms of the current program once per frame
+RenderState render_state;
+ProgramUniforms uniforms; //the handles for the uniforms of the current program, resolved when it was linked
 
-//definition of all the uniforms
-GLuint view_mat_ID;
-GLuint model_mat_ID;
-GLuint projection_mat_ID;
-glm::mat4 Model;
-glm::mat4 Projection;
-glm::mat4 View;
-GLuint red_channel_id;
-GLuint blue_channel_id;
-GLuint green_channel_id;
-GLuint light_position;
-GLuint light_color;
-GLuint view_position;
-
-GLuint lightOn; //a flag to determine whether or not the light should be on (1 is on, 0 is off)
-GLboolean gouraud_flag; //this determines if we use gouraud or not (alternative is phong) for lighting
-GLuint normal_as_color; //this is a flag to determine if the normal should be used as color (M key toggles on/off)
-GLuint gray_scale; //this is a flag to determine if the scene should be rendered in grayscale or not (key G)
 GLuint programID; //this variable will be assigned the program ID of the shader program
-                  //since we need it to modify the color channels, we will make it global
-                  //so we can use it in the keyboard callback method
+
+//when rendering without a window (--headless), everything is rendered into this framebuffer instead
+bool headless = false;
+Framebuffer headless_framebuffer;
+
+//this is set when the program should stop at the end of the current frame (i.e. when a replay is over)
+bool quit = false;
+
+//with --render-thread, the frames are rendered on a thread of their own, which owns the OpenGL context, while the main
+//thread deals with the window and samples the input (see runRenderThread)
+bool render_thread = false;
+
+//how the swap waits for the display (--swap-interval): for every refresh, for every refresh unless the frame is late
+//(in which case it tears rather than waiting for the next one), or not at all
+enum SwapMode
+{
+    SWAP_VSYNC,
+    SWAP_ADAPTIVE,
+    SWAP_UNCAPPED
+};
+
+SwapMode swap_mode = SWAP_VSYNC;
+
+//the rate the frame limiter holds the frames to (--fps, 0 for no limit), and the pacer that does it and counts the
+//frames that miss their deadline (see FramePacer.h)
+double frame_rate_limit = 0;
+FramePacer frame_pacer;
+
+//with --dynamic-resolution, the GPU time each frame should take (0 when it is off), and the framebuffer the scene is
+//drawn into at a lower resolution when the frames go over it (see DynamicResolution.h)
+double resolution_target_ms = 0;
+DynamicResolution dynamic_resolution;
+
+//with --on-demand, a frame is only drawn when something needs it (see frameNeeded), and the window keeps showing the
+//last one otherwise. This is set when the window has to be drawn again (i.e. after being uncovered).
+bool on_demand = false;
+bool redraw_requested = true;
+
+//when running the scripted benchmark (--benchmark), the camera follows a fixed path instead of the input, and the
+//frames are not synchronized with the display
+bool benchmarking = false;
+
+/*
+ * This holds everything needed to draw the loaded object, either once or as a number of instances.
+ */
+struct LoadedObject
+{
+    GLuint vertex_array; //for drawing the object once
+    GLuint instanced_vertex_array; //the same, with the instance matrices as well (see InstanceBuffer.h)
+    MeshPool meshes; //the parts of the object, each drawn as a mesh of its own (see MeshPool.h)
+    InstanceBuffer instances;
+
+    float radius; //the radius of the bounding sphere of the object, around the origin
+    glm::vec3 box_min; //the corners of the bounding box of the object
+    glm::vec3 box_max;
+
+    //the instances are the nodes below the root of the scene graph (see SceneGraph.h), and their model matrices are the
+    //world matrices of those nodes
+    SceneGraph scene;
+    std::vector<int> node_instances; //the instance each node is, indexed by its handle (-1 for the root)
+
+    //the instances, and their bounds for culling them against the view frustum (see FrustumCulling.h)
+    int instance_count; //the number of instances to draw, or 0 to draw the object once without instancing
+    std::vector<glm::mat4> instance_matrices;
+    InstanceBounds instance_bounds;
+
+    //the box around every instance, whose depth is split into the buckets the instances are drawn in
+    glm::vec3 scene_box_min;
+    glm::vec3 scene_box_max;
+
+    //the instances that are in the instance buffer (all of them, or the visible ones when culling)
+    std::vector<int> visible;
+    std::vector<glm::mat4> visible_matrices;
+    int drawn_instance_count;
+
+    //the draws of the visible instances, built on the worker threads when culling (see DrawPackets.h)
+    DrawPacketLists packets;
+    bool packets_built;
+
+    //the triangles the instances are drawn with when they hide others (see OcclusionCulling.h)
+    std::vector<glm::vec3> occluder_triangles;
+};
+
+LoadedObject object;
+
+//the mesh the occluders are drawn with, when it is not the object itself (--occluder)
+const char* occluder_path = NULL;
+
+//the number of parts the object is split into, each of which is drawn as a distinct mesh, and whether the meshes are
+//all drawn in a single call (glMultiDrawElementsIndirect) rather than one call each
+int mesh_parts = 1;
+bool multi_draw = true;
+
+//the matrices of the visible instances and the draw commands are written into this buffer every frame, which stays
+//mapped (see StreamBuffer.h), unless streaming is turned off or the driver can not do it. It is only written between
+//the start and the end of a frame, while streaming_frame is set.
+StreamBuffer stream_buffer;
+bool streaming = true;
+bool streaming_available = false;
+bool streaming_frame = false;
+
+/*
+ * Method to load the object at the passed path into the mesh pool, replacing what it held. The triangles of the object
+ * are split into mesh_parts meshes, in the order they are in the file.
+ * @return A boolean specifying if the object could be loaded or not.
+ */
+static bool loadMesh(const char* path)
+{
+    std::vector<glm::vec3> vertices, normals;
+    std::vector<glm::vec2> uvs;
+    if(!LoadOBJ(path, vertices, normals, uvs) || vertices.empty())
+        return false;
+
+    int triangles = vertices.size() / 3;
+    int parts = std::min(mesh_parts, triangles);
+    ClearMeshPool(object.meshes);
+    for(int i = 0; i < parts; i++)
+    {
+        int first = (int)((long long)triangles * i / parts);
+        int last = (int)((long long)triangles * (i + 1) / parts);
+        AddMeshToPool(object.meshes, vertices, normals, first * 3, (last - first) * 3);
+    }
+
+    UploadMeshPool(object.meshes);
+
+    if(occluder_path == NULL)
+        object.occluder_triangles = vertices;
+
+    object.radius = 0;
+    object.box_min = vertices[0];
+    object.box_max = vertices[0];
+    for(int i = 0; i < vertices.size(); i++)
+    {
+        object.radius = std::max(object.radius, glm::length(vertices[i]));
+        object.box_min = glm::min(object.box_min, vertices[i]);
+        object.box_max = glm::max(object.box_max, vertices[i]);
+    }
+
+    return true;
+}
+
+//whether the instances are culled against the view frustum every frame, or all drawn
+bool culling = true;
+
+//whether the instances hidden behind the nearest ones are left out as well, and how long that may take per frame
+bool occlusion_culling = false;
+double occlusion_budget_ms = 1.0;
+
+//whether the instances are culled on the GPU instead (see GpuCulling.h), which replaces both of the above. This is
+//turned off if the GPU can not do it.
+bool gpu_culling = false;
+bool gpu_culling_available = false;
+
+/*
+ * Method to update the scene graph, and to copy the world matrices of the nodes it recomputed into the instances. When
+ * any of them moved, everything that follows from the instance matrices is refreshed: their bounds, the instance
+ * buffer, and the instances culled on the GPU.
+ * @return A boolean specifying if any instance moved
+ */
+static bool updateSceneInstances()
+{
+    if(UpdateSceneGraph(object.scene) == 0)
+        return false;
+
+    const std::vector<int>& updated = object.scene.updated;
+    for(int i = 0; i < updated.size(); i++)
+    {
+        int instance = object.node_instances[object.scene.nodes[updated[i]]];
+        if(instance >= 0)
+            object.instance_matrices[instance] = object.scene.worlds[updated[i]];
+    }
+
+    BuildInstanceBounds(object.instance_matrices, object.box_min, object.box_max, object.radius,
+                        object.instance_bounds);
+
+    const InstanceBounds& bounds = object.instance_bounds;
+    object.scene_box_min = glm::vec3(0.0f);
+    object.scene_box_max = glm::vec3(0.0f);
+    for(int i = 0; i < object.instance_count; i++)
+    {
+        glm::vec3 box_min(bounds.box_x[i] - bounds.extent_x[i], bounds.box_y[i] - bounds.extent_y[i],
+                          bounds.box_z[i] - bounds.extent_z[i]);
+        glm::vec3 box_max(bounds.box_x[i] + bounds.extent_x[i], bounds.box_y[i] + bounds.extent_y[i],
+                          bounds.box_z[i] + bounds.extent_z[i]);
+        object.scene_box_min = i > 0 ? glm::min(object.scene_box_min, box_min) : box_min;
+        object.scene_box_max = i > 0 ? glm::max(object.scene_box_max, box_max) : box_max;
+    }
+
+    //without culling, the instance buffer always holds all of the instances
+    UploadInstanceMatrices(object.instances, object.instance_matrices);
+
+    //when culling on the GPU, the instance buffer is then overwritten with the visible instances every frame
+    if(gpu_culling)
+        SetGpuCullingInstances(object.instance_matrices, object.instance_bounds, object.meshes,
+                               object.instances.buffer);
+
+    return true;
+}
+
+/*
+ * Method to set the number of instances of the object that are drawn (0 to draw it once without instancing). The
+ * instances are added to the scene graph as the parts of a single assembly, laid out on a grid that takes the space of
+ * the passed number of copies of the object across (see InstanceGrid.h).
+ */
+static void setInstanceCount(int count, float spread)
+{
+    std::vector<glm::mat4> grid;
+    BuildInstanceGrid(count, object.radius, spread, grid);
+
+    object.scene = SceneGraph();
+    object.node_instances.clear();
+    int root = AddSceneNode(object.scene, -1, glm::mat4(1.0f));
+    object.node_instances.push_back(-1);
+    for(int i = 0; i < count; i++)
+    {
+        AddSceneNode(object.scene, root, grid[i]);
+        object.node_instances.push_back(i);
+    }
+
+    object.instance_count = count;
+    object.instance_matrices.resize(count);
+    object.drawn_instance_count = count;
+    object.packets_built = false;
+
+    //the culled instances may have been streamed from somewhere else, which there needs to be room for
+    AttachInstanceBuffer(object.instances, object.instanced_vertex_array);
+    if(streaming_available)
+        ReserveStreamBuffer(stream_buffer, sizeof(glm::mat4) * count + 256 +
+                                           sizeof(DrawElementsIndirectCommand) * object.meshes.meshes.size() *
+                                           DRAW_PACKET_DEPTH_BUCKETS);
+
+    updateSceneInstances();
+
+    //the instanced programs read the model matrix of each instance, so the toggle is baked into them
+    if(count > 0)
+        render_state.toggles |= TOGGLE_INSTANCED;
+
+    else
+        render_state.toggles &= ~TOGGLE_INSTANCED;
+}
+
+/*
+ * Method to find the instances that are inside of the view frustum and not hidden behind others, and to fill the
+ * instance buffer with them.
+ * @param out_cull_ms: This will hold the time taken to cull the instances against the view frustum, in milliseconds
+ * @param out_occlusion_ms: This will hold the time taken to reject the hidden instances, in milliseconds
+ * @param out_occlusion: This will hold what the occlusion culling did. Passed by reference.
+ * @param out_packets_ms: This will hold the time taken to build the draws of the visible instances, in milliseconds
+ */
+static void cullInstances(double& out_cull_ms, double& out_occlusion_ms, OcclusionStats& out_occlusion,
+                          double& out_packets_ms)
+{
+    //the instances are culled in the space of the object, so the model matrix is part of the frustum
+    double start_time = GetTime();
+    glm::mat4 matrix = render_state.projection * GetTransformMatrix(render_state.view) *
+                       GetTransformMatrix(render_state.model);
+    int visible = object.instance_count;
+    if(culling)
+    {
+        Frustum frustum;
+        ExtractFrustumPlanes(matrix, frustum);
+        visible = CullInstances(frustum, object.instance_bounds, object.visible);
+    }
+
+    else
+    {
+        object.visible.resize(std::max((int)object.visible.size(), visible));
+        for(int i = 0; i < visible; i++)
+            object.visible[i] = i;
+    }
+
+    double occlusion_start_time = GetTime();
+    out_cull_ms = (occlusion_start_time - start_time) * 1000.0;
+
+    out_occlusion = OcclusionStats();
+    if(occlusion_culling)
+        visible = OcclusionCullInstances(matrix, object.occluder_triangles, object.instance_matrices,
+                                         object.instance_bounds, occlusion_budget_ms, object.visible, visible,
+                                         out_occlusion);
+
+    double packets_start_time = GetTime();
+    out_occlusion_ms = (packets_start_time - occlusion_start_time) * 1000.0;
+    object.drawn_instance_count = visible;
+
+    //the depth of the instances is measured along the view direction, from the nearest corner of the box around all of
+    //them to the farthest
+    glm::mat4 view_model = GetTransformMatrix(render_state.view) * GetTransformMatrix(render_state.model);
+    glm::vec4 depth_row = -glm::vec4(view_model[0][2], view_model[1][2], view_model[2][2], view_model[3][2]);
+    float near_depth = 0;
+    float far_depth = 0;
+    for(int corner = 0; corner < 8; corner++)
+    {
+        glm::vec4 point((corner & 1) ? object.scene_box_max.x : object.scene_box_min.x,
+                        (corner & 2) ? object.scene_box_max.y : object.scene_box_min.y,
+                        (corner & 4) ? object.scene_box_max.z : object.scene_box_min.z, 1.0f);
+        float depth = glm::dot(depth_row, point);
+        near_depth = corner > 0 ? std::min(near_depth, depth) : depth;
+        far_depth = corner > 0 ? std::max(far_depth, depth) : depth;
+    }
+
+    //the worker threads sort their own chunk of the visible instances from front to back and record the draws they
+    //need, and the draws are merged here. The draws can only be ordered by depth when they can start at any instance.
+    BuildDrawPackets(object.instance_matrices, object.visible, visible, depth_row, near_depth, far_depth,
+                     object.meshes.meshes.size(), object.packets);
+    MergeDrawPackets(object.packets, !(multi_draw && CanMultiDrawMeshPool()) && !CanBaseInstanceMeshPool());
+    object.packets_built = true;
+
+    //when streaming, the matrices are written straight into the mapped buffer, and the instance attributes are pointed
+    //at them
+    GLintptr offset;
+    glm::mat4* streamed = NULL;
+    if(streaming_frame)
+        streamed = (glm::mat4*)AllocateStreamBuffer(stream_buffer, sizeof(glm::mat4) * visible, sizeof(glm::mat4),
+                                                    offset);
+
+    if(streamed == NULL)
+        object.visible_matrices.resize(std::max(visible, 1));
+
+    //then they copy the matrices of their instances to where the merge put them
+    WriteDrawPacketInstances(object.packets, object.instance_matrices,
+                             streamed != NULL ? streamed : &object.visible_matrices.front());
+
+    if(streamed != NULL)
+        AttachInstanceMatrices(object.instanced_vertex_array, stream_buffer.buffer, offset);
+
+    else
+    {
+        object.visible_matrices.resize(visible);
+        UploadInstanceMatrices(object.instances, object.visible_matrices);
+    }
+
+    out_packets_ms = (GetTime() - packets_start_time) * 1000.0;
+}
+
+/*
+ * Method to set the state the object is drawn with: the z-buffer keeps only the elements that are closer, and since the
+ * object is opaque and its faces are not all wound the same way, there is no blending and no face culling. Only the
+ * state that changed since the last draw is sent to OpenGL (see GLStateCache.h).
+ */
+static void setObjectDrawState()
+{
+    SetDepthState(true, GL_LESS);
+    SetBlendState(false, GL_ONE, GL_ZERO);
+    SetCullState(false, GL_BACK);
+}
+
+/*
+ * Method to draw the loaded object (or all of its instances) with the currently used shader program. Only the state
+ * that changed since the last draw is sent to OpenGL (see GLStateCache.h).
+ */
+static void drawObject()
+{
+    //when every instance has been culled, there is nothing to draw
+    if(object.instance_count > 0 && object.drawn_instance_count == 0)
+        return;
+
+    BindVertexArrayCached(object.instance_count > 0 ? object.instanced_vertex_array : object.vertex_array);
+
+    //this configures the z-buffer so that only elements that are closer will be drawn
+    setObjectDrawState();
+
+    //every part of the object is drawn as triangles, in a single call or in one call each
+    StreamBuffer* stream = streaming_frame ? &stream_buffer : NULL;
+    if(object.instance_count > 0 && object.packets_built)
+        DrawMeshPoolPackets(object.meshes, object.packets.merged, true, multi_draw, stream);
+
+    else
+        DrawMeshPool(object.meshes, object.instance_count > 0 ? object.drawn_instance_count : 0, multi_draw, stream);
+}
+
+//the number of times the object is drawn when measuring the cost of a shader program
+const int COST_DRAW_COUNT = 10;
 
 /*
- * Method to reset the values of all the uniforms for the new program id when we switch shaders.
+ * This holds a measurement of a permutation against the uber-shader that has been sent to the GPU, but whose results
+ * may not be available yet. The results are read a few frames later so that the render thread never waits on them.
  */
-void setUniforms()
-{
-    //first we get handles for all of the matrix uniforms to use in our MVP matrix and we set their values
-    //according to the matrices defined in the main method
-    view_mat_ID = glGetUniformLocation(programID, "view_matrix");
-    model_mat_ID = glGetUniformLocation(programID, "model_matrix");
-    projection_mat_ID = glGetUniformLocation(programID, "projection_matrix");
-    glUniformMatrix4fv(view_mat_ID, 1, GL_FALSE, &View[0][0]);
-    glUniformMatrix4fv(model_mat_ID, 1, GL_FALSE, &Model[0][0]);
-    glUniformMatrix4fv(projection_mat_ID, 1, GL_FALSE, &Projection[0][0]);
-
-    //next we need to set up three uniforms, one for each color channel since we will be implementing controls
-    //to toggle each one on and off.
-    red_channel_id = glGetUniformLocation(programID, "red_channel");
-    glUniform1f(red_channel_id, 1.0f);
-    green_channel_id = glGetUniformLocation(programID, "green_channel");
-    glUniform1f(green_channel_id, 1.0f);
-    blue_channel_id = glGetUniformLocation(programID, "blue_channel");
-    glUniform1f(blue_channel_id, 1.0f);
-
-    //next is a uniform to turn on and off the light as a whole. (No light means no lighting model is used)
-    lightOn = glGetUniformLocation(programID, "light_on");
-    glUniform1i(lightOn, 1);
-
-    //this is the uniform that defines the position of the light
-    light_position = glGetUniformLocation(programID, "light_position");
-    glUniform3fv(light_position, 1, glm::value_ptr(glm::vec3(0, 20, 5)));
-
-    //this is uniform that defines the color of the light
-    light_color = glGetUniformLocation(programID, "light_color");
-    glUniform3fv(light_color, 1, glm::value_ptr(glm::vec3(0.8,0.8,0.8)));
-
-    //this is the view position of the camera. This is important for calculating the impact of the specular light
-    //component.
-    view_position = glGetUniformLocation(programID, "view_position");
-    glUniform3fv(view_position, 1, glm::value_ptr(glm::vec3(100,100,100)));
-
-    //we also need to set the flag to determine if the normal should be used as the color
-    normal_as_color = glGetUniformLocation(programID, "normal_as_color");
-    glUniform1i(normal_as_color, 0);
-
-    //we also need to set the flag to determine if the scene should be rendered in grayscale or not
-    //initially it will be set to not do it in grayscale.
-    gray_scale = glGetUniformLocation(programID, "gray_scale");
-    glUniform1i(gray_scale, 0);
+struct CostMeasurement
+{
+    GLboolean gouraud;
+    unsigned int toggles;
+    GLuint queries[2]; //the timer queries around the uber-shader draws and the permutation draws
+};
+
+std::vector<CostMeasurement> pending_measurements;
+std::set<std::pair<GLboolean, unsigned int> > measured_variants;
+
+/*
+ * Method to make the passed program the current one. Its uniforms are all marked as dirty, since none of them have
+ * been set for this program yet (or they were set to values that may have changed since).
+ */
+static void useProgram(GLuint program)
+{
+    programID = program;
+    UseProgramCached(programID);
+
+    //the handles for all of the uniforms were resolved (and their types checked) when the program was linked, so all
+    //we need is to fetch the ones for the current program
+    uniforms = GetProgramUniforms(programID);
+    render_state.dirty = DIRTY_ALL;
 }
 
+/*
+ * Method to draw the object a number of times with the passed program inside of a timer query. Nothing waits for the
+ * result of the query here.
+ * @return The number of OpenGL calls made to set up the state of the program
+ */
+static int timeProgram(GLuint program, GLuint query)
+{
+    useProgram(program);
+    int uniform_calls = FlushRenderState(render_state, uniforms);
+    AddIssuedGLCalls(uniform_calls);
+
+    glBeginQuery(GL_TIME_ELAPSED, query);
+    for(int i = 0; i < COST_DRAW_COUNT; i++)
+        drawObject();
+    glEndQuery(GL_TIME_ELAPSED);
+
+    return 1 + uniform_calls;
+}
+
+/*
+ * Method to print the results of the measurements whose timer queries are done. The average time of a single draw
+ * (in milliseconds) is reported for the permutation and for the uber-shader.
+ */
+static void reportVariantCosts()
+{
+    for(int i = 0; i < pending_measurements.size(); i++)
+    {
+        CostMeasurement& measurement = pending_measurements[i];
+
+        GLint available;
+        glGetQueryObjectiv(measurement.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if(!available)
+            continue;
+
+        GLuint64 uber_ns;
+        GLuint64 variant_ns;
+        glGetQueryObjectui64v(measurement.queries[0], GL_QUERY_RESULT, &uber_ns);
+        glGetQueryObjectui64v(measurement.queries[1], GL_QUERY_RESULT, &variant_ns);
+        glDeleteQueries(2, measurement.queries);
+
+        std::cout << (measurement.gouraud ? "Gouraud" : "Phong") << " permutation ["
+                  << DescribeToggles(measurement.toggles) << "]: " << variant_ns / 1.0e6 / COST_DRAW_COUNT
+                  << " ms per draw vs " << uber_ns / 1.0e6 / COST_DRAW_COUNT << " ms for the uber-shader" << std::endl;
+
+        pending_measurements.erase(pending_measurements.begin() + i);
+        i--;
+    }
+}
+
+/*
+ * Method to pick the shader program matching the current illumination model and toggles, and to make it the current
+ * one if it changed. While that program is still compiling, the fallback program is used. The first time a
+ * permutation is ready, its fragment cost is measured against the uber-shader for the same toggles.
+ * @return The number of OpenGL calls made to set up the state of the programs
+ */
+static int selectProgram()
+{
+    //this remembers which program is current, so that we only switch programs when needed
+    static GLuint applied_program = 0;
+    int calls = 0;
+
+    GLboolean gouraud_flag = render_state.gouraud;
+    unsigned int toggles = render_state.toggles;
+    GLboolean instanced = (toggles & TOGGLE_INSTANCED) != 0;
+
+    GLuint program = render_state.uber_shader ? GetUberShader(gouraud_flag, instanced) : GetShaderVariant(gouraud_flag, toggles);
+
+    //without a window nobody is watching, so rather than drawing with the fallback program we wait for the real one.
+    //This keeps the frames (and their timings) the same from one run to the next, which the benchmark needs as well.
+    while(program == 0 && (headless || benchmarking) && PendingShaderJobs() > 0)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        UpdateShaderVariants();
+        program = render_state.uber_shader ? GetUberShader(gouraud_flag, instanced) : GetShaderVariant(gouraud_flag, toggles);
+    }
+
+    if(program == 0)
+        program = GetFallbackShader(instanced);
+
+    std::pair<GLboolean, unsigned int> variant(gouraud_flag, toggles);
+    //the measurement draws the object a few more times, so it is left out of the benchmark
+    if(!render_state.uber_shader && !benchmarking && HasShaderVariant(gouraud_flag, toggles) &&
+       measured_variants.count(variant) == 0)
+    {
+        //we can only compare against the uber-shader once it is done compiling as well
+        GLuint uber_shader = GetUberShader(gouraud_flag, instanced);
+
+        if(uber_shader != 0)
+        {
+            CostMeasurement measurement;
+            measurement.gouraud = gouraud_flag;
+            measurement.toggles = toggles;
+            glGenQueries(2, measurement.queries);
+
+            calls += timeProgram(uber_shader, measurement.queries[0]);
+            calls += timeProgram(program, measurement.queries[1]);
+
+            //the draws above were only for the measurement, so they should not end up on screen
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            pending_measurements.push_back(measurement);
+            measured_variants.insert(variant);
+            applied_program = 0;
+        }
+    }
+
+    if(program != applied_program)
+    {
+        useProgram(program);
+        applied_program = program;
+        calls++;
+    }
+
+    return calls;
+}
+
+//when a recording is being replayed, these are its frames and the index of the next one to apply (see InputRecording.h)
+std::vector<InputFrame> replay_frames;
+int replay_frame = -1;
+
 /*
  * This is the method that will execute when there is input from the keyboard.
  * For this method to be a valid callback method for the keyboard, it must match the proper signature,
  * which is the one used for this method.
+ * The keys are turned into actions through the binding table (see ActionBindings.h), and the actions are applied once
+ * per frame by sampleInput.
  */
 void keyboard_callback(GLFWwindow* window, int key, int scancode, int action, int mode)
 {
@@ -96,95 +592,219 @@ void keyboard_callback(GLFWwindow* window, int key, int scancode, int action, in
         glfwSetWindowShouldClose(window, true);
     }
 
-    //here we define what occurs if specific keys are pressed
-    //the functions are defined in the keyboard controls file, we are simply calling them based on
-    //which key is pressed
-    if(glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
-        key_press_w(window, View, Projection, Model, programID);
+    //while a recording is being replayed, the keyboard is ignored so that the replay stays the same as the recording
+    //(the frames are only ever loaded before the first frame, so this can be checked from any thread)
+    if(replay_frames.empty())
+        HandleKeyEvent(key, action);
+}
 
-    if(glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
-        key_press_s(window, View, Projection, Model, programID);
+/*
+ * This is the method that will execute when the contents of the window need to be drawn again (i.e. after it was
+ * uncovered or resized), which in on-demand mode is the only time a frame is drawn without anything changing.
+ */
+void refresh_callback(GLFWwindow* window)
+{
+    redraw_requested = true;
+}
 
-    if(glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
-        key_press_a(window, View, Projection, Model, programID);
+//the longest time step the controls are integrated over, so that a long stall (i.e. dragging the window) does not
+//make the camera jump
+const float MAX_INPUT_DT = 0.1f;
 
-    if(glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
-        key_press_d(window, View, Projection, Model, programID);
+/*
+ * Method to gather the actions taken since the input was last sampled, from the keyboard and the mouse, and record
+ * them if a recording is going on. This has to be called on the main thread, which owns the window.
+ * @param window: The window, or nullptr without one
+ * @param dt: How long it has been since the input was last sampled, in seconds
+ * @param out_frame: This will hold the actions. Passed by reference.
+ */
+static void takeInput(GLFWwindow* window, float dt, InputFrame& out_frame)
+{
+    //we need to keep the old position of the mouse cursor so we can check which direction the user is moving the
+    //mouse in.
+    static double oldMouseY = 0;
 
-    if(glfwGetKey(window, GLFW_KEY_O) == GLFW_PRESS)
-        key_press_o(window, View, Projection, Model, programID);
+    //before dealing with the mouse input, we need to get the current position of the mouse and compare it to
+    //the old. Since we don't care about x, we can just pass 0.
+    double newMouseY = 0;
+    unsigned int mouse_held = 0;
+    if(window != nullptr)
+        glfwGetCursorPos(window, 0, &newMouseY);
 
-    if(glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS)
-        key_press_p(window, View, Projection, Model, programID);
+    if(window != nullptr && glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS && newMouseY > oldMouseY)
+        mouse_held |= 1u << ACTION_ZOOM_OUT;
 
-    if(glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS)
-        key_press_left_arrow(window, View, Projection, Model, programID);
+    if(window != nullptr && glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS && newMouseY < oldMouseY)
+        mouse_held |= 1u << ACTION_ZOOM_IN;
 
-    if(glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS)
-        key_press_right_arrow(window, View, Projection, Model, programID);
+    //update the last position of the mouse
+    oldMouseY = newMouseY;
 
-    if(glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS)
-        key_press_up_arrow(window, View, Projection, Model, programID);
+    TakeInputFrame(out_frame, std::min(dt, MAX_INPUT_DT), mouse_held);
+    RecordInputFrame(out_frame);
+}
 
-    if(glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS)
-        key_press_down_arrow(window, View, Projection, Model, programID);
+/*
+ * Method to gather the actions for this frame (from the keyboard and the mouse, or from the recording being replayed)
+ * and apply them to the render state. This is called once per frame, right before rendering, and moves things
+ * according to how long it has been since the last frame.
+ */
+static void sampleInput(GLFWwindow* window, float dt)
+{
+    InputFrame frame;
 
-    if(glfwGetKey(window, GLFW_KEY_B) == GLFW_PRESS)
-        key_press_b(window, View, Projection, Model, programID);
+    if(replay_frame >= 0)
+    {
+        frame = replay_frames[replay_frame];
+        replay_frame++;
+    }
 
-    if(glfwGetKey(window, GLFW_KEY_N) == GLFW_PRESS)
-        key_press_n(window, View, Projection, Model, programID);
+    else
+        takeInput(window, dt, frame);
 
-    if(glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS)
-        key_press_e(window, View, Projection, Model, programID);
+    ApplyInputFrame(window, render_state, frame);
+}
 
-    if(glfwGetKey(window, GLFW_KEY_J) == GLFW_PRESS)
-        key_press_j(window, View, Projection, Model, programID);
+//how often the main thread samples the input when the frames are rendered on a thread of their own (as well as
+//whenever an event comes in), in seconds
+const double INPUT_SAMPLE_INTERVAL = 0.002;
 
-    if(glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS)
-        key_press_l(window, View, Projection, Model, programID);
+/*
+ * This is the input sampled on the main thread, and the time it was sampled at.
+ */
+struct QueuedInput
+{
+    InputFrame frame;
+    double sample_time;
+};
 
-    if(glfwGetKey(window, GLFW_KEY_I) == GLFW_PRESS)
-        key_press_i(window, View, Projection, Model, programID);
+/*
+ * This is a title for the window, which can only be set on the main thread.
+ */
+struct WindowTitle
+{
+    char text[512];
+};
 
-    if(glfwGetKey(window, GLFW_KEY_K) == GLFW_PRESS)
-        key_press_k(window, View, Projection, Model, programID);
+//the input sampled on the main thread, which the render thread applies before each frame, and the titles the render
+//thread wants the window to show (see SpscQueue.h). When the input queue is full, the main thread stops sampling until
+//there is room again, and the actions (and the time step) carry over to the next time it samples.
+SpscQueue<QueuedInput, 64> input_queue;
+SpscQueue<WindowTitle, 4> title_queue;
 
-    if(glfwGetKey(window, GLFW_KEY_PAGE_UP) == GLFW_PRESS)
-        key_press_pg_up(window, View, Projection, Model, programID);
+/*
+ * Method to apply the input the main thread has sampled since the last frame, in the order it was sampled, when the
+ * frames are rendered on a thread of their own.
+ * @param window: The window, or nullptr without one
+ * @return The time the oldest of that input was sampled at (or the newest input applied before it, if there was
+ * none), which is how long the input of this frame has waited to be shown
+ */
+static double applyQueuedInput(GLFWwindow* window)
+{
+    static double last_sample_time = GetTime();
 
-    if(glfwGetKey(window, GLFW_KEY_PAGE_DOWN) == GLFW_PRESS)
-        key_press_pg_down(window, View, Projection, Model, programID);
+    double oldest_sample_time = -1;
+    QueuedInput input;
+    while(PopSpscQueue(input_queue, input))
+    {
+        ApplyInputFrame(window, render_state, input.frame);
+        if(oldest_sample_time < 0)
+            oldest_sample_time = input.sample_time;
 
-    //controls what occurs when the '1' key is pressed
-    if(glfwGetKey(window, GLFW_KEY_1) == GLFW_PRESS)
-        key_press_1(programID);
+        last_sample_time = input.sample_time;
+    }
 
-    //controls what happens when the '2' key is pressed
-    if(glfwGetKey(window, GLFW_KEY_2) == GLFW_PRESS)
-        key_press_2(programID);
+    return oldest_sample_time >= 0 ? oldest_sample_time : last_sample_time;
+}
 
-    //controls what happens when the '3' key is pressed
-    if(glfwGetKey(window, GLFW_KEY_3) == GLFW_PRESS)
-        key_press_3(programID);
+//how long the on-demand mode waits for an event before it checks the shader files (and updates the title) again, in
+//seconds
+const double ON_DEMAND_WAIT_INTERVAL = 0.1;
 
-    if(glfwGetKey(window, GLFW_KEY_4) == GLFW_PRESS)
-        key_press_4(programID);
+/*
+ * Method to check if a frame needs to be drawn in on-demand mode: when there is input to apply (including a key or the
+ * mouse button being held down, which keeps things moving), a shader file changed or a program is still compiling or
+ * being measured, the state of the scene changed, or the window asked to be drawn again. The benchmark and the replay
+ * need every frame.
+ */
+static bool frameNeeded(GLFWwindow* window)
+{
+    if(benchmarking || replay_frame >= 0 || redraw_requested || render_state.dirty != 0)
+        return true;
 
-    if(glfwGetKey(window, GLFW_KEY_6) == GLFW_PRESS)
-        key_press_6(programID);
+    if(HasPendingInput() || HasShaderChanges() || PendingShaderJobs() > 0 || !pending_measurements.empty())
+        return true;
 
-    if(glfwGetKey(window, GLFW_KEY_5) == GLFW_PRESS)
+    return window != nullptr && glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+}
+
+/*
+ * Method to show the passed text as the title of the window (or to print it, without a window). The title of the
+ * window can only be set on the main thread, so it is handed over when rendering on a thread of its own.
+ */
+static void showTitle(GLFWwindow* window, const char* title)
+{
+    WindowTitle window_title;
+    if(window != nullptr && render_thread)
     {
-        key_press_5(programID, gouraud_flag);
-        setUniforms();
+        strncpy(window_title.text, title, sizeof(window_title.text) - 1);
+        window_title.text[sizeof(window_title.text) - 1] = 0;
+        PushSpscQueue(title_queue, window_title);
     }
 
-    if(glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS)
-        key_press_m(programID);
+    else if(window != nullptr)
+        glfwSetWindowTitle(window, title);
+
+    else
+        std::cout << title << std::endl;
+}
+
+//the number of frames the input latency percentiles are computed over
+const int INPUT_LATENCY_SAMPLES = 600;
 
-    if(glfwGetKey(window, GLFW_KEY_G) == GLFW_PRESS)
-        key_press_g(programID);
+//the GPU timestamps written every frame: before the clear, after the clear, before the scene is drawn (once the CPU is
+//done culling), around the passes of the culling on the GPU (which are written right after the start of the scene when
+//it is off), after the scene has been drawn and after it has been upscaled (which is written right after the scene
+//without dynamic resolution)
+enum FrameTimestamp
+{
+    TIMESTAMP_FRAME_START,
+    TIMESTAMP_CLEAR_END,
+    TIMESTAMP_SCENE_START,
+    TIMESTAMP_FIRST_CULL_END,
+    TIMESTAMP_FIRST_DRAW_END,
+    TIMESTAMP_SECOND_CULL_END,
+    TIMESTAMP_SCENE_END,
+    TIMESTAMP_UPSCALE_END,
+    TIMESTAMP_COUNT
+};
+
+/*
+ * Method to draw the instances of the loaded object that the GPU finds visible (see GpuCulling.h). The instances that
+ * were visible last frame are drawn first, and their depth is then used to find the ones that have come into view.
+ * @param framebuffer: The framebuffer being drawn into (0 for the window)
+ * @param width: The size of the part of it being drawn into, in pixels
+ * @param height: The size of the part of it being drawn into, in pixels
+ */
+static void drawGpuCulledObject(GLuint framebuffer, int width, int height)
+{
+    glm::mat4 matrix = render_state.projection * GetTransformMatrix(render_state.view) *
+                       GetTransformMatrix(render_state.model);
+    CullInstancesOnGpu(matrix);
+    WriteGpuTimestamp(TIMESTAMP_FIRST_CULL_END);
+
+    //the compute shaders have their own programs, so the one we draw with has to be made current again
+    UseProgramCached(programID);
+    BindVertexArrayCached(object.instanced_vertex_array);
+    setObjectDrawState();
+    DrawGpuCulledInstances(0, multi_draw);
+    WriteGpuTimestamp(TIMESTAMP_FIRST_DRAW_END);
+
+    RetestInstancesOnGpu(matrix, framebuffer, width, height);
+    WriteGpuTimestamp(TIMESTAMP_SECOND_CULL_END);
+
+    UseProgramCached(programID);
+    DrawGpuCulledInstances(1, multi_draw);
 }
 
 /*
@@ -211,10 +831,26 @@ static GLFWwindow* initialize()
     // Make the window's context current
     glfwMakeContextCurrent(window);
 
-    //we should also set the keyboard input callback method
+    //we should also set the keyboard input callback method, and bind the keys to their actions
     glfwSetKeyCallback(window, keyboard_callback);
+    glfwSetWindowRefreshCallback(window, refresh_callback);
+    BindDefaultKeys();
     glfwWindowHint(GLFW_DOUBLEBUFFER, 1);
 
+    //the benchmark should measure how fast we can render, not the refresh rate of the display
+    if(benchmarking)
+        swap_mode = SWAP_UNCAPPED;
+
+    //adaptive vsync needs an extension, without which we wait for every refresh
+    if(swap_mode == SWAP_ADAPTIVE && !glfwExtensionSupported("WGL_EXT_swap_control_tear") &&
+       !glfwExtensionSupported("GLX_EXT_swap_control_tear"))
+    {
+        std::cout << "Adaptive vsync is not supported, waiting for every refresh instead" << std::endl;
+        swap_mode = SWAP_VSYNC;
+    }
+
+    glfwSwapInterval(swap_mode == SWAP_VSYNC ? 1 : (swap_mode == SWAP_ADAPTIVE ? -1 : 0));
+
     glewExperimental = GL_TRUE;
 
     if (GLEW_OK != glewInit())
@@ -223,134 +859,1153 @@ static GLFWwindow* initialize()
         return nullptr;
     }
 
+    //the shader programs are compiled in the background, either by the driver or by a worker thread
+    InitShaderCompiler(window);
+
     return window;
 }
 
-int main()
+//the size of the framebuffer that is rendered into when there is no window (the same as the window)
+const int HEADLESS_WIDTH = 800;
+const int HEADLESS_HEIGHT = 800;
+
+/*
+ * Method to set up rendering without a window (see HeadlessContext.h). Everything is rendered into a framebuffer of the
+ * passed size.
+ */
+static bool initializeHeadless(int width, int height)
 {
-    std::cout << glfwGetVersionString() << std::endl;
-    GLFWwindow* window = initialize();
+    if(!CreateHeadlessContext())
+        return false;
 
-    if(window == nullptr)
+    glewExperimental = GL_TRUE;
+
+    //without a window system GLEW can not load the GLX extensions, but it still loads everything we need from OpenGL
+    GLenum glew_status = glewInit();
+    if(glew_status != GLEW_OK && glew_status != GLEW_ERROR_NO_GLX_DISPLAY)
     {
-        std::cout << "ERROR -- Initialization failed." << std::endl;
+        std::cout << "Failed to initialize GLEW" << std::endl;
+        return false;
+    }
+
+    if(!CreateFramebuffer(headless_framebuffer, width, height))
+        return false;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, headless_framebuffer.framebuffer);
+    glViewport(0, 0, width, height);
+
+    //there is no window to share a context with, so the shaders are compiled by the driver or on this thread
+    InitShaderCompiler(nullptr);
+
+    return true;
+}
+
+/*
+ * Method to make the OpenGL context (of the window, or the one without a window) current on the calling thread, or to
+ * release it so that another thread can make it current.
+ */
+static void makeContextCurrent(GLFWwindow* window, bool current)
+{
+    if(headless)
+        MakeHeadlessContextCurrent(current);
+
+    else
+        glfwMakeContextCurrent(current ? window : NULL);
+}
+
+/*
+ * Method to render the frames on a thread of their own, which takes the OpenGL context over until they are done. This
+ * thread is left with the window: it waits for the events, samples the input every INPUT_SAMPLE_INTERVAL (or as soon
+ * as an event comes in) and hands it over to the render thread, so that a slow frame or swap never holds up the input,
+ * and sets the title of the window whenever the render thread has a new one. Without a window, the input is still
+ * sampled (there just is none), so that the frames go through the same handoff.
+ * @param window: The window, or nullptr without one
+ * @param render_frames: The loop that renders the frames, which returns once the last one is done
+ * @return What render_frames returned
+ */
+static int runRenderThread(GLFWwindow* window, const std::function<int()>& render_frames)
+{
+    std::atomic<bool> render_done(false);
+    int status = 0;
+
+    makeContextCurrent(window, false);
+    std::thread thread([&]()
+    {
+        makeContextCurrent(window, true);
+        status = render_frames();
+        makeContextCurrent(window, false);
+
+        //wake this thread up, in case it is waiting for events
+        render_done.store(true);
+        if(window != nullptr)
+            glfwPostEmptyEvent();
+    });
+
+    //the replay and the benchmark drive the frames themselves, on the render thread
+    bool sampling = replay_frames.empty() && !benchmarking;
+    double last_sample_time = GetTime();
+    while(!render_done.load())
+    {
+        if(window != nullptr)
+            glfwWaitEventsTimeout(INPUT_SAMPLE_INTERVAL);
+
+        else
+            std::this_thread::sleep_for(std::chrono::microseconds((int)(INPUT_SAMPLE_INTERVAL * 1000000)));
+
+        double sample_time = GetTime();
+        if(sampling && !IsSpscQueueFull(input_queue))
+        {
+            QueuedInput input;
+            takeInput(window, (float)(sample_time - last_sample_time), input.frame);
+            input.sample_time = sample_time;
+            PushSpscQueue(input_queue, input);
+            last_sample_time = sample_time;
+        }
+
+        WindowTitle title;
+        while(PopSpscQueue(title_queue, title))
+        {
+            if(window != nullptr)
+                glfwSetWindowTitle(window, title.text);
+        }
+    }
+
+    thread.join();
+    makeContextCurrent(window, true);
+
+    //the input sampled after the last frame has been recorded as well, so it is applied to keep the final state the
+    //same as the one a replay of the recording ends up in
+    applyQueuedInput(window);
+    return status;
+}
+
+/*
+ * Method to load the mesh of a benchmark run, and to set up its instances, illumination model and toggles.
+ * @return A boolean specifying if the mesh could be loaded or not.
+ */
+static bool startBenchmarkRun(const BenchmarkRun& run)
+{
+    //the threads wait for work between frames, so they can be started again between runs
+    if(run.threads > 0 && run.threads != GetParallelForThreads())
+    {
+        StopParallelFor();
+        StartParallelFor(run.threads);
+    }
+
+    mesh_parts = run.parts;
+    if(!loadMesh(run.mesh_path.c_str()))
+        return false;
+
+    render_state.gouraud = run.gouraud;
+    render_state.uber_shader = run.uber_shader;
+    render_state.toggles = run.toggles;
+    render_state.dirty |= DIRTY_TOGGLES;
+    culling = run.culling;
+    occlusion_culling = run.occlusion;
+    multi_draw = run.multi_draw;
+    streaming = run.streaming;
+    gpu_culling = run.gpu_culling && gpu_culling_available;
+    occlusion_budget_ms = run.occlusion_budget_ms;
+    setInstanceCount(run.instances, run.spread);
+
+    return true;
+}
+
+/*
+ * Method to get the number of triangles of the scene (for all of the instances, whether they are culled or not).
+ */
+static long long getTriangleCount()
+{
+    return (long long)object.meshes.index_count / 3 * std::max(object.instance_count, 1);
+}
+
+/*
+ * Method to get the number of triangles drawn this frame (for the instances that were not culled).
+ */
+static long long getDrawnTriangleCount()
+{
+    return (long long)object.meshes.index_count / 3 * (object.instance_count > 0 ? object.drawn_instance_count : 1);
+}
+
+/*
+ * Method to print how the program can be run.
+ */
+static void printUsage(const char* program)
+{
+    std::cout << "Usage: " << program << " [--record file | --replay file] [--headless] [--frames count] [--dump prefix]"
+              << " [--stats file] [--instances count] [--spread copies] [--no-cull] [--threads count]"
+              << " [--occlusion] [--occlusion-budget ms] [--occluder file] [--gpu-cull] [--parts count]"
+              << " [--no-multi-draw] [--no-stream] [--render-thread] [--swap-interval mode] [--fps rate]"
+              << " [--dynamic-resolution ms] [--on-demand]"
+              << " [--benchmark run]... [--results file]" << std::endl;
+    std::cout << "  --record file: records the input of each frame to the file" << std::endl;
+    std::cout << "  --replay file: replays a recorded input, frame by frame, and reports the frame times" << std::endl;
+    std::cout << "  --headless: renders into a framebuffer without a window (for machines without a display)" << std::endl;
+    std::cout << "  --frames count: stops after rendering this many frames (300 by default with --headless)" << std::endl;
+    std::cout << "  --dump prefix: saves each frame as prefix00000.ppm, prefix00001.ppm, ... (with --headless)"
+              << std::endl;
+    std::cout << "  --stats file: saves the percentiles of the CPU and GPU frame timings on exit (.json or .csv)"
+              << std::endl;
+    std::cout << "  --instances count: draws this many copies of the object, in a single instanced draw call" << std::endl;
+    std::cout << "  --spread copies: lays the instances out over this many copies of the object across (1 by default)"
+              << std::endl;
+    std::cout << "  --no-cull: draws every instance instead of only the ones inside of the view frustum" << std::endl;
+    std::cout << "  --threads count: the number of threads the instances are culled and their draws built on (one per "
+              << "hardware thread by default)" << std::endl;
+    std::cout << "  --occlusion: leaves out the instances that are hidden behind the nearest ones as well" << std::endl;
+    std::cout << "  --occlusion-budget ms: the time the occlusion culling may take per frame (1 ms by default)"
+              << std::endl;
+    std::cout << "  --occluder file: a simpler mesh to draw the occluders with, which must fit inside of the object"
+              << std::endl;
+    std::cout << "  --gpu-cull: culls the instances against the view frustum and the depth of the last frame on the GPU "
+              << "instead (needs OpenGL 4.3)" << std::endl;
+    std::cout << "  --parts count: splits the object into this many meshes, which are all drawn at once (1 by default)"
+              << std::endl;
+    std::cout << "  --no-multi-draw: draws each of the meshes with its own draw call, instead of all of them in one"
+              << std::endl;
+    std::cout << "  --no-stream: uploads the instances and the draw commands every frame, instead of writing them into "
+              << "a persistently mapped buffer" << std::endl;
+    std::cout << "  --render-thread: renders on a thread of its own, while the main thread polls the window and "
+              << "samples the input" << std::endl;
+    std::cout << "  --swap-interval mode: vsync (the default), adaptive (vsync unless the frame is late) or off"
+              << std::endl;
+    std::cout << "  --fps rate: holds the frames to this many per second, and counts the ones that are late"
+              << std::endl;
+    std::cout << "  --dynamic-resolution ms: lowers the resolution the scene is drawn at while the GPU takes longer "
+              << "than this per frame, and upscales it" << std::endl;
+    std::cout << "  --on-demand: only draws a frame when the input, the shaders or the scene change, and waits for "
+              << "events otherwise" << std::endl;
+    std::cout << "  --benchmark run: renders a scripted camera path, i.e. mesh=../ObjectFiles/cube.obj,shading=gouraud,"
+              << "toggles=rgb+light,frames=500 (see BenchmarkRuns.h). Can be given several times." << std::endl;
+    std::cout << "  --results file: where the benchmark results are saved (benchmark.csv by default)" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    //the input can be recorded to a file, or a recorded input can be replayed (which turns the session into a
+    //repeatable benchmark)
+    const char* record_path = NULL;
+    const char* replay_path = NULL;
+
+    //the viewer can also render without a window, for a number of frames, saving each of them if asked to
+    int frame_limit = 0;
+    const char* dump_prefix = NULL;
+
+    //the CPU and GPU timings of the frames are always printed on exit, and saved to this file if there is one
+    const char* stats_path = NULL;
+
+    //the benchmark runs, one after the other, and the file their results are saved to
+    std::vector<BenchmarkRun> benchmark_runs;
+    const char* results_path = "benchmark.csv";
+
+    //the number of copies of the object that are drawn, as instances (0 to draw it once without instancing), and how
+    //many copies of the object the grid they are laid out on spans
+    int instance_count = 0;
+    float instance_spread = 1;
+
+    //the number of threads the instances are culled on (0 for one per hardware thread)
+    int thread_count = 0;
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+            record_path = argv[++i];
+
+        else if(strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+            replay_path = argv[++i];
+
+        else if(strcmp(argv[i], "--headless") == 0)
+            headless = true;
+
+        else if(strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            frame_limit = atoi(argv[++i]);
+
+        else if(strcmp(argv[i], "--dump") == 0 && i + 1 < argc)
+            dump_prefix = argv[++i];
+
+        else if(strcmp(argv[i], "--stats") == 0 && i + 1 < argc)
+            stats_path = argv[++i];
+
+        else if(strcmp(argv[i], "--instances") == 0 && i + 1 < argc)
+            instance_count = std::max(atoi(argv[++i]), 0);
+
+        else if(strcmp(argv[i], "--spread") == 0 && i + 1 < argc)
+            instance_spread = std::max((float)atof(argv[++i]), 0.01f);
+
+        else if(strcmp(argv[i], "--no-cull") == 0)
+            culling = false;
+
+        else if(strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            thread_count = atoi(argv[++i]);
+
+        else if(strcmp(argv[i], "--occlusion") == 0)
+            occlusion_culling = true;
+
+        else if(strcmp(argv[i], "--occlusion-budget") == 0 && i + 1 < argc)
+            occlusion_budget_ms = std::max(atof(argv[++i]), 0.0);
+
+        else if(strcmp(argv[i], "--occluder") == 0 && i + 1 < argc)
+            occluder_path = argv[++i];
+
+        else if(strcmp(argv[i], "--gpu-cull") == 0)
+            gpu_culling = true;
+
+        else if(strcmp(argv[i], "--parts") == 0 && i + 1 < argc)
+            mesh_parts = std::max(atoi(argv[++i]), 1);
+
+        else if(strcmp(argv[i], "--no-multi-draw") == 0)
+            multi_draw = false;
+
+        else if(strcmp(argv[i], "--no-stream") == 0)
+            streaming = false;
+
+        else if(strcmp(argv[i], "--render-thread") == 0)
+            render_thread = true;
+
+        else if(strcmp(argv[i], "--swap-interval") == 0 && i + 1 < argc)
+        {
+            const char* mode = argv[++i];
+            if(strcmp(mode, "vsync") == 0)
+                swap_mode = SWAP_VSYNC;
+
+            else if(strcmp(mode, "adaptive") == 0)
+                swap_mode = SWAP_ADAPTIVE;
+
+            else if(strcmp(mode, "off") == 0)
+                swap_mode = SWAP_UNCAPPED;
+
+            else
+            {
+                printUsage(argv[0]);
+                return -1;
+            }
+        }
+
+        else if(strcmp(argv[i], "--fps") == 0 && i + 1 < argc)
+            frame_rate_limit = std::max(atof(argv[++i]), 0.0);
+
+        else if(strcmp(argv[i], "--dynamic-resolution") == 0 && i + 1 < argc)
+            resolution_target_ms = std::max(atof(argv[++i]), 0.0);
+
+        else if(strcmp(argv[i], "--on-demand") == 0)
+            on_demand = true;
+
+        else if(strcmp(argv[i], "--benchmark") == 0 && i + 1 < argc)
+        {
+            if(!ParseBenchmarkRuns(argv[++i], benchmark_runs))
+                return -1;
+
+            benchmarking = true;
+        }
+
+        else if(strcmp(argv[i], "--results") == 0 && i + 1 < argc)
+            results_path = argv[++i];
+
+        else
+        {
+            printUsage(argv[0]);
+            return -1;
+        }
+    }
+
+    //the occluders can be drawn with a simpler mesh than the object, which only needs to be loaded once
+    if(occluder_path != NULL)
+    {
+        std::vector<glm::vec3> normals;
+        std::vector<glm::vec2> uvs;
+        if(!LoadOBJ(occluder_path, object.occluder_triangles, normals, uvs))
+            return -1;
+    }
+
+    if(dump_prefix != NULL && !headless)
+    {
+        std::cout << "Frames can only be saved with --headless" << std::endl;
         return -1;
     }
 
-    //we need to load the data for the object that we would like to draw from an object file
-    //we can do this using the method that we have defined
-    std::vector<glm::vec3> vertices, normals;
-    std::vector<glm::vec2> uvs;
-    //we try to load the object file and if we fail, then we simply exit the program since we won't be able to draw anything
-    if(!LoadOBJ("../ObjectFiles/heracles.obj", vertices, normals, uvs))
+    if(benchmarking && (replay_path != NULL || record_path != NULL))
+    {
+        std::cout << "The benchmark can not be combined with recording or replaying the input" << std::endl;
+        return -1;
+    }
+
+    if(on_demand && render_thread)
+    {
+        std::cout << "The on-demand mode waits for the events on the thread that renders, so it can not be combined "
+                  << "with --render-thread" << std::endl;
+        return -1;
+    }
+
+    //without a window, we stop after a fixed number of frames (or at the end of the replay or of the benchmark)
+    if(headless && frame_limit == 0 && replay_path == NULL && !benchmarking)
+        frame_limit = 300;
+
+    GLFWwindow* window = nullptr;
+
+    if(headless)
+    {
+        if(!initializeHeadless(HEADLESS_WIDTH, HEADLESS_HEIGHT))
+        {
+            std::cout << "ERROR -- Initialization failed." << std::endl;
+            return -1;
+        }
+    }
+
+    else
+    {
+        std::cout << glfwGetVersionString() << std::endl;
+        window = initialize();
+    }
+
+    if(window == nullptr && !headless)
+    {
+        std::cout << "ERROR -- Initialization failed." << std::endl;
         return -1;
+    }
+
+    //from here on, the state that is set every frame goes through the cache, which starts out knowing nothing
+    ResetGLStateCache();
 
-    //We will try to create a cube by using a vertex array object
-    GLuint VertexArrayID; //this is our reference to our vao
-    glGenVertexArrays(1, &VertexArrayID); //this will generate the actual array for us and we want only one
-    glBindVertexArray(VertexArrayID); //then we make it the current one (pass to GPU)
+    //We will try to create a cube by using a vertex array object (and a second one to draw it as instances)
+    glGenVertexArrays(1, &object.vertex_array); //this will generate the actual array for us and we want only one
+    glGenVertexArrays(1, &object.instanced_vertex_array);
 
     //Now in order for openGL to be able to draw this triangle we need to pass it then data by creating a vertex buffer
-    //object
-    GLuint vertexBuffer;
-    glGenBuffers(1, &vertexBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3)*vertices.size(), &vertices.front(), GL_STATIC_DRAW);
-
-    //for the lighting, we also need the normals, therefore we should create another vbo
-    GLuint normalBuffer;
-    glGenBuffers(1, &normalBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, normalBuffer);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3)*normals.size(), &normals.front(), GL_STATIC_DRAW);
+    //object, and for the lighting, we also need the normals, therefore we should create another vbo. These (and the
+    //indices) are shared by every part of the object (see MeshPool.h). The model matrices of the instances get a
+    //buffer of their own.
+    CreateMeshPool(object.meshes);
+    CreateInstanceBuffer(object.instances);
+
+    AttachMeshPool(object.meshes, object.vertex_array);
+    AttachMeshPool(object.meshes, object.instanced_vertex_array);
+    AttachInstanceBuffer(object.instances, object.instanced_vertex_array);
+
+    if(!CanMultiDrawMeshPool())
+        std::cout << "Drawing all of the meshes in one call needs OpenGL 4.3, so each of them gets its own draw call"
+                  << std::endl;
+
+    //the stream buffer grows with the number of instances (see setInstanceCount)
+    streaming_available = CanStreamBuffer();
+    if(streaming_available)
+        CreateStreamBuffer(stream_buffer, 1 << 16);
+
+    else
+        std::cout << "Mapping a buffer persistently needs OpenGL 4.4, so the instances are uploaded every frame instead"
+                  << std::endl;
+
+    //the compute shaders for culling on the GPU are only built if it was asked for (by any of the benchmark runs)
+    bool gpu_culling_requested = gpu_culling;
+    for(int i = 0; i < benchmark_runs.size(); i++)
+        gpu_culling_requested = gpu_culling_requested || benchmark_runs[i].gpu_culling;
+
+    if(gpu_culling_requested)
+    {
+        gpu_culling_available = InitGpuCulling();
+        gpu_culling = gpu_culling && gpu_culling_available;
+        if(!gpu_culling_available)
+            std::cout << "The instances are culled on the CPU instead" << std::endl;
+    }
+
+    //the instances are culled (and their draws built) on a few threads, which wait for work between frames (see
+    //ParallelFor.h). A benchmark run may ask for another number of threads.
+    StartParallelFor(thread_count);
+    std::cout << "Culling instances with " << GetFrustumCullingSimd() << " on " << GetParallelForThreads()
+              << " threads" << std::endl;
+
+    //we need to load the data for the object that we would like to draw from an object file (when benchmarking, this
+    //is done for each run)
+    //we try to load the object file and if we fail, then we simply exit the program since we won't be able to draw anything
+    if(benchmarking)
+    {
+        if(!startBenchmarkRun(benchmark_runs[0]))
+            return -1;
+    }
+
+    else
+    {
+        if(!loadMesh("../ObjectFiles/heracles.obj"))
+            return -1;
+
+        setInstanceCount(instance_count, instance_spread);
+    }
 
     //now we load the shader program and assign it tour our program id
-    //initially, we use the Phong illumination model
-    gouraud_flag = GL_FALSE;
-    programID = LoadShaders("../Shaders/PhongVertexShader.glsl", "../Shaders/PhongFragmentShader.glsl");
-    glUseProgram(programID);
+    //initially, we use the specialized permutation of the Phong illumination model for the default toggles. Until
+    //that one is done compiling (see selectProgram), we draw with the fallback program.
+    useProgram(GetFallbackShader((render_state.toggles & TOGGLE_INSTANCED) != 0));
 
     //in order for this object to be viewed from a perspective view, we need a Model View Projection matrix
     //we wish to draw the triangle from a perspective view
     //this is the projection matrix for a perspective view
-    int width; //the width of the window
-    int height; //the height of the window
-    glfwGetWindowSize(window, &width, &height);
+    int width = HEADLESS_WIDTH; //the width of the window
+    int height = HEADLESS_HEIGHT; //the height of the window
+    if(window != nullptr)
+        glfwGetWindowSize(window, &width, &height);
 
     //this creates an perspective projection matrix which we will use to render our object
-    Projection = glm::perspective(glm::radians(45.0f), (float)width/height, 0.1f, 200.0f);
-    //we then need a camera matrix, we will make it look at the origin
-    View = glm::lookAt(glm::vec3(0,0,-40),glm::vec3(0,0,0), glm::vec3(0, 1, 0));
+    render_state.projection = glm::perspective(glm::radians(45.0f), (float)width/height, 0.1f, 200.0f);
+    //we then need a camera matrix, we will make it look at the origin (it is kept as a position and an orientation, see
+    //Transform.h)
+    SetTransformMatrix(render_state.view, glm::lookAt(glm::vec3(0,0,-40),glm::vec3(0,0,0), glm::vec3(0, 1, 0)));
 
     //this is the model matrix (the identity matrix since we are placing the mode (our triangle) at the origin.
     //also changing this will modify what the final triangle looks like. This is where we apply transformations
     //such as scaling, translation, etc.
-    Model = glm::mat4(1.0f);
+    render_state.model = Transform();
+
+    //to show that compiling shaders never stalls a frame, we keep track of the frame times while compiles are pending
+    double last_frame_time = GetTime();
+    int compile_frames = 0;
+    double compile_frame_total_ms = 0;
+    double compile_frame_max_ms = 0;
+
+    //the shader directory is watched so that edited shaders are reloaded while we are running. This is the time the
+    //first file of the current reload changed (or -1 if there is no reload going on), so we can report how long it
+    //took for the reloaded shaders to show up on screen.
+    StartShaderWatcher("../Shaders/");
+    double reload_start_time = -1;
+    bool reload_visible = false;
+
+    //once a second, the frame rate, the number of OpenGL calls made per frame to update the state of the programs
+    //(uniforms and program switches) and the input latency are shown in the title of the window
+    double stats_start_time = GetTime();
+    int stats_frames = 0;
+    int stats_state_calls = 0;
+    int stats_gl_issued = 0;
+    int stats_gl_skipped = 0;
+    int stats_draw_calls = 0;
+    int stats_fence_waits = 0;
+    int stats_late_frames = 0;
+    long long stats_drawn_instances = 0;
+    double stats_cull_ms = 0;
+    double stats_occlusion_ms = 0;
+    long long stats_occluded_instances = 0;
+    double stats_gpu_cull_ms = 0;
+    int stats_gpu_cull_frames = 0;
+
+    //the CPU time used by the process and the GPU time of the frames are compared to the time that went by, to show
+    //how busy each of them was (in the title, and over the whole run on exit). The frames that were not drawn in
+    //on-demand mode are counted as well.
+    double stats_cpu_time = GetCpuTime();
+    double stats_gpu_ms = 0;
+    int stats_frames_skipped = 0;
+    double run_start_time = GetTime();
+    double run_cpu_time = stats_cpu_time;
+    double run_gpu_ms = 0;
+    int frames_skipped = 0;
+
+    //the counters above start over each time the title is updated
+    auto resetTitleStats = [&](double time)
+    {
+        stats_start_time = time;
+        stats_cpu_time = GetCpuTime();
+        stats_gpu_ms = 0;
+        stats_frames = 0;
+        stats_frames_skipped = 0;
+        stats_state_calls = 0;
+        stats_gl_issued = 0;
+        stats_gl_skipped = 0;
+        stats_draw_calls = 0;
+        stats_fence_waits = 0;
+        stats_late_frames = 0;
+        stats_drawn_instances = 0;
+        stats_cull_ms = 0;
+        stats_occlusion_ms = 0;
+        stats_occluded_instances = 0;
+        stats_gpu_cull_ms = 0;
+        stats_gpu_cull_frames = 0;
+    };
+
+    //the input is timestamped when it is sampled, when the frame using it has been submitted and when that frame has
+    //been swapped to the screen, so that we can report how long it takes for the input to show up (see RollingStats.h)
+    double last_sample_time = GetTime();
+    RollingStats input_to_submit_ms(INPUT_LATENCY_SAMPLES);
+    RollingStats input_to_swap_ms(INPUT_LATENCY_SAMPLES);
+
+    //start recording the input, or load the recording to replay. When replaying, the time of every frame is kept so
+    //that the frame times of the whole replay can be reported at the end.
+    if(record_path != NULL && StartInputRecording(record_path))
+        std::cout << "Recording the input to " << record_path << std::endl;
+
+    if(replay_path != NULL)
+    {
+        if(!LoadInputRecording(replay_path, replay_frames) || replay_frames.empty())
+            return -1;
 
-    //now that we have our matrices, we should set all of our uniforms
-    setUniforms();
+        std::cout << "Replaying " << replay_frames.size() << " frames from " << replay_path << std::endl;
+        replay_frame = 0;
+    }
 
-    //we need to define two doubles to hold the old and new positions of the mouse cursor so we can check
-    //which direction the user is moving the mouse in.
+    RollingStats replay_frame_ms(std::max((int)replay_frames.size(), 1));
 
-    double oldMouseY = 0;
-    double newMouseY = 0;
+    //the results of the benchmark runs, the last one being the current run. Each run starts with a few warm up frames
+    //that are not measured.
+    std::vector<BenchmarkResult> benchmark_results;
+    int benchmark_frame = 0;
+    if(benchmarking)
+    {
+        benchmark_results.push_back(BenchmarkResult(benchmark_runs[0], getTriangleCount()));
+        benchmark_results.back().threads = GetParallelForThreads();
+    }
 
-    // Loop until the user closes the window
-    while (!glfwWindowShouldClose(window))
+    //the depth of the window is copied into the depth pyramid as is, so it needs to be the size of the framebuffer
+    int framebuffer_width = width;
+    int framebuffer_height = height;
+    if(window != nullptr)
+        glfwGetFramebufferSize(window, &framebuffer_width, &framebuffer_height);
+
+    //the scene is drawn straight into the window (or the headless framebuffer), unless it is drawn at a lower
+    //resolution and upscaled into it. The scale is kept for each frame so that its range can be reported.
+    GLuint output_framebuffer = headless ? headless_framebuffer.framebuffer : 0;
+    RollingStats resolution_scales(FRAME_STATS_SAMPLES);
+    if(resolution_target_ms > 0)
     {
-        // Render here
-        //each time we draw we should clear both the color and the depth buffer bit so that the sorting process can
-        //begin again from scratch
-        //if we don't clear the depth buffer, then on the next frame everything we want to draw will be further than the
-        //last closest item (obviously) and we won't have anything drawn
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        if(!CreateDynamicResolution(dynamic_resolution, framebuffer_width, framebuffer_height, resolution_target_ms))
+            return -1;
 
-        //now we can draw our triangle
-        //to do this we need to tell open GL about our vertex array (id 0)
-        glEnableVertexAttribArray(0);
-        glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+        std::cout << "Lowering the resolution while the GPU takes more than " << resolution_target_ms
+                  << " ms per frame" << std::endl;
+    }
 
-        //we also need to enable the normals array
-        glEnableVertexAttribArray(1);
-        glBindBuffer(GL_ARRAY_BUFFER, normalBuffer);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+    //the frames are paced by the limiter if there is one, and otherwise by the swap when it waits for the display,
+    //whose refresh rate then sets the deadline of each frame
+    double frame_interval = 0;
+    if(frame_rate_limit > 0)
+        frame_interval = 1.0 / frame_rate_limit;
 
-        //this will allow us to access that buffer in GLSL
+    else if(window != nullptr && swap_mode != SWAP_UNCAPPED)
+    {
+        const GLFWvidmode* video_mode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+        if(video_mode != NULL && video_mode->refreshRate > 0)
+            frame_interval = 1.0 / video_mode->refreshRate;
+    }
+
+    StartFramePacer(frame_pacer, frame_interval, frame_rate_limit > 0);
+    SetFrameDeadline(frame_interval * 1000.0);
+
+    //each pass of the frame is timed on the GPU, and the results are read back a few frames later (see GpuTimer.h)
+    InitGpuTimer(TIMESTAMP_COUNT);
+    std::vector<GLuint64> gpu_timestamps;
+
+    //the frames are rendered by this loop, either right here or on a thread of its own (see runRenderThread)
+    int frames_rendered = 0;
+    double last_swap_time = -1;
+    std::function<int()> render_frames = [&]() -> int
+    {
+        // Loop until the user closes the window
+        while (!quit && (window == nullptr || !glfwWindowShouldClose(window)))
+        {
+            //in on-demand mode, nothing is drawn until something needs it: the window keeps showing the last frame, and
+            //we wait for an event (checking the shader files and updating the title now and then)
+            if(on_demand && !frameNeeded(window))
+            {
+                if(window != nullptr)
+                    glfwWaitEventsTimeout(ON_DEMAND_WAIT_INTERVAL);
+
+                else
+                    std::this_thread::sleep_for(std::chrono::milliseconds((int)(ON_DEMAND_WAIT_INTERVAL * 1000)));
+
+                //the time step of the next frame starts from when we stopped waiting, so that nothing jumps
+                last_sample_time = GetTime();
+                if(!frameNeeded(window))
+                {
+                    frames_skipped++;
+                    stats_frames_skipped++;
+
+                    double idle_time = GetTime();
+                    if(idle_time - stats_start_time >= 1.0)
+                    {
+                        char title[512];
+                        double stats_time = idle_time - stats_start_time;
+                        snprintf(title, sizeof(title), "COMP 371 A2 - idle, %d frames drawn and the last one kept %d "
+                                 "times (%.0f%% CPU, %.0f%% GPU)", stats_frames, stats_frames_skipped,
+                                 (GetCpuTime() - stats_cpu_time) / stats_time * 100.0,
+                                 stats_gpu_ms / 10.0 / stats_time);
+                        showTitle(window, title);
+                        resetTitleStats(idle_time);
+                    }
+
+                    if(frame_limit > 0 && frames_rendered + frames_skipped >= frame_limit)
+                        quit = true;
+
+                    //the time spent idle is neither a late frame nor a frame interval, so the next frame is paced as
+                    //if it were the first
+                    frame_pacer.last_end = -1;
+                    last_swap_time = -1;
+                    continue;
+                }
+            }
+
+            redraw_requested = false;
+
+            //with the frame limiter, the frame does not start until it is due
+            double limiter_ms = WaitForFrameStart(frame_pacer);
+            if(frame_pacer.limit)
+                AddFrameSample(METRIC_CPU_LIMITER, limiter_ms);
+
+            //the CPU side of the frame is timed around polling, updating, submitting and swapping
+            double frame_start_time = GetTime();
+            WriteGpuTimestamp(TIMESTAMP_FRAME_START);
+
+            //with dynamic resolution, the scene is drawn into part of a framebuffer of its own
+            GLuint scene_framebuffer = output_framebuffer;
+            int scene_width = framebuffer_width;
+            int scene_height = framebuffer_height;
+            if(resolution_target_ms > 0)
+            {
+                BindDynamicResolution(dynamic_resolution, scene_width, scene_height);
+                scene_framebuffer = dynamic_resolution.scene.framebuffer;
+                AddSample(resolution_scales, GetResolutionScale(dynamic_resolution));
+            }
+
+            // Render here
+            //each time we draw we should clear both the color and the depth buffer bit so that the sorting process
+            //can begin again from scratch
+            //if we don't clear the depth buffer, then on the next frame everything we want to draw will be further
+            //than the last closest item (obviously) and we won't have anything drawn
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            WriteGpuTimestamp(TIMESTAMP_CLEAR_END);
+
+            //hand the shader files that changed on disk over to the variants, which recompile (off of this thread) only
+            //the programs that were built from them
+            ShaderChanges shader_changes;
+            if(TakeShaderChanges(shader_changes))
+            {
+                for(int i = 0; i < shader_changes.files.size(); i++)
+                    std::cout << shader_changes.files[i] << " has changed." << std::endl;
+
+                int recompiling = ReloadShaderFiles(shader_changes.files);
+                std::cout << "Recompiling " << recompiling << " shader program(s)..." << std::endl;
+
+                if(recompiling > 0 && reload_start_time < 0)
+                {
+                    reload_start_time = shader_changes.first_change_time;
+                    reload_visible = false;
+                }
+            }
+
+            //pick up any shader programs that are done compiling (they replace their previous versions in one go, and
+            //only if they linked), and the results of any cost measurements
+            int replaced_programs = UpdateShaderVariants();
+            reportVariantCosts();
+
+            //check if there was input (this includes clicking the close button on the window), and move the camera and
+            //the object according to the keys that are held down. This is done as late as possible before rendering so
+            //that the frame shows the freshest input we can give it.
+            double poll_start_time = GetTime();
+            if(window != nullptr && !render_thread)
+                glfwPollEvents();
+
+            //on a render thread of its own, the input has already been sampled (and waited in the queue since then)
+            double sample_time = GetTime();
+            double input_time = sample_time;
+            if(benchmarking)
+            {
+                const BenchmarkRun& run = benchmark_results.back().run;
+                ApplyCameraPath(render_state, std::max(benchmark_frame - BENCHMARK_WARMUP_FRAMES, 0), run.frames);
+            }
+
+            else if(render_thread && replay_frame < 0)
+                input_time = applyQueuedInput(window);
+
+            else
+                sampleInput(window, (float)(sample_time - last_sample_time));
+
+            last_sample_time = sample_time;
+
+            //the region of the stream buffer for this frame may still be read by the GPU, in which case we have to wait
+            streaming_frame = streaming && streaming_available;
+            if(streaming_frame)
+                BeginStreamFrame(stream_buffer);
+
+            //the instances follow the nodes of the scene graph that moved since the last frame
+            if(object.instance_count > 0)
+                updateSceneInstances();
+
+            //when drawing instances, only the ones inside of the view frustum are put in the instance buffer
+            double cull_ms = 0;
+            double occlusion_ms = 0;
+            double packets_ms = 0;
+            OcclusionStats occlusion = OcclusionStats();
+            if(object.instance_count > 0 && gpu_culling)
+            {
+                //the GPU decides which instances are drawn, and we only find out how many a few frames later
+                GpuCullingStats gpu_culled = GetGpuCullingStats();
+                object.drawn_instance_count = gpu_culled.first_pass + gpu_culled.second_pass;
+            }
+
+            else if(object.instance_count > 0 && (culling || occlusion_culling))
+            {
+                cullInstances(cull_ms, occlusion_ms, occlusion, packets_ms);
+                if(culling)
+                    AddFrameSample(METRIC_CPU_CULL, cull_ms);
+
+                if(occlusion_culling)
+                    AddFrameSample(METRIC_CPU_OCCLUSION, occlusion_ms);
+
+                AddFrameSample(METRIC_CPU_PACKETS, packets_ms);
+
+                stats_cull_ms += cull_ms;
+                stats_occlusion_ms += occlusion_ms;
+                stats_occluded_instances += occlusion.occluded;
+            }
+
+            stats_drawn_instances += object.drawn_instance_count;
+
+            //make sure we are drawing with the shader program for the current lighting model and toggles, and send it
+            //whatever changed in the state of the scene since the last frame
+            int state_calls = selectProgram();
+            int uniform_calls = FlushRenderState(render_state, uniforms);
+            AddIssuedGLCalls(uniform_calls);
+            state_calls += uniform_calls;
+            stats_state_calls += state_calls;
+            stats_frames++;
+
+            //now we can draw our triangle
+            double submit_start_time = GetTime();
+            WriteGpuTimestamp(TIMESTAMP_SCENE_START);
+            if(object.instance_count > 0 && gpu_culling)
+                drawGpuCulledObject(scene_framebuffer, scene_width, scene_height);
+
+            else
+            {
+                WriteGpuTimestamp(TIMESTAMP_FIRST_CULL_END);
+                WriteGpuTimestamp(TIMESTAMP_FIRST_DRAW_END);
+                WriteGpuTimestamp(TIMESTAMP_SECOND_CULL_END);
+                drawObject();
+            }
+
+            WriteGpuTimestamp(TIMESTAMP_SCENE_END);
+
+            if(resolution_target_ms > 0)
+                UpscaleDynamicResolution(dynamic_resolution, output_framebuffer);
+
+            WriteGpuTimestamp(TIMESTAMP_UPSCALE_END);
+            double submit_time = GetTime();
+
+            //the fence that guards the region of this frame goes after its last draw (on some drivers, this is where
+            //the frame is flushed, which is left out of the submit)
+            int fence_waits = 0;
+            if(streaming_frame)
+            {
+                EndStreamFrame(stream_buffer);
+                fence_waits = stream_buffer.waits;
+                AddFrameSample(METRIC_CPU_FENCE_WAIT, stream_buffer.wait_ms);
+                stream_buffer.waits = 0;
+                stream_buffer.wait_ms = 0;
+                streaming_frame = false;
+            }
+
+            stats_fence_waits += fence_waits;
+
+            // Swap front and back buffers
+            //without a window there is nothing to swap, so we wait for the frame to be done rendering instead (which
+            //also keeps the driver from queuing up frames), and then save it if we were asked to
+            if(window != nullptr)
+                glfwSwapBuffers(window);
+
+            else
+                glFinish();
+
+            double swap_time = GetTime();
+
+            //the frame is late if it took longer than the limiter or the display gave it
+            int missed_deadlines = EndPacedFrame(frame_pacer, swap_time);
+            AddFrameDeadlines(missed_deadlines);
+            stats_late_frames += missed_deadlines > 0 ? 1 : 0;
+
+            //the OpenGL calls this frame made to set up state and draw, and the redundant ones the state cache skipped
+            GLCallCounters gl_calls = TakeGLCallCounters();
+            stats_gl_issued += gl_calls.issued;
+            stats_gl_skipped += gl_calls.skipped;
+            stats_draw_calls += gl_calls.draws;
+
+            //the update is everything before the draw that is not polling (reloading shaders, applying the input and
+            //updating the state of the programs)
+            double poll_ms = (sample_time - poll_start_time) * 1000.0;
+            AddFrameSample(METRIC_CPU_POLL, poll_ms);
+            AddFrameSample(METRIC_CPU_UPDATE, (submit_start_time - frame_start_time) * 1000.0 - poll_ms);
+            double submit_ms = (submit_time - submit_start_time) * 1000.0;
+            AddFrameSample(METRIC_CPU_SUBMIT, submit_ms);
+            AddFrameSample(METRIC_CPU_SWAP, (swap_time - submit_time) * 1000.0);
+            AddFrameSample(METRIC_CPU_FRAME, (swap_time - frame_start_time) * 1000.0);
+            AddFrameSample(METRIC_INPUT_LATENCY, (swap_time - input_time) * 1000.0);
+            if(last_swap_time >= 0)
+                AddFrameSample(METRIC_FRAME_INTERVAL, (swap_time - last_swap_time) * 1000.0);
+
+            last_swap_time = swap_time;
+
+            //the GPU timings are those of a frame from a few frames ago, if it is done
+            double gpu_cull_ms = -1;
+            if(EndGpuTimerFrame(gpu_timestamps))
+            {
+                double gpu_clear_ms = (gpu_timestamps[TIMESTAMP_CLEAR_END] - gpu_timestamps[TIMESTAMP_FRAME_START]) /
+                                      1.0e6;
+                double gpu_scene_ms = (gpu_timestamps[TIMESTAMP_SCENE_END] - gpu_timestamps[TIMESTAMP_SCENE_START]) /
+                                      1.0e6;
+                double gpu_upscale_ms = (gpu_timestamps[TIMESTAMP_UPSCALE_END] - gpu_timestamps[TIMESTAMP_SCENE_END]) /
+                                        1.0e6;
+                AddFrameSample(METRIC_GPU_CLEAR, gpu_clear_ms);
+                AddFrameSample(METRIC_GPU_SCENE, gpu_scene_ms);
+                double gpu_frame_ms = (gpu_timestamps[TIMESTAMP_UPSCALE_END] - gpu_timestamps[TIMESTAMP_FRAME_START]) /
+                                      1.0e6;
+                AddFrameSample(METRIC_GPU_FRAME, gpu_frame_ms);
+
+                //the GPU is only busy during the passes, not while it waits for the CPU in between
+                double gpu_busy_ms = gpu_clear_ms + gpu_scene_ms + gpu_upscale_ms;
+                stats_gpu_ms += gpu_busy_ms;
+                run_gpu_ms += gpu_busy_ms;
+
+                //the resolution follows the time the GPU spent on the passes of the frame, upscale included. The
+                //span of the whole frame would also count the time the GPU sat waiting for the CPU to cull, which
+                //drawing fewer pixels does nothing about.
+                if(resolution_target_ms > 0)
+                {
+                    AddFrameSample(METRIC_GPU_UPSCALE, gpu_upscale_ms);
+                    UpdateDynamicResolution(dynamic_resolution, gpu_busy_ms);
+                }
+
+                //the frame is a few frames old, but the culling is only ever switched between benchmark runs
+                if(object.instance_count > 0 && gpu_culling)
+                {
+                    gpu_cull_ms = ((gpu_timestamps[TIMESTAMP_FIRST_CULL_END] - gpu_timestamps[TIMESTAMP_SCENE_START]) +
+                                   (gpu_timestamps[TIMESTAMP_SECOND_CULL_END] -
+                                    gpu_timestamps[TIMESTAMP_FIRST_DRAW_END])) / 1.0e6;
+                    AddFrameSample(METRIC_GPU_CULL, gpu_cull_ms);
+                    stats_gpu_cull_ms += gpu_cull_ms;
+                    stats_gpu_cull_frames++;
+                }
+            }
+
+            if(dump_prefix != NULL)
+            {
+                char dump_path[1024];
+                snprintf(dump_path, sizeof(dump_path), "%s%05d.ppm", dump_prefix, frames_rendered);
+                SaveFramebufferPPM(headless_framebuffer, dump_path);
+            }
+
+            frames_rendered++;
+            if(frame_limit > 0 && frames_rendered + frames_skipped >= frame_limit)
+                quit = true;
+
+            AddSample(input_to_submit_ms, (submit_time - input_time) * 1000.0);
+            AddSample(input_to_swap_ms, (swap_time - input_time) * 1000.0);
+
+            //report how long it took from the shader file changing to the reloaded program being on screen
+            if(reload_start_time >= 0)
+            {
+                if(replaced_programs > 0 && !reload_visible)
+                {
+                    std::cout << "Reloaded shaders visible " << (GetTime() - reload_start_time) * 1000.0
+                              << " ms after the file changed" << std::endl;
+                    reload_visible = true;
+                }
+
+                if(PendingShaderJobs() == 0)
+                {
+                    if(!reload_visible)
+                        std::cout << "Shader reload failed, the previous program(s) are still in use" << std::endl;
+
+                    reload_start_time = -1;
+                }
+            }
+
+            //record how long this frame took if there were compiles going on, and report once they are all done
+            double frame_time = GetTime();
+            double frame_ms = (frame_time - last_frame_time) * 1000.0;
+            last_frame_time = frame_time;
+
+            if(PendingShaderJobs() > 0)
+            {
+                compile_frames++;
+                compile_frame_total_ms += frame_ms;
+                compile_frame_max_ms = std::max(compile_frame_max_ms, frame_ms);
+            }
+
+            else if(compile_frames > 0)
+            {
+                std::cout << compile_frames << " frames rendered while compiling: average "
+                          << compile_frame_total_ms / compile_frames << " ms, max " << compile_frame_max_ms << " ms"
+                          << std::endl;
+                compile_frames = 0;
+                compile_frame_total_ms = 0;
+                compile_frame_max_ms = 0;
+            }
+
+            if(frame_time - stats_start_time >= 1.0)
+            {
+                char title[512];
+                double stats_time = frame_time - stats_start_time;
+                int length = snprintf(title, sizeof(title), "COMP 371 A2 - %.0f fps (%.0f%% CPU, %.0f%% GPU), "
+                                      "%.1f state calls per frame, %.1f GL calls per frame (%.1f skipped, %.1f draws), "
+                                      "input latency p50 %.1f ms p99 %.1f ms (to submit p50 %.1f ms p99 %.1f ms)",
+                                      stats_frames / stats_time, (GetCpuTime() - stats_cpu_time) / stats_time * 100.0,
+                                      stats_gpu_ms / 10.0 / stats_time,
+                                      (double)stats_state_calls / stats_frames, (double)stats_gl_issued / stats_frames,
+                                      (double)stats_gl_skipped / stats_frames, (double)stats_draw_calls / stats_frames,
+                                      GetPercentile(input_to_swap_ms, 50),
+                                      GetPercentile(input_to_swap_ms, 99), GetPercentile(input_to_submit_ms, 50),
+                                      GetPercentile(input_to_submit_ms, 99));
+
+                //when drawing instances, how many of them were drawn (and how long it took to cull the others)
+                if(object.instance_count > 0)
+                    length += snprintf(title + length, sizeof(title) - length, ", %.0f of %d instances drawn",
+                                       (double)stats_drawn_instances / stats_frames, object.instance_count);
+
+                if(object.instance_count > 0 && gpu_culling)
+                    length += snprintf(title + length, sizeof(title) - length, " (culled on the GPU in %.2f ms)",
+                                       stats_gpu_cull_frames > 0 ? stats_gpu_cull_ms / stats_gpu_cull_frames : 0.0);
+
+                else if(object.instance_count > 0 && culling)
+                    length += snprintf(title + length, sizeof(title) - length, " (culled in %.2f ms)",
+                                       stats_cull_ms / stats_frames);
+
+                if(object.instance_count > 0 && occlusion_culling && !gpu_culling)
+                    length += snprintf(title + length, sizeof(title) - length, ", %.0f occluded (in %.2f ms)",
+                                       (double)stats_occluded_instances / stats_frames,
+                                       stats_occlusion_ms / stats_frames);
+
+                if(streaming && streaming_available)
+                    length += snprintf(title + length, sizeof(title) - length, ", %d fence waits", stats_fence_waits);
+
+                if(frame_pacer.interval > 0)
+                    length += snprintf(title + length, sizeof(title) - length, ", %d late frames", stats_late_frames);
+
+                if(resolution_target_ms > 0)
+                    snprintf(title + length, sizeof(title) - length, ", %.0f%% resolution",
+                             GetResolutionScale(dynamic_resolution) * 100.0);
+
+                showTitle(window, title);
+                resetTitleStats(frame_time);
+            }
+
+            //once the last frame of a benchmark run has been measured, we report it and move on to the next run (or
+            //stop and save the results if it was the last one)
+            if(benchmarking)
+            {
+                BenchmarkResult& result = benchmark_results.back();
+                if(benchmark_frame >= BENCHMARK_WARMUP_FRAMES)
+                {
+                    AddSample(result.frame_ms, frame_ms);
+                    result.gl_calls += gl_calls.issued;
+                    result.gl_calls_skipped += gl_calls.skipped;
+                    result.draw_calls += gl_calls.draws;
+                    result.submit_ms += submit_ms;
+                    result.fence_waits += fence_waits;
+                    result.drawn_instances += object.drawn_instance_count;
+                    result.drawn_triangles += getDrawnTriangleCount();
+                    result.cull_ms += cull_ms;
+                    result.packets_ms += packets_ms;
+                    result.occluded_instances += occlusion.occluded;
+                    result.occluders += occlusion.occluders;
+                    result.occlusion_ms += occlusion_ms;
+                    result.occlusion_over_budget_frames += occlusion.over_budget ? 1 : 0;
+                    if(gpu_cull_ms >= 0)
+                    {
+                        result.gpu_cull_ms += gpu_cull_ms;
+                        result.gpu_cull_frames++;
+                    }
+                }
+
+                benchmark_frame++;
+                if(benchmark_frame == BENCHMARK_WARMUP_FRAMES + result.run.frames)
+                {
+                    PrintBenchmarkResult(result);
+
+                    if(benchmark_results.size() == benchmark_runs.size())
+                    {
+                        if(WriteBenchmarkResults(results_path, benchmark_results))
+                            std::cout << "Saved the benchmark results to " << results_path << std::endl;
+
+                        quit = true;
+                    }
+
+                    else
+                    {
+                        const BenchmarkRun& run = benchmark_runs[benchmark_results.size()];
+                        if(!startBenchmarkRun(run))
+                            return -1;
+
+                        benchmark_results.push_back(BenchmarkResult(run, getTriangleCount()));
+                        benchmark_results.back().threads = GetParallelForThreads();
+                        benchmark_frame = 0;
+                    }
+                }
+            }
+
+            //once the last frame of the recording has been replayed, we report how the replay went and stop
+            if(replay_frame >= 0)
+            {
+                AddSample(replay_frame_ms, frame_ms);
+
+                if(replay_frame == replay_frames.size())
+                {
+                    std::cout << "Replayed " << replay_frames.size() << " frames: frame time p50 "
+                              << GetPercentile(replay_frame_ms, 50) << " ms, p99 " << GetPercentile(replay_frame_ms, 99)
+                              << " ms, max " << GetPercentile(replay_frame_ms, 100) << " ms" << std::endl;
+                    std::cout << "Final state hash: " << std::hex << HashRenderState(render_state) << std::dec
+                              << std::endl;
+                    quit = true;
+                }
+            }
+        }
+
+        return 0;
+    };
+
+    int status = render_thread ? runRenderThread(window, render_frames) : render_frames();
+    if(status != 0)
+        return status;
+
+    //the hash of the final state lets us check that replaying the recording ends up in the same state
+    if(record_path != NULL)
+    {
+        std::cout << "Recorded " << StopInputRecording() << " frames to " << record_path << std::endl;
+        std::cout << "Final state hash: " << std::hex << HashRenderState(render_state) << std::dec << std::endl;
+    }
 
-        //this configures the z-buffer so that only elements that are closer will be drawn
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(GL_LESS);
+    PrintFrameStats();
 
-        //here we need to specify the number of vertices we wish to draw
-        //for this assignment, they should be drawn using triangles
-        glDrawArrays(GL_TRIANGLES, 0, vertices.size());
-        glDisableVertexAttribArray(0);
-        glDisableVertexAttribArray(1);
+    double run_time = GetTime() - run_start_time;
+    std::cout << "Utilization over " << run_time << " s: " << (GetCpuTime() - run_cpu_time) / run_time * 100.0
+              << "% CPU, " << run_gpu_ms / 10.0 / run_time << "% GPU (" << frames_rendered << " frames drawn";
+    if(on_demand)
+        std::cout << ", " << frames_skipped << " times the last frame was kept";
 
-        // Swap front and back buffers
-        glfwSwapBuffers(window);
+    std::cout << ")" << std::endl;
 
-        //check if there was input
-        //this includes clicking the close button on the window
-        glfwPollEvents();
+    if(resolution_target_ms > 0)
+        std::cout << "Resolution scale: average " << GetAverage(resolution_scales) << ", p50 "
+                  << GetPercentile(resolution_scales, 50) << ", min " << GetPercentile(resolution_scales, 0) << ", max "
+                  << GetPercentile(resolution_scales, 100) << " (target of " << resolution_target_ms << " ms per frame)"
+                  << std::endl;
 
-        //before dealing with the mouse input, we need to get the current position of the mouse and compare it to
-        //the old. Since we don't care about x, we can just pass 0.
+    if(GetDroppedGpuTimerFrames() > 0)
+        std::cout << GetDroppedGpuTimerFrames() << " frame(s) of GPU timings were dropped because they were not ready "
+                  << "in time" << std::endl;
 
-        glfwGetCursorPos(window, &newMouseY, 0);
+    if(stats_path != NULL && ExportFrameStats(stats_path))
+        std::cout << "Saved the frame timings to " << stats_path << std::endl;
 
-        if(glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS && newMouseY > oldMouseY)
-            key_press_lm_button_up(window, View, Projection, Model, programID);
+    ShutdownGpuTimer();
+    ShutdownGpuCulling();
+    DeleteStreamBuffer(stream_buffer);
+    if(resolution_target_ms > 0)
+        DeleteDynamicResolution(dynamic_resolution);
 
-        if(glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS && newMouseY < oldMouseY)
-            key_press_lm_button_down(window, View, Projection, Model, programID);
+    StopParallelFor();
+    StopShaderWatcher();
+    ShutdownShaderCompiler();
 
-        //update the last position of the mouse
-        oldMouseY = newMouseY;
+    if(headless)
+    {
+        DeleteFramebuffer(headless_framebuffer);
+        DestroyHeadlessContext();
     }
 
-    glfwTerminate();
+    else
+        glfwTerminate();
 
     return 0;
 }
\ No newline at end of file